@@ -88,12 +88,13 @@ namespace ofxCv {
 		void setMaxAreaNorm(float maxAreaNorm);
 		
 		void setSimplify(bool simplify);
+		void setBuildPolylines(bool buildPolylines); // build the ofPolyline copies only once they are asked for, when only the cv::Point contours are used
 		
 		void draw();
 
 	protected:
 		cv::Mat hsvBuffer, thresh;
-		bool autoThreshold, invert, simplify;
+		bool autoThreshold, invert, simplify, buildPolylines;
 		float thresholdValue;
 		
 		bool useTargetColor;
@@ -104,7 +105,11 @@ namespace ofxCv {
 		bool minAreaNorm, maxAreaNorm;
 		
 		vector<vector<cv::Point> > contours;
-		vector<ofPolyline> polylines;
+		mutable vector<ofPolyline> polylines; // built on the first request when they aren't built with the contours
+		mutable bool polylinesBuilt;
+		
+		void resetPolylines(); // called once the contours change
+		void updatePolylines() const;
 		
 		RectTracker tracker;
 		vector<cv::Rect> boundingRects;
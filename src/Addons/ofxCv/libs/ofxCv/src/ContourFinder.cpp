@@ -25,6 +25,8 @@ namespace ofxCv {
 	:autoThreshold(true)
 	,invert(false)
 	,simplify(true)
+	,buildPolylines(true)
+	,polylinesBuilt(true)
 	,thresholdValue(128.)
 	,useTargetColor(false)
 	,contourFindingMode(CV_RETR_EXTERNAL)
@@ -97,15 +99,15 @@ namespace ofxCv {
 			std::sort(allIndices.begin(), allIndices.end(), CompareContourArea(allAreas));
 		}
 
-		// generate polylines and bounding boxes from the contours
+		// generate bounding boxes from the contours, and the polylines unless they are built on demand
 		contours.clear();
-		polylines.clear();
 		boundingRects.clear();
 		for(size_t i = 0; i < allIndices.size(); i++) {
-			contours.push_back(allContours[allIndices[i]]);
-			polylines.push_back(toOf(contours[i]));
+			contours.push_back(vector<cv::Point>());
+			contours.back().swap(allContours[allIndices[i]]);
 			boundingRects.push_back(boundingRect(contours[i]));
 		}
+		resetPolylines();
 		
 		// track bounding boxes
 		tracker.track(boundingRects);
@@ -129,6 +131,7 @@ namespace ofxCv {
 	}
 	
 	const vector<ofPolyline>& ContourFinder::getPolylines() const {
+		updatePolylines();
 		return polylines;
 	}
 	
@@ -145,6 +148,7 @@ namespace ofxCv {
 	}
 	
 	ofPolyline& ContourFinder::getPolyline(unsigned int i) {
+		updatePolylines();
 		return polylines[i];
 	}
 	
@@ -280,7 +284,31 @@ namespace ofxCv {
 		this->simplify = simplify;
 	}
 	
+	void ContourFinder::setBuildPolylines(bool buildPolylines) {
+		this->buildPolylines = buildPolylines;
+	}
+	
+	void ContourFinder::resetPolylines() {
+		polylines.clear();
+		polylinesBuilt = false;
+		if(buildPolylines) {
+			updatePolylines();
+		}
+	}
+	
+	void ContourFinder::updatePolylines() const {
+		if(polylinesBuilt) {
+			return;
+		}
+		polylines.clear();
+		for(size_t i = 0; i < contours.size(); i++) {
+			polylines.push_back(toOf(contours[i]));
+		}
+		polylinesBuilt = true;
+	}
+	
 	void ContourFinder::draw() {
+		updatePolylines();
 		ofPushStyle();
 		ofNoFill();
 		for(int i = 0; i < (int)polylines.size(); i++) {
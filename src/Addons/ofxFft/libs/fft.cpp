@@ -42,8 +42,10 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <mutex>
 
 int **gFFTBitTable = NULL;
+std::once_flag gFFTBitTableFlag;
 const int MaxFastBits = 16;
 
 int IsPowerOfTwo(int x)
@@ -130,8 +132,8 @@ void FFT(int NumSamples,
 		exit(1);
 	}
 	
-	if (!gFFTBitTable)
-		InitFFT();
+	// the tracking stages and the audio run transforms on their own threads
+	std::call_once(gFFTBitTableFlag, InitFFT);
 	
 	if (InverseTransform)
 		angle_numerator = -angle_numerator;
@@ -458,12 +460,16 @@ fft::fft(int fftSize) {
 
 /* destructor */
 fft::~fft() {
-	delete[] in_real, out_real, in_img, out_img;
+	// the buffers are malloc'd for the alignment
+	free(in_real);
+	free(out_real);
+	free(in_img);
+	free(out_img);
 #ifdef __APPLE_CC__
 	vDSP_destroy_fftsetup(setupReal);
-    delete[] A.realp;
-    delete[] A.imagp;
-	delete[] polar;
+    free(A.realp);
+    free(A.imagp);
+	free(polar);
 #endif
 	
 }
@@ -43,6 +43,9 @@
 
 
 
+/* Complex transform of NumSamples (a power of two) points, the inverse is scaled by 1/NumSamples */
+void FFT(int NumSamples, bool InverseTransform, float *RealIn, float *ImagIn, float *RealOut, float *ImagOut);
+
 class fft {
 	
 public:
@@ -92,6 +92,11 @@ void ofxOscSender::sendMessage( ofxOscMessage& message )
 	socket->Send( p.Data(), p.Size() );
 }
 
+void ofxOscSender::sendPacket( const char* data, int size )
+{
+	socket->Send( data, size );
+}
+
 void ofxOscSender::sendParameter( const ofAbstractParameter & parameter){
 	if(!parameter.isSerializable()) return;
 	if(parameter.type()==typeid(ofParameterGroup).name()){
@@ -62,6 +62,8 @@ public:
 	void sendBundle( ofxOscBundle& bundle );
 	/// creates a message using an ofParameter
 	void sendParameter( const ofAbstractParameter & parameter);
+	/// send an already serialised OSC packet
+	void sendPacket( const char* data, int size );
 
 
 private:
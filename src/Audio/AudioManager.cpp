@@ -48,7 +48,10 @@ void AudioManager::setupFFT()
 
 void AudioManager::update()
 {
-    m_fft.update();
+    {
+        ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_AUDIO_FFT);
+        m_fft.update();
+    }
     
     AppManager::getInstance().getOscManager().sendAudioMax(getMaxSound());
     //ofLogNotice() <<"AudioManager::update: " << m_fft.getUnScaledLoudestValue();
@@ -0,0 +1,79 @@
+/*
+ *  AllocationCounter.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+
+// constant initialised before any constructor runs, so the allocations of static objects are counted too
+std::atomic<unsigned long long> AllocationCounter::s_numAllocations(0);
+std::atomic<unsigned long long> AllocationCounter::s_numBytes(0);
+__thread unsigned long long AllocationCounter::s_threadAllocations = 0;
+__thread unsigned long long AllocationCounter::s_threadBytes = 0;
+
+
+//! Counts the allocation and takes the memory from malloc, NULL if there is none
+static inline void* allocate(std::size_t size) noexcept
+{
+    AllocationCounter::count(size);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+//! Counts the allocation and takes the memory from malloc, throws if there is none
+static inline void* allocateOrThrow(std::size_t size)
+{
+    void* memory = allocate(size);
+    if(!memory){
+        throw std::bad_alloc();
+    }
+    
+    return memory;
+}
+
+void* operator new(std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
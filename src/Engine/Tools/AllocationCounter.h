@@ -0,0 +1,92 @@
+/*
+ *  AllocationCounter.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+
+
+//========================== class AllocationCounter ==============================
+//============================================================================
+/** \class AllocationCounter AllocationCounter.h
+ *	\brief Counts the heap allocations of the whole application
+ *	\details The global operator new is replaced by one that counts the allocation
+ *    and its bytes before calling malloc, so the allocations of every thread are
+ *    counted, the containers of the standard library included. Every thread also
+ *    keeps counts of its own, so a stage can tell its allocations from those of the
+ *    threads running next to it. Counting costs two relaxed atomic additions per allocation
+ *    and is always on, so the benchmark measures the same build that runs in the
+ *    installation. OpenCV takes its buffers straight from malloc, so they are not
+ *    counted.
+ */
+
+class AllocationCounter
+{
+
+public:
+
+    //! Returns the number of allocations made through operator new since the application started
+    static unsigned long long getNumAllocations() {return s_numAllocations.load(std::memory_order_relaxed);}
+
+    //! Returns the bytes allocated through operator new since the application started
+    static unsigned long long getNumBytes() {return s_numBytes.load(std::memory_order_relaxed);}
+
+    //! Returns the number of allocations made by the calling thread
+    static unsigned long long getThreadAllocations() {return s_threadAllocations;}
+
+    //! Returns the bytes allocated by the calling thread
+    static unsigned long long getThreadBytes() {return s_threadBytes;}
+
+    //! Counts an allocation of the given bytes, from any thread
+    static void count(size_t size)
+    {
+        s_numAllocations.fetch_add(1, std::memory_order_relaxed);
+        s_numBytes.fetch_add(size, std::memory_order_relaxed);
+        s_threadAllocations++;
+        s_threadBytes += size;
+    }
+
+private:
+
+    static std::atomic<unsigned long long> s_numAllocations;    ///< allocations made through operator new
+    static std::atomic<unsigned long long> s_numBytes;          ///< bytes allocated through operator new
+    static __thread unsigned long long s_threadAllocations; ///< allocations made by the calling thread
+    static __thread unsigned long long s_threadBytes;       ///< bytes allocated by the calling thread
+};
+
+
+//========================== class AllocationScope ==============================
+//============================================================================
+/** \class AllocationScope AllocationCounter.h
+ *	\brief Counts the allocations of the calling thread from its construction on
+ */
+
+class AllocationScope
+{
+
+public:
+
+    //! Constructor, starts counting
+    AllocationScope(): m_startAllocations(AllocationCounter::getThreadAllocations()), m_startBytes(AllocationCounter::getThreadBytes()) {}
+
+    //! Returns the number of allocations made since the construction
+    unsigned int getNumAllocations() const {return AllocationCounter::getThreadAllocations() - m_startAllocations;}
+
+    //! Returns the bytes allocated since the construction
+    unsigned int getNumBytes() const {return AllocationCounter::getThreadBytes() - m_startBytes;}
+
+private:
+
+    unsigned long long      m_startAllocations;     ///< allocations of the thread at the construction
+    unsigned long long      m_startBytes;           ///< bytes allocated by the thread at the construction
+};
+
+//==========================================================================
+
+
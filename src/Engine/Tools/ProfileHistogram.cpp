@@ -0,0 +1,108 @@
+/*
+ *  ProfileHistogram.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ProfileHistogram.h"
+
+
+ProfileHistogram::ProfileHistogram()
+{
+    this->clear();
+}
+
+
+void ProfileHistogram::record(unsigned int value)
+{
+    m_counts[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    
+    // a failed exchange loads the new maximum
+    unsigned int max = m_max.load(std::memory_order_relaxed);
+    while(value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)){
+    }
+}
+
+void ProfileHistogram::moveTo(ProfileHistogram& histogram)
+{
+    // every value is taken away exactly once, whatever is being recorded meanwhile
+    for(int i = 0; i < NUM_BUCKETS; i++) {
+        histogram.m_counts[i].fetch_add(m_counts[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    
+    histogram.m_count.fetch_add(m_count.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    histogram.m_sum.fetch_add(m_sum.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    histogram.m_max.store(max(histogram.getMax(), m_max.exchange(0, std::memory_order_relaxed)), std::memory_order_relaxed);
+}
+
+void ProfileHistogram::add(const ProfileHistogram& histogram)
+{
+    for(int i = 0; i < NUM_BUCKETS; i++) {
+        m_counts[i].fetch_add(histogram.m_counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    
+    m_count.fetch_add(histogram.getCount(), std::memory_order_relaxed);
+    m_sum.fetch_add(histogram.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_max.store(max(this->getMax(), histogram.getMax()), std::memory_order_relaxed);
+}
+
+void ProfileHistogram::clear()
+{
+    for(int i = 0; i < NUM_BUCKETS; i++) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+    
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+unsigned int ProfileHistogram::getPercentile(float percentile) const
+{
+    if(this->getCount() == 0){
+        return 0;
+    }
+    
+    unsigned int rank = ceil(percentile/100*this->getCount());
+    unsigned int count = 0;
+    for(int i = 0; i < NUM_BUCKETS; i++)
+    {
+        count += m_counts[i].load(std::memory_order_relaxed);
+        if(count >= rank){
+            return min(getBucketValue(i), this->getMax());
+        }
+    }
+    
+    return this->getMax();
+}
+
+int ProfileHistogram::getBucket(unsigned int value)
+{
+    if(value < LINEAR_BUCKETS){
+        return value;
+    }
+    
+    // the top SUB_BUCKET_BITS bits below the most significant one pick the bucket within the octave
+    int msb = 31 - __builtin_clz(value);
+    int shift = msb - SUB_BUCKET_BITS;
+    int octave = msb - SUB_BUCKET_BITS - 1;
+    return LINEAR_BUCKETS + octave*(1 << SUB_BUCKET_BITS) + (value >> shift) - (1 << SUB_BUCKET_BITS);
+}
+
+unsigned int ProfileHistogram::getBucketValue(int bucket)
+{
+    if(bucket < LINEAR_BUCKETS){
+        return bucket;
+    }
+    
+    int k = bucket - LINEAR_BUCKETS;
+    int msb = k/(1 << SUB_BUCKET_BITS) + SUB_BUCKET_BITS + 1;
+    int shift = msb - SUB_BUCKET_BITS;
+    unsigned int lowest = (unsigned int) (k%(1 << SUB_BUCKET_BITS) + (1 << SUB_BUCKET_BITS)) << shift;
+    return lowest + ((1u << shift) - 1);
+}
+
@@ -0,0 +1,82 @@
+/*
+ *  ProfileHistogram.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+
+
+//========================== class ProfileHistogram ==============================
+//============================================================================
+/** \class ProfileHistogram ProfileHistogram.h
+ *	\brief Log-linear histogram of durations in microseconds
+ *	\details Like an HDR histogram, values below 32 have a bucket each and every
+ *    octave above is split in 16 buckets, so any percentile is within about 6% of
+ *    the real value. Recording only does relaxed atomic additions, so any thread can
+ *    record while another one takes the counts away to report them. The counts are
+ *    statistics and publish nothing else, so no ordering is needed.
+ */
+
+class ProfileHistogram
+{
+
+public:
+
+    enum {
+        SUB_BUCKET_BITS = 4,                    ///< log2 of the buckets per octave
+        LINEAR_BUCKETS = 2 << SUB_BUCKET_BITS,  ///< values with a bucket each
+        NUM_BUCKETS = LINEAR_BUCKETS + (32 - SUB_BUCKET_BITS - 1)*(1 << SUB_BUCKET_BITS)
+    };
+
+    //! Constructor
+    ProfileHistogram();
+
+    //! Records a duration in microseconds
+    void record(unsigned int value);
+
+    //! Moves all the recorded values into the given histogram, leaving this one empty
+    void moveTo(ProfileHistogram& histogram);
+
+    //! Adds all the values recorded by the given histogram
+    void add(const ProfileHistogram& histogram);
+
+    //! Removes all the recorded values
+    void clear();
+
+    //! Returns the number of values recorded
+    unsigned int getCount() const {return m_count.load(std::memory_order_relaxed);}
+
+    //! Returns the mean of the values recorded
+    double getMean() const {return this->getCount() > 0 ? double(m_sum.load(std::memory_order_relaxed))/this->getCount() : 0;}
+
+    //! Returns the largest value recorded
+    unsigned int getMax() const {return m_max.load(std::memory_order_relaxed);}
+
+    //! Returns the value below which the given percentage of the values fall
+    unsigned int getPercentile(float percentile) const;
+
+private:
+
+    //! Returns the bucket of a value
+    static int getBucket(unsigned int value);
+
+    //! Returns the highest value of a bucket
+    static unsigned int getBucketValue(int bucket);
+
+private:
+
+    std::atomic<unsigned int>       m_counts[NUM_BUCKETS];  ///< number of values recorded in every bucket
+    std::atomic<unsigned int>       m_count;                ///< number of values recorded
+    std::atomic<unsigned long long> m_sum;                  ///< sum of the values recorded
+    std::atomic<unsigned int>       m_max;                  ///< largest value recorded
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,72 @@
+/*
+ *  ThreadSignal.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+
+//========================== class ThreadSignal ==============================
+//============================================================================
+/** \class ThreadSignal ThreadSignal.h
+ *	\brief Wakes a thread waiting for work, like a binary semaphore
+ *	\details A thread with nothing to do waits on the signal instead of polling, and
+ *    whoever gives it work notifies it. A notification made while nobody waits is
+ *    kept until the next wait, so it is never lost between finding nothing to do and
+ *    starting to wait. Waits take a timeout, so a thread also notices it was stopped.
+ */
+
+class ThreadSignal
+{
+
+public:
+
+    static const int MAX_WAIT = 100;    ///< default timeout of a wait, in milliseconds
+
+    //! Constructor
+    ThreadSignal(): m_notified(false) {}
+
+    //! Wakes a waiting thread, or the next one to wait
+    void notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_notified = true;
+        }
+        m_condition.notify_one();
+    }
+
+    //! Waits until notified or until the timeout expires, returns whether it was notified
+    bool wait(int milliseconds = MAX_WAIT)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        bool notified = m_condition.wait_for(lock, std::chrono::milliseconds(milliseconds), [this] {return m_notified;});
+        m_notified = false;
+        return notified;
+    }
+
+    //! Waits until notified or until the given time of the steady clock, returns whether it was notified
+    bool waitUntil(const std::chrono::steady_clock::time_point& time)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        bool notified = m_condition.wait_until(lock, time, [this] {return m_notified;});
+        m_notified = false;
+        return notified;
+    }
+
+private:
+
+    std::mutex                  m_mutex;        ///< protects the notification
+    std::condition_variable     m_condition;    ///< the waiting threads sleep on
+    bool                        m_notified;     ///< whether there was a notification since the last wait
+};
+
+//==========================================================================
+
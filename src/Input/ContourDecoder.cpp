@@ -0,0 +1,122 @@
+/*
+ *  ContourDecoder.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourDecoder.h"
+
+
+const int ContourDecoder::VERSION = 1;
+const int ContourDecoder::HEADER_SIZE = 22;
+const int ContourDecoder::DELTA_ESCAPE = -128;
+const int ContourDecoder::MAX_FRACTIONAL_BITS = 5;
+
+
+bool ContourDecoder::decode(const unsigned char* data, int size, Contour& contour)
+{
+    if(size < HEADER_SIZE || data[0] != VERSION){
+        return false;
+    }
+
+    contour.encoding = data[1];
+    int fractionalBits = data[2];
+    contour.label = readUInt32(data + 4);
+    int numVertices = readUInt16(data + 8);
+    contour.x = readUInt16(data + 10);
+    contour.y = readUInt16(data + 12);
+    contour.width = readUInt16(data + 14);
+    contour.height = readUInt16(data + 16);
+    contour.sensorWidth = readUInt16(data + 18);
+    contour.sensorHeight = readUInt16(data + 20);
+
+    if(fractionalBits > MAX_FRACTIONAL_BITS){
+        return false;
+    }
+
+    // the blob comes from the network, it has to hold the smallest payload of its vertices before they are allocated
+    const unsigned char* p = data + HEADER_SIZE;
+    const unsigned char* end = data + size;
+    int minPayload = 0;
+    if(contour.encoding == QUANTIZED){
+        minPayload = 4*numVertices;
+    }
+    else if(contour.encoding == DELTA){
+        minPayload = numVertices > 0 ? 2*numVertices + 2 : 0;
+    }
+    else{
+        return false;
+    }
+
+    if(end - p < minPayload){
+        return false;
+    }
+
+    float scale = 1.0f/(1 << fractionalBits);
+    contour.vertices.resize(2*numVertices);
+
+    if(contour.encoding == QUANTIZED)
+    {
+        for(int i = 0; i < numVertices; i++, p += 4) {
+            contour.vertices[2*i] = readUInt16(p)*scale;
+            contour.vertices[2*i+1] = readUInt16(p + 2)*scale;
+        }
+        return true;
+    }
+
+    if(contour.encoding == DELTA)
+    {
+        if(numVertices == 0){
+            return true;
+        }
+
+        int x = readUInt16(p);
+        int y = readUInt16(p + 2);
+        p += 4;
+        contour.vertices[0] = x*scale;
+        contour.vertices[1] = y*scale;
+
+        for(int i = 1; i < numVertices; i++)
+        {
+            if(end - p < 2){
+                return false;
+            }
+
+            int dx = (signed char) p[0];
+            if(dx == DELTA_ESCAPE){
+                if(end - p < 5){
+                    return false;
+                }
+                x += readInt16(p + 1);
+                y += readInt16(p + 3);
+                p += 5;
+            }
+            else{
+                x += dx;
+                y += (signed char) p[1];
+                p += 2;
+            }
+
+            contour.vertices[2*i] = x*scale;
+            contour.vertices[2*i+1] = y*scale;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void ContourDecoder::normalize(Contour& contour)
+{
+    if(contour.sensorWidth <= 0 || contour.sensorHeight <= 0){
+        return;
+    }
+
+    for(int i = 0; i + 1 < contour.vertices.size(); i += 2) {
+        contour.vertices[i] /= contour.sensorWidth;
+        contour.vertices[i+1] /= contour.sensorHeight;
+    }
+}
+
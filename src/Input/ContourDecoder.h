@@ -0,0 +1,82 @@
+/*
+ *  ContourDecoder.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+
+//========================== class ContourDecoder ==============================
+//============================================================================
+/** \class ContourDecoder ContourDecoder.h
+ *	\brief Decodes the binary contours sent in /MurmurRenderer/ContourBlob messages
+ *	\details It only depends on the standard library so that it can be dropped into
+ *    the renderer. Every blob holds one contour, big-endian like the rest of OSC:
+ *
+ *      0  uint8   version
+ *      1  uint8   encoding (QUANTIZED or DELTA)
+ *      2  uint8   fractional bits of the vertex coordinates
+ *      3  uint8   reserved
+ *      4  uint32  tracker label
+ *      8  uint16  number of vertices
+ *     10  uint16  bounding box x, y, width, height in sensor pixels
+ *     18  uint16  sensor width, height in pixels
+ *     22  vertices
+ *
+ *    QUANTIZED vertices are uint16 x, y pairs. DELTA sends the first vertex like
+ *    QUANTIZED and then int8 dx, dy pairs from the previous vertex; a dx of -128
+ *    escapes to an int16 dx, dy pair. There are at most MAX_FRACTIONAL_BITS
+ *    fractional bits.
+ */
+
+class ContourDecoder
+{
+
+public:
+
+    enum Encoding {
+        QUANTIZED = 1,
+        DELTA = 2
+    };
+
+    static const int VERSION;
+    static const int HEADER_SIZE;
+    static const int DELTA_ESCAPE;
+    static const int MAX_FRACTIONAL_BITS;
+
+    //! One decoded contour
+    struct Contour
+    {
+        unsigned int        label;          ///< tracker label
+        int                 encoding;       ///< encoding it was sent with
+        float               x, y;           ///< top left corner of the bounding box in sensor pixels
+        float               width, height;  ///< size of the bounding box in sensor pixels
+        int                 sensorWidth;    ///< width of the sensor in pixels
+        int                 sensorHeight;   ///< height of the sensor in pixels
+        std::vector<float>  vertices;       ///< x, y pairs in sensor pixels
+    };
+
+    //! Decodes a blob into the contour, returns false if the blob is malformed. Nothing is allocated before the sizes are checked
+    static bool decode(const unsigned char* data, int size, Contour& contour);
+
+    //! Divides the vertices by the sensor size so that they go from 0 to 1
+    static void normalize(Contour& contour);
+
+    //! Reads a big-endian uint16
+    static unsigned int readUInt16(const unsigned char* data) {return (data[0] << 8) | data[1];}
+
+    //! Reads a big-endian int16
+    static int readInt16(const unsigned char* data) {return short(readUInt16(data));}
+
+    //! Reads a big-endian uint32
+    static unsigned int readUInt32(const unsigned char* data) {return (readUInt16(data) << 16) | readUInt16(data + 2);}
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,90 @@
+/*
+ *  ContourEncoder.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourEncoder.h"
+#include "TrackingManager.h"
+
+
+const int ContourEncoder::MAX_FRACTIONAL_BITS = 5;
+
+
+ContourEncoder::ContourEncoder(): m_encoding(ContourDecoder::DELTA), m_fractionalBits(2)
+{
+    //Intentionally left empty
+}
+
+
+ContourEncoder::~ContourEncoder()
+{
+    //Intentionally left empty
+}
+
+
+const vector<unsigned char>& ContourEncoder::encode(const ContourSet& contours, int i)
+{
+    int numVertices = min(contours.getNumVertices(i), 0xFFFF);
+    const ofVec2f* vertices = contours.getVertices(i);
+    const ofRectangle& boundingBox = contours.getBoundingBox(i);
+
+    m_data.clear();
+    writeUInt8(ContourDecoder::VERSION);
+    writeUInt8(m_encoding);
+    writeUInt8(m_fractionalBits);
+    writeUInt8(0);
+    writeUInt32(contours.getLabel(i));
+    writeUInt16(numVertices);
+    writeUInt16(boundingBox.x);
+    writeUInt16(boundingBox.y);
+    writeUInt16(boundingBox.width);
+    writeUInt16(boundingBox.height);
+    writeUInt16(TrackingManager::DEPTH_CAMERA_WIDTH);
+    writeUInt16(TrackingManager::DEPTH_CAMERA_HEIGHT);
+
+    int maxValue = 0xFFFF;
+    int previousX = 0, previousY = 0;
+    for(int j = 0; j < numVertices; j++)
+    {
+        int x = this->quantize(vertices[j].x, maxValue);
+        int y = this->quantize(vertices[j].y, maxValue);
+
+        if(m_encoding == ContourDecoder::QUANTIZED || j == 0){
+            writeUInt16(x);
+            writeUInt16(y);
+        }
+        else{
+            int dx = x - previousX;
+            int dy = y - previousY;
+            if(dx > ContourDecoder::DELTA_ESCAPE && dx < 128 && dy >= -128 && dy < 128){
+                writeUInt8(dx & 0xFF);
+                writeUInt8(dy & 0xFF);
+            }
+            else{
+                writeUInt8(ContourDecoder::DELTA_ESCAPE & 0xFF);
+                writeUInt16(dx & 0xFFFF);
+                writeUInt16(dy & 0xFFFF);
+            }
+        }
+
+        previousX = x;
+        previousY = y;
+    }
+
+    return m_data;
+}
+
+int ContourEncoder::quantize(float value, int maxValue) const
+{
+    return ofClamp(int(value*(1 << m_fractionalBits) + 0.5f), 0, maxValue);
+}
+
+int ContourEncoder::getVertexSize(int encoding)
+{
+    // deltas of neighbouring contour vertices hardly ever need the escape
+    return encoding == ContourDecoder::DELTA ? 2 : 4;
+}
+
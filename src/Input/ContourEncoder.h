@@ -0,0 +1,70 @@
+/*
+ *  ContourEncoder.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ContourSet.h"
+#include "ContourDecoder.h"
+
+
+//========================== class ContourEncoder ==============================
+//============================================================================
+/** \class ContourEncoder ContourEncoder.h
+ *	\brief Packs a contour into a compact binary blob
+ *	\details Vertices are quantized to fixed point sensor coordinates, either as
+ *    absolute uint16 pairs (4 bytes per vertex) or as int8 deltas from the previous
+ *    vertex (2 bytes per vertex). The format is described in ContourDecoder.h.
+ */
+
+class ContourEncoder
+{
+
+public:
+
+    static const int MAX_FRACTIONAL_BITS;
+
+    //! Constructor
+    ContourEncoder();
+
+    //! Destructor
+    ~ContourEncoder();
+
+    //! Set the encoding, ContourDecoder::QUANTIZED or ContourDecoder::DELTA
+    void setEncoding(int encoding) {m_encoding = encoding;}
+
+    //! Set the number of fractional bits of the vertex coordinates
+    void setFractionalBits(int fractionalBits) {m_fractionalBits = ofClamp(fractionalBits, 0, MAX_FRACTIONAL_BITS);}
+
+    //! Encodes the given contour, the blob stays valid until the next call
+    const vector<unsigned char>& encode(const ContourSet& contours, int i);
+
+    //! Returns the average number of bytes of a vertex with the given encoding
+    static int getVertexSize(int encoding);
+
+private:
+
+    void writeUInt8(unsigned int value) {m_data.push_back(value);}
+
+    void writeUInt16(unsigned int value) {m_data.push_back(value >> 8); m_data.push_back(value);}
+
+    void writeUInt32(unsigned int value) {this->writeUInt16(value >> 16); this->writeUInt16(value);}
+
+    //! Converts a sensor coordinate to fixed point
+    int quantize(float value, int maxValue) const;
+
+private:
+
+    int                     m_encoding;         ///< encoding of the vertices
+    int                     m_fractionalBits;   ///< fractional bits of the vertex coordinates
+    vector<unsigned char>   m_data;             ///< encoded blob, reused between contours
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,78 @@
+/*
+ *  ContourReassembler.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourReassembler.h"
+
+
+const double ContourReassembler::DEFAULT_TIMEOUT = 0.5;
+
+
+ContourReassembler::ContourReassembler(): m_timeout(DEFAULT_TIMEOUT), m_numDropped(0)
+{
+    //Intentionally left empty
+}
+
+
+bool ContourReassembler::addFragment(int frameId, unsigned int label, int index, int count, const unsigned char* data, int size, double time)
+{
+    if(count <= 0 || index < 0 || index >= count || size < 0){
+        return false;
+    }
+
+    this->removeExpired(time);
+
+    Key key(frameId, label);
+    FragmentMap::iterator it = m_fragments.find(key);
+    if(it == m_fragments.end())
+    {
+        Fragments& fragments = m_fragments[key];
+        fragments.time = time;
+        fragments.received = 0;
+        fragments.data.resize(count);
+        fragments.done.assign(count, false);
+        it = m_fragments.find(key);
+    }
+
+    Fragments& fragments = it->second;
+    if(fragments.data.size() != count){
+        return false;
+    }
+
+    if(!fragments.done[index]){
+        fragments.data[index].assign(data, data + size);
+        fragments.done[index] = true;
+        fragments.received++;
+    }
+
+    if(fragments.received < count){
+        return false;
+    }
+
+    m_message.clear();
+    for(int i = 0; i < count; i++) {
+        m_message.insert(m_message.end(), fragments.data[i].begin(), fragments.data[i].end());
+    }
+
+    m_fragments.erase(it);
+    return true;
+}
+
+void ContourReassembler::removeExpired(double time)
+{
+    FragmentMap::iterator it = m_fragments.begin();
+    while(it != m_fragments.end())
+    {
+        if(time - it->second.time > m_timeout){
+            m_fragments.erase(it++);
+            m_numDropped++;
+        }
+        else{
+            ++it;
+        }
+    }
+}
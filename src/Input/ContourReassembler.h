@@ -0,0 +1,80 @@
+/*
+ *  ContourReassembler.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+
+//========================== class ContourReassembler ==============================
+//============================================================================
+/** \class ContourReassembler ContourReassembler.h
+ *	\brief Puts back together the contours sent in /MurmurRenderer/ContourFragment messages
+ *	\details It only depends on the standard library so that it can be dropped into
+ *    the renderer. A contour message that doesn't fit in a packet is serialised and
+ *    split into numbered fragments, each one sent as
+ *
+ *      /MurmurRenderer/ContourFragment ,iiiib frameId label index count data
+ *
+ *    Once all the fragments of a contour have arrived, the data is the original OSC
+ *    message, which can be parsed with osc::ReceivedMessage(osc::ReceivedPacket(data, size)).
+ *    Contours that are still incomplete after the timeout are dropped.
+ */
+
+class ContourReassembler
+{
+
+public:
+
+    static const double DEFAULT_TIMEOUT;
+
+    //! Constructor
+    ContourReassembler();
+
+    //! Sets the time in seconds after which incomplete contours are dropped
+    void setTimeout(double timeout) {m_timeout = timeout;}
+
+    //! Adds a fragment received at the given time in seconds, returns true when it completes its contour
+    bool addFragment(int frameId, unsigned int label, int index, int count, const unsigned char* data, int size, double time);
+
+    //! Returns the OSC message completed by the last call to addFragment
+    const std::vector<unsigned char>& getMessage() const {return m_message;}
+
+    //! Drops the contours that are still incomplete after the timeout
+    void removeExpired(double time);
+
+    //! Returns the number of contours dropped because they never completed
+    int getNumDropped() const {return m_numDropped;}
+
+    //! Forgets all the incomplete contours
+    void clear() {m_fragments.clear();}
+
+private:
+
+    //! Fragments received so far of one contour
+    struct Fragments
+    {
+        double                                  time;       ///< time the first fragment arrived
+        int                                     received;   ///< number of different fragments received
+        std::vector<std::vector<unsigned char> > data;      ///< payload of every fragment
+        std::vector<bool>                       done;       ///< whether every fragment has arrived
+    };
+
+    typedef std::pair<int, unsigned int>            Key;            ///< frame id and label
+    typedef std::map<Key, Fragments>                FragmentMap;
+
+    FragmentMap                 m_fragments;    ///< contours being put together
+    std::vector<unsigned char>  m_message;      ///< last completed message
+    double                      m_timeout;      ///< seconds after which incomplete contours are dropped
+    int                         m_numDropped;   ///< number of contours dropped
+};
+
+//==========================================================================
+
+
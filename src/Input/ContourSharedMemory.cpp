@@ -0,0 +1,161 @@
+/*
+ *  ContourSharedMemory.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourSharedMemory.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+const char* ContourSharedMemory::DEFAULT_NAME = "/MurmurContours";
+const uint32_t ContourSharedMemory::MAGIC = 0x4D524D43; // "MRMC"
+const uint32_t ContourSharedMemory::VERSION = 1;
+const uint32_t ContourSharedMemory::NUM_SLOTS = 3;
+const uint32_t ContourSharedMemory::MAX_CONTOURS = 64;
+const uint32_t ContourSharedMemory::MAX_VERTICES = 32768;
+
+
+size_t ContourSharedMemory::getSlotSize(uint32_t maxContours, uint32_t maxVertices)
+{
+    // rounded up to a cache line, which also keeps the 64 bit fields of every slot aligned
+    return (getFrameSize(maxContours, maxVertices) + 63) & ~size_t(63);
+}
+
+size_t ContourSharedMemory::getSize(uint32_t numSlots, uint32_t maxContours, uint32_t maxVertices)
+{
+    return sizeof(Header) + numSlots*getSlotSize(maxContours, maxVertices);
+}
+
+size_t ContourSharedMemory::getFrameSize(uint32_t maxContours, uint32_t numVertices)
+{
+    return sizeof(FrameHeader) + (2*maxContours + 1)*sizeof(uint32_t) + 4*maxContours*sizeof(float) + 2*numVertices*sizeof(float);
+}
+
+
+ContourSharedMemory::ContourSharedMemory(): m_header(NULL), m_size(0), m_lastFrame(0), m_copy(NULL)
+{
+    //Intentionally left empty
+}
+
+
+ContourSharedMemory::~ContourSharedMemory()
+{
+    this->close();
+}
+
+
+bool ContourSharedMemory::open(const char* name)
+{
+    this->close();
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if(fd < 0){
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) < 0 || info.st_size < (off_t) sizeof(Header)){
+        ::close(fd);
+        return false;
+    }
+
+    void* memory = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(memory == MAP_FAILED){
+        return false;
+    }
+
+    Header* header = (Header*) memory;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(header->magic != MAGIC || header->version != VERSION ||
+       getSize(header->numSlots, header->maxContours, header->maxVertices) > (size_t) info.st_size){
+        munmap(memory, info.st_size);
+        return false;
+    }
+
+    m_header = header;
+    m_size = info.st_size;
+    m_lastFrame = 0;
+    m_copy = new unsigned char[m_header->slotSize];
+    return true;
+}
+
+void ContourSharedMemory::close()
+{
+    if(!m_header){
+        return;
+    }
+
+    munmap(m_header, m_size);
+    delete[] m_copy;
+    m_header = NULL;
+    m_size = 0;
+    m_copy = NULL;
+}
+
+bool ContourSharedMemory::readLatest(Frame& frame)
+{
+    if(!m_header || m_header->latestFrame.load(std::memory_order_relaxed) == m_lastFrame){
+        return false;
+    }
+
+    uint32_t sequence;
+    Frame latest = this->beginRead(sequence);
+    if(!latest.isValid()){
+        return false;
+    }
+
+    // the vertex count may be torn, so it is clamped before sizing the copy
+    uint32_t numVertices = latest.getHeader().numVertices;
+    if(numVertices > m_header->maxVertices){
+        numVertices = m_header->maxVertices;
+    }
+
+    memcpy(m_copy, &latest.getHeader(), getFrameSize(m_header->maxContours, numVertices));
+
+    if(!this->endRead(latest, sequence)){
+        return false;
+    }
+
+    frame = Frame((const FrameHeader*) m_copy, m_header->maxContours);
+    m_lastFrame = frame.getHeader().frameId;
+    return true;
+}
+
+ContourSharedMemory::Frame ContourSharedMemory::beginRead(uint32_t& sequence) const
+{
+    if(!m_header){
+        return Frame();
+    }
+
+    uint32_t frameId = m_header->latestFrame.load(std::memory_order_acquire);
+    if(frameId == 0){
+        return Frame();
+    }
+
+    const unsigned char* slot = (const unsigned char*) (m_header + 1) + (frameId % m_header->numSlots)*m_header->slotSize;
+    const FrameHeader* header = (const FrameHeader*) slot;
+
+    // pairs with the release of the writer closing the slot, so the frame read matches the sequence
+    sequence = header->sequence.load(std::memory_order_acquire);
+    if(sequence & 1){
+        return Frame();
+    }
+
+    return Frame(header, m_header->maxContours);
+}
+
+bool ContourSharedMemory::endRead(const Frame& frame, uint32_t sequence) const
+{
+    // the frame is read before the sequence is checked again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return frame.isValid() && frame.getHeader().sequence.load(std::memory_order_relaxed) == sequence;
+}
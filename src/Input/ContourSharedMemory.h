@@ -0,0 +1,162 @@
+/*
+ *  ContourSharedMemory.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+
+//========================== class ContourSharedMemory ==============================
+//============================================================================
+/** \class ContourSharedMemory ContourSharedMemory.h
+ *	\brief Layout of the POSIX shared memory the contours are published in, and its reader
+ *	\details It only depends on the standard library and POSIX so that it can be
+ *    dropped into a renderer running on the same machine. The memory starts with a
+ *    Header followed by NUM_SLOTS frame slots; the frame with id n is written to slot
+ *    n % NUM_SLOTS, so a reader has NUM_SLOTS - 1 frames of time to use a frame before
+ *    it is overwritten. Every slot holds a FrameHeader followed by
+ *
+ *      uint32  label of every contour                      [maxContours]
+ *      uint32  index of the first vertex of every contour  [maxContours + 1]
+ *      float   bounding box x, y, width, height            [4*maxContours]
+ *      float   vertex x, y in sensor pixels                [2*maxVertices]
+ *
+ *    Slots are protected by a seqlock: the sequence is odd while the writer is in the
+ *    slot, and a read is valid if the sequence was even and didn't change while reading.
+ *    The sequence and the latest frame are lock-free 32-bit atomics, laid out like a
+ *    uint32 so that readers in other processes see the same memory.
+ *    readLatest() copies the frame with a single memcpy; beginRead() and endRead() let
+ *    the renderer use it in place and check afterwards that it wasn't overwritten.
+ */
+
+class ContourSharedMemory
+{
+
+public:
+
+    static const char*      DEFAULT_NAME;
+    static const uint32_t   MAGIC;
+    static const uint32_t   VERSION;
+    static const uint32_t   NUM_SLOTS;
+    static const uint32_t   MAX_CONTOURS;
+    static const uint32_t   MAX_VERTICES;
+
+    //! Beginning of the shared memory
+    struct Header
+    {
+        uint32_t            magic;          ///< MAGIC once the memory is initialised
+        uint32_t            version;        ///< VERSION of the layout
+        uint32_t            numSlots;       ///< number of frame slots
+        uint32_t            slotSize;       ///< bytes of every slot
+        uint32_t            maxContours;    ///< number of contours a slot can hold
+        uint32_t            maxVertices;    ///< number of vertices a slot can hold
+        std::atomic<uint32_t> latestFrame;  ///< id of the last complete frame, 0 before the first one
+        uint32_t            reserved;
+    };
+
+    //! Beginning of every slot
+    struct FrameHeader
+    {
+        std::atomic<uint32_t> sequence;     ///< seqlock sequence, odd while the frame is being written
+        uint32_t            frameId;        ///< id of the frame, increasing from 1
+        uint64_t            timestamp;      ///< capture time in microseconds since the epoch
+        uint64_t            writeTime;      ///< time the frame was published in microseconds since the epoch
+        uint32_t            numContours;    ///< number of contours of the frame
+        uint32_t            numVertices;    ///< number of vertices of all the contours
+        uint32_t            sensorWidth;    ///< width of the sensor in pixels
+        uint32_t            sensorHeight;   ///< height of the sensor in pixels
+        uint32_t            reserved[2];
+    };
+
+    //! Accessors of a frame, either in the shared memory or in a copy of it
+    class Frame
+    {
+    public:
+
+        Frame(): m_header(NULL), m_maxContours(0) {}
+
+        Frame(const FrameHeader* header, uint32_t maxContours): m_header(header), m_maxContours(maxContours) {}
+
+        //! Returns whether the frame points to any data
+        bool isValid() const {return m_header != NULL;}
+
+        //! Returns the header of the frame
+        const FrameHeader& getHeader() const {return *m_header;}
+
+        //! Returns the number of contours
+        int size() const {return m_header->numContours;}
+
+        //! Returns the tracker label of the given contour
+        uint32_t getLabel(int i) const {return getLabels()[i];}
+
+        //! Returns the number of vertices of the given contour
+        int getNumVertices(int i) const {return getOffsets()[i+1] - getOffsets()[i];}
+
+        //! Returns the x, y pairs of the given contour in sensor pixels
+        const float* getVertices(int i) const {return getVertexData() + 2*getOffsets()[i];}
+
+        //! Returns the x, y, width and height of the bounding box of the given contour in sensor pixels
+        const float* getBoundingBox(int i) const {return getBoundingBoxes() + 4*i;}
+
+    private:
+
+        const uint32_t* getLabels() const {return (const uint32_t*) (m_header + 1);}
+        const uint32_t* getOffsets() const {return getLabels() + m_maxContours;}
+        const float* getBoundingBoxes() const {return (const float*) (getOffsets() + m_maxContours + 1);}
+        const float* getVertexData() const {return getBoundingBoxes() + 4*m_maxContours;}
+
+        const FrameHeader*  m_header;
+        uint32_t            m_maxContours;
+    };
+
+    //! Returns the bytes of a slot able to hold the given number of contours and vertices
+    static size_t getSlotSize(uint32_t maxContours, uint32_t maxVertices);
+
+    //! Returns the bytes of the shared memory
+    static size_t getSize(uint32_t numSlots, uint32_t maxContours, uint32_t maxVertices);
+
+    //! Returns the bytes of a slot that are in use by the frame
+    static size_t getFrameSize(uint32_t maxContours, uint32_t numVertices);
+
+    //! Constructor
+    ContourSharedMemory();
+
+    //! Destructor
+    ~ContourSharedMemory();
+
+    //! Maps the shared memory published by the tracker, returns false if it doesn't exist yet
+    bool open(const char* name = DEFAULT_NAME);
+
+    //! Unmaps the shared memory
+    void close();
+
+    //! Returns whether the shared memory is mapped
+    bool isOpen() const {return m_header != NULL;}
+
+    //! Copies the latest frame if it is newer than the last one read, returns false otherwise or if it was overwritten
+    bool readLatest(Frame& frame);
+
+    //! Returns the latest frame in place, to be checked with endRead() once it has been used
+    Frame beginRead(uint32_t& sequence) const;
+
+    //! Returns whether the frame returned by beginRead() was left untouched while it was being used
+    bool endRead(const Frame& frame, uint32_t sequence) const;
+
+private:
+
+    Header*         m_header;       ///< mapped shared memory
+    size_t          m_size;         ///< bytes mapped
+    uint32_t        m_lastFrame;    ///< id of the last frame copied by readLatest()
+    unsigned char*  m_copy;         ///< buffer the frames are copied into
+};
+
+//==========================================================================
+
+
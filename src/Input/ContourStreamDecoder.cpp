@@ -0,0 +1,178 @@
+/*
+ *  ContourStreamDecoder.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourStreamDecoder.h"
+#include "ContourDecoder.h"
+
+
+const int ContourStreamDecoder::VERSION = 1;
+const int ContourStreamDecoder::HEADER_SIZE = 30;
+
+
+ContourStreamDecoder::ContourStreamDecoder(): m_resyncNeeded(false)
+{
+    //Intentionally left empty
+}
+
+
+bool ContourStreamDecoder::decode(const unsigned char* data, int size, Contour& contour)
+{
+    if(size < HEADER_SIZE || data[0] != VERSION){
+        return false;
+    }
+
+    int type = data[1];
+    int fractionalBits = data[2];
+    unsigned int sequence = ContourDecoder::readUInt32(data + 4);
+    unsigned int baseSequence = ContourDecoder::readUInt32(data + 8);
+    unsigned int label = ContourDecoder::readUInt32(data + 12);
+    int numVertices = ContourDecoder::readUInt16(data + 16);
+
+    if(fractionalBits > ContourDecoder::MAX_FRACTIONAL_BITS){
+        return false;
+    }
+
+    const unsigned char* p = data + HEADER_SIZE;
+    const unsigned char* end = data + size;
+
+    if(type == KEYFRAME)
+    {
+        // the first vertex takes 4 bytes and every other one at least 2, checked before they are allocated
+        if(numVertices > 0 && end - p < 2*numVertices + 2){
+            return false;
+        }
+
+        State state;
+        state.sequence = sequence;
+        state.vertices.resize(2*numVertices);
+
+        int x = 0, y = 0;
+        for(int i = 0; i < numVertices; i++)
+        {
+            if(end - p < 2 || (i == 0 && end - p < 4)){
+                return false;
+            }
+
+            int dx = (signed char) p[0];
+            if(i == 0){
+                x = ContourDecoder::readUInt16(p);
+                y = ContourDecoder::readUInt16(p + 2);
+                p += 4;
+            }
+            else if(dx == ContourDecoder::DELTA_ESCAPE){
+                if(end - p < 5){
+                    return false;
+                }
+                x += ContourDecoder::readInt16(p + 1);
+                y += ContourDecoder::readInt16(p + 3);
+                p += 5;
+            }
+            else{
+                x += dx;
+                y += (signed char) p[1];
+                p += 2;
+            }
+
+            state.vertices[2*i] = x;
+            state.vertices[2*i+1] = y;
+        }
+
+        m_states[label].sequence = sequence;
+        m_states[label].vertices.swap(state.vertices);
+    }
+    else if(type == DELTA_FRAME)
+    {
+        StateMap::iterator it = m_states.find(label);
+        if(it == m_states.end() || it->second.sequence != baseSequence || it->second.vertices.size() != 2*numVertices){
+            m_resyncNeeded = true;
+            return false;
+        }
+
+        if(end - p < 2){
+            return false;
+        }
+
+        // validate the whole delta before touching the stored contour
+        int numChanged = ContourDecoder::readUInt16(p);
+        const unsigned char* q = p + 2;
+        for(int i = 0; i < numChanged; i++)
+        {
+            if(end - q < 4 || ContourDecoder::readUInt16(q) >= numVertices){
+                return false;
+            }
+            q += ((signed char) q[2] == ContourDecoder::DELTA_ESCAPE) ? 7 : 4;
+            if(q > end){
+                return false;
+            }
+        }
+
+        std::vector<int>& vertices = it->second.vertices;
+        p += 2;
+        for(int i = 0; i < numChanged; i++)
+        {
+            int index = ContourDecoder::readUInt16(p);
+            int dx = (signed char) p[2];
+            if(dx == ContourDecoder::DELTA_ESCAPE){
+                vertices[2*index] += ContourDecoder::readInt16(p + 3);
+                vertices[2*index+1] += ContourDecoder::readInt16(p + 5);
+                p += 7;
+            }
+            else{
+                vertices[2*index] += dx;
+                vertices[2*index+1] += (signed char) p[3];
+                p += 4;
+            }
+        }
+
+        it->second.sequence = sequence;
+    }
+    else{
+        return false;
+    }
+
+    contour.label = label;
+    contour.sequence = sequence;
+    contour.keyframe = (type == KEYFRAME);
+    contour.x = ContourDecoder::readUInt16(data + 18);
+    contour.y = ContourDecoder::readUInt16(data + 20);
+    contour.width = ContourDecoder::readUInt16(data + 22);
+    contour.height = ContourDecoder::readUInt16(data + 24);
+    contour.sensorWidth = ContourDecoder::readUInt16(data + 26);
+    contour.sensorHeight = ContourDecoder::readUInt16(data + 28);
+
+    const std::vector<int>& vertices = m_states[label].vertices;
+    float scale = 1.0f/(1 << fractionalBits);
+    contour.vertices.resize(vertices.size());
+    for(int i = 0; i < vertices.size(); i++) {
+        contour.vertices[i] = vertices[i]*scale;
+    }
+
+    return true;
+}
+
+void ContourStreamDecoder::removeStale(unsigned int sequence, unsigned int maxAge)
+{
+    StateMap::iterator it = m_states.begin();
+    while(it != m_states.end())
+    {
+        if(sequence - it->second.sequence > maxAge){
+            m_states.erase(it++);
+        }
+        else{
+            ++it;
+        }
+    }
+}
+
+bool ContourStreamDecoder::isResyncNeeded()
+{
+    bool resyncNeeded = m_resyncNeeded;
+    m_resyncNeeded = false;
+    return resyncNeeded;
+}
+
@@ -0,0 +1,102 @@
+/*
+ *  ContourStreamDecoder.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+
+//========================== class ContourStreamDecoder ==============================
+//============================================================================
+/** \class ContourStreamDecoder ContourStreamDecoder.h
+ *	\brief Decodes the temporal contour stream sent in /MurmurRenderer/ContourStream messages
+ *	\details It only depends on the standard library so that it can be dropped into
+ *    the renderer. It keeps the last contour of every label and applies the deltas on
+ *    top of it. Every blob holds one contour, big-endian like the rest of OSC:
+ *
+ *      0  uint8   version
+ *      1  uint8   type (KEYFRAME or DELTA_FRAME)
+ *      2  uint8   fractional bits of the vertex coordinates
+ *      3  uint8   reserved
+ *      4  uint32  frame sequence number
+ *      8  uint32  sequence number of the frame the delta applies to
+ *     12  uint32  tracker label
+ *     16  uint16  number of vertices
+ *     18  uint16  bounding box x, y, width, height in sensor pixels
+ *     26  uint16  sensor width, height in pixels
+ *     30  payload
+ *
+ *    A KEYFRAME payload holds the vertices like ContourDecoder::DELTA. A DELTA_FRAME
+ *    payload is a uint16 count of moved vertices followed, for each one, by its uint16
+ *    index and its int8 dx, dy from the previous position; a dx of -128 escapes to an
+ *    int16 dx, dy pair. A delta whose base sequence doesn't match the stored contour
+ *    can't be applied: the label waits for its next keyframe, which the renderer can
+ *    ask for with /MurmurContourTracking/RequestKeyframe. There are at most
+ *    ContourDecoder::MAX_FRACTIONAL_BITS fractional bits.
+ */
+
+class ContourStreamDecoder
+{
+
+public:
+
+    enum Type {
+        KEYFRAME = 3,
+        DELTA_FRAME = 4
+    };
+
+    static const int VERSION;
+    static const int HEADER_SIZE;
+
+    //! One decoded contour
+    struct Contour
+    {
+        unsigned int        label;          ///< tracker label
+        unsigned int        sequence;       ///< sequence number of the frame
+        bool                keyframe;       ///< whether it was sent as a keyframe
+        float               x, y;           ///< top left corner of the bounding box in sensor pixels
+        float               width, height;  ///< size of the bounding box in sensor pixels
+        int                 sensorWidth;    ///< width of the sensor in pixels
+        int                 sensorHeight;   ///< height of the sensor in pixels
+        std::vector<float>  vertices;       ///< x, y pairs in sensor pixels
+    };
+
+    //! Constructor
+    ContourStreamDecoder();
+
+    //! Decodes a blob into the contour, returns false if it is malformed or can't be applied yet
+    bool decode(const unsigned char* data, int size, Contour& contour);
+
+    //! Forgets the labels that haven't been updated in the last frames
+    void removeStale(unsigned int sequence, unsigned int maxAge);
+
+    //! Forgets all the labels
+    void clear() {m_states.clear();}
+
+    //! Returns whether a delta was dropped since the last call, so a keyframe should be requested
+    bool isResyncNeeded();
+
+private:
+
+    //! Last contour of a label, in fixed point
+    struct State
+    {
+        unsigned int        sequence;   ///< sequence number of the last update
+        std::vector<int>    vertices;   ///< x, y pairs in fixed point
+    };
+
+    typedef std::map<unsigned int, State> StateMap;
+
+    StateMap    m_states;           ///< last contour of every label
+    bool        m_resyncNeeded;     ///< whether a delta was dropped
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,242 @@
+/*
+ *  ContourStreamEncoder.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourStreamEncoder.h"
+#include "ContourDecoder.h"
+#include "ContourSimplifier.h"
+#include "TrackingManager.h"
+
+
+ContourStreamEncoder::ContourStreamEncoder(): m_sequence(0), m_keyframeInterval(30), m_tolerance(0.5),
+    m_fractionalBits(2), m_keyframeRequested(false), m_keyframeFrame(false)
+{
+    //Intentionally left empty
+}
+
+
+ContourStreamEncoder::~ContourStreamEncoder()
+{
+    //Intentionally left empty
+}
+
+
+void ContourStreamEncoder::beginFrame(const ContourSet& contours)
+{
+    m_sequence++;
+    m_keyframeFrame = m_keyframeRequested;
+    m_keyframeRequested = false;
+
+    m_labels.clear();
+    for(int i = 0; i < contours.size(); i++) {
+        m_labels.push_back(contours.getLabel(i));
+    }
+    std::sort(m_labels.begin(), m_labels.end());
+
+    // a label that comes back after disappearing starts again with a keyframe
+    StateMap::iterator it = m_states.begin();
+    while(it != m_states.end())
+    {
+        if(!std::binary_search(m_labels.begin(), m_labels.end(), it->first)){
+            m_states.erase(it++);
+        }
+        else{
+            ++it;
+        }
+    }
+}
+
+const vector<unsigned char>& ContourStreamEncoder::encode(const ContourSet& contours, int i)
+{
+    StateMap::iterator it = m_states.find(contours.getLabel(i));
+    if(it == m_states.end()){
+        it = m_states.insert(std::make_pair(contours.getLabel(i), State())).first;
+        this->encodeKeyframe(contours, i, it->second);
+        return m_data;
+    }
+
+    State& state = it->second;
+    int numVertices = contours.getNumVertices(i);
+    int numStored = state.vertices.size()/2;
+
+    bool keyframe = m_keyframeFrame || m_sequence - state.keyframeSequence >= m_keyframeInterval;
+
+    // the correspondence degrades when the outline gains or loses too many vertices
+    keyframe = keyframe || numStored < ContourSimplifier::MIN_VERTICES || abs(numVertices - numStored)*4 > numStored;
+
+    if(keyframe || !this->encodeDelta(contours, i, state)){
+        this->encodeKeyframe(contours, i, state);
+    }
+
+    return m_data;
+}
+
+void ContourStreamEncoder::writeHeader(int type, const ContourSet& contours, int i, unsigned int baseSequence, int numVertices)
+{
+    const ofRectangle& boundingBox = contours.getBoundingBox(i);
+
+    m_data.clear();
+    writeUInt8(ContourStreamDecoder::VERSION);
+    writeUInt8(type);
+    writeUInt8(m_fractionalBits);
+    writeUInt8(0);
+    writeUInt32(m_sequence);
+    writeUInt32(baseSequence);
+    writeUInt32(contours.getLabel(i));
+    writeUInt16(numVertices);
+    writeUInt16(boundingBox.x);
+    writeUInt16(boundingBox.y);
+    writeUInt16(boundingBox.width);
+    writeUInt16(boundingBox.height);
+    writeUInt16(TrackingManager::DEPTH_CAMERA_WIDTH);
+    writeUInt16(TrackingManager::DEPTH_CAMERA_HEIGHT);
+}
+
+void ContourStreamEncoder::encodeKeyframe(const ContourSet& contours, int i, State& state)
+{
+    int numVertices = min(contours.getNumVertices(i), 0xFFFF);
+    const ofVec2f* vertices = contours.getVertices(i);
+
+    this->writeHeader(ContourStreamDecoder::KEYFRAME, contours, i, m_sequence, numVertices);
+
+    state.vertices.resize(2*numVertices);
+    for(int j = 0; j < numVertices; j++)
+    {
+        int x = this->quantize(vertices[j].x);
+        int y = this->quantize(vertices[j].y);
+
+        if(j == 0){
+            writeUInt16(x);
+            writeUInt16(y);
+        }
+        else{
+            this->writeDelta(x - state.vertices[2*j-2], y - state.vertices[2*j-1]);
+        }
+
+        state.vertices[2*j] = x;
+        state.vertices[2*j+1] = y;
+    }
+
+    state.sequence = m_sequence;
+    state.keyframeSequence = m_sequence;
+}
+
+bool ContourStreamEncoder::encodeDelta(const ContourSet& contours, int i, State& state)
+{
+    int numStored = state.vertices.size()/2;
+    this->resample(contours.getVertices(i), contours.getNumVertices(i), state);
+
+    this->writeHeader(ContourStreamDecoder::DELTA_FRAME, contours, i, state.sequence, numStored);
+    int countPosition = m_data.size();
+    writeUInt16(0);
+
+    // a keyframe costs about two bytes per vertex
+    int maxSize = countPosition + 2*contours.getNumVertices(i) + 4;
+    int tolerance = m_tolerance*(1 << m_fractionalBits);
+    m_changed.clear();
+
+    for(int j = 0; j < numStored; j++)
+    {
+        int dx = this->quantize(m_resampled[j].x) - state.vertices[2*j];
+        int dy = this->quantize(m_resampled[j].y) - state.vertices[2*j+1];
+        if(dx*dx + dy*dy <= tolerance*tolerance){
+            continue;
+        }
+
+        writeUInt16(j);
+        this->writeDelta(dx, dy);
+        m_changed.push_back(j);
+
+        if(m_data.size() > maxSize){
+            return false;
+        }
+    }
+
+    // only commit to the state once the delta is the one being sent
+    for(int j = 0; j < m_changed.size(); j++) {
+        int index = m_changed[j];
+        state.vertices[2*index] = this->quantize(m_resampled[index].x);
+        state.vertices[2*index+1] = this->quantize(m_resampled[index].y);
+    }
+
+    m_data[countPosition] = m_changed.size() >> 8;
+    m_data[countPosition+1] = m_changed.size();
+    state.sequence = m_sequence;
+    return true;
+}
+
+void ContourStreamEncoder::resample(const ofVec2f* vertices, int numVertices, const State& state)
+{
+    int numStored = state.vertices.size()/2;
+    float scale = 1.0f/(1 << m_fractionalBits);
+    m_resampled.resize(numStored);
+
+    // arc length fractions of the stored contour
+    m_lengths.resize(numStored + 1);
+    m_lengths[0] = 0;
+    for(int j = 0; j < numStored; j++) {
+        int k = (j + 1) % numStored;
+        float dx = (state.vertices[2*k] - state.vertices[2*j])*scale;
+        float dy = (state.vertices[2*k+1] - state.vertices[2*j+1])*scale;
+        m_lengths[j+1] = m_lengths[j] + sqrt(dx*dx + dy*dy);
+    }
+    float storedLength = m_lengths[numStored];
+
+    // the new contour starts at its closest vertex to the first stored one
+    ofVec2f first(state.vertices[0]*scale, state.vertices[1]*scale);
+    int start = 0;
+    for(int j = 1; j < numVertices; j++) {
+        if(vertices[j].squareDistance(first) < vertices[start].squareDistance(first)){
+            start = j;
+        }
+    }
+
+    float length = 0;
+    for(int j = 0; j < numVertices; j++) {
+        length += vertices[(start + j) % numVertices].distance(vertices[(start + j + 1) % numVertices]);
+    }
+
+    if(storedLength <= 0 || length <= 0){
+        for(int j = 0; j < numStored; j++) {
+            m_resampled[j] = vertices[start];
+        }
+        return;
+    }
+
+    // walk both contours at once
+    int segment = 0;
+    float segmentStart = 0;
+    float segmentLength = vertices[start].distance(vertices[(start + 1) % numVertices]);
+    for(int j = 0; j < numStored; j++)
+    {
+        float target = m_lengths[j]/storedLength*length;
+        while(segmentStart + segmentLength < target && segment < numVertices - 1){
+            segmentStart += segmentLength;
+            segment++;
+            segmentLength = vertices[(start + segment) % numVertices].distance(vertices[(start + segment + 1) % numVertices]);
+        }
+
+        const ofVec2f& a = vertices[(start + segment) % numVertices];
+        const ofVec2f& b = vertices[(start + segment + 1) % numVertices];
+        float t = segmentLength > 0 ? ofClamp((target - segmentStart)/segmentLength, 0, 1) : 0;
+        m_resampled[j] = a + (b - a)*t;
+    }
+}
+
+void ContourStreamEncoder::writeDelta(int dx, int dy)
+{
+    if(dx > ContourDecoder::DELTA_ESCAPE && dx < 128 && dy >= -128 && dy < 128){
+        writeUInt8(dx & 0xFF);
+        writeUInt8(dy & 0xFF);
+    }
+    else{
+        writeUInt8(ContourDecoder::DELTA_ESCAPE & 0xFF);
+        writeUInt16(dx & 0xFFFF);
+        writeUInt16(dy & 0xFFFF);
+    }
+}
+
@@ -0,0 +1,114 @@
+/*
+ *  ContourStreamEncoder.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ContourSet.h"
+#include "ContourStreamDecoder.h"
+
+
+//========================== class ContourStreamEncoder ==============================
+//============================================================================
+/** \class ContourStreamEncoder ContourStreamEncoder.h
+ *	\brief Encodes the contours of consecutive frames as keyframes and per-label deltas
+ *	\details It mirrors the state of the ContourStreamDecoder on the renderer. A label
+ *    gets a keyframe when it first appears, every few frames and when its vertex count
+ *    drifts; in between, the new contour is resampled along the arc length of the
+ *    previous one and only the vertices that moved more than the tolerance are sent.
+ *    The format is described in ContourStreamDecoder.h.
+ */
+
+class ContourStreamEncoder
+{
+
+public:
+
+    //! Constructor
+    ContourStreamEncoder();
+
+    //! Destructor
+    ~ContourStreamEncoder();
+
+    //! Set the number of frames between keyframes of a label
+    void setKeyframeInterval(int frames) {m_keyframeInterval = max(frames, 1);}
+
+    //! Set the distance in sensor pixels a vertex has to move to be sent
+    void setTolerance(float tolerance) {m_tolerance = max(tolerance, 0.0f);}
+
+    //! Set the number of fractional bits of the vertex coordinates
+    void setFractionalBits(int fractionalBits) {m_fractionalBits = ofClamp(fractionalBits, 0, 5);}
+
+    //! Sends keyframes for all the labels in the next frame
+    void requestKeyframe() {m_keyframeRequested = true;}
+
+    //! Starts a new frame, forgetting the labels that are gone
+    void beginFrame(const ContourSet& contours);
+
+    //! Encodes the given contour of the current frame, the blob stays valid until the next call
+    const vector<unsigned char>& encode(const ContourSet& contours, int i);
+
+    //! Returns the sequence number of the current frame
+    unsigned int getSequence() const {return m_sequence;}
+
+private:
+
+    //! Contour of a label as the decoder has it, in fixed point
+    struct State
+    {
+        unsigned int    sequence;           ///< sequence number of the last update
+        unsigned int    keyframeSequence;   ///< sequence number of the last keyframe
+        vector<int>     vertices;           ///< x, y pairs in fixed point
+    };
+
+    typedef std::map<unsigned int, State> StateMap;
+
+    //! Writes the header of a blob
+    void writeHeader(int type, const ContourSet& contours, int i, unsigned int baseSequence, int numVertices);
+
+    //! Encodes a keyframe and stores it as the state of the label
+    void encodeKeyframe(const ContourSet& contours, int i, State& state);
+
+    //! Encodes the vertices that moved, returns false if a keyframe would be smaller
+    bool encodeDelta(const ContourSet& contours, int i, State& state);
+
+    //! Resamples the contour at the arc length fractions of the stored one, starting from the closest vertex
+    void resample(const ofVec2f* vertices, int numVertices, const State& state);
+
+    //! Writes a delta, escaping to 16 bits when it doesn't fit in 8
+    void writeDelta(int dx, int dy);
+
+    void writeUInt8(unsigned int value) {m_data.push_back(value);}
+
+    void writeUInt16(unsigned int value) {m_data.push_back(value >> 8); m_data.push_back(value);}
+
+    void writeUInt32(unsigned int value) {this->writeUInt16(value >> 16); this->writeUInt16(value);}
+
+    //! Converts a sensor coordinate to fixed point
+    int quantize(float value) const {return ofClamp(int(value*(1 << m_fractionalBits) + 0.5f), 0, 0xFFFF);}
+
+private:
+
+    StateMap                m_states;               ///< contour of every label as the decoder has it
+    unsigned int            m_sequence;             ///< sequence number of the current frame
+    int                     m_keyframeInterval;     ///< frames between keyframes of a label
+    float                   m_tolerance;            ///< distance a vertex has to move to be sent
+    int                     m_fractionalBits;       ///< fractional bits of the vertex coordinates
+    bool                    m_keyframeRequested;    ///< whether the renderer asked for keyframes
+    bool                    m_keyframeFrame;        ///< whether the current frame only sends keyframes
+
+    vector<unsigned char>   m_data;                 ///< encoded blob, reused between contours
+    vector<unsigned int>    m_labels;               ///< sorted labels of the current frame
+    vector<float>           m_lengths;              ///< cumulative arc lengths
+    vector<ofVec2f>         m_resampled;            ///< new contour resampled on the stored one
+    vector<int>             m_changed;              ///< indices of the vertices that moved
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,204 @@
+/*
+ *  FrameQueue.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ThreadSignal.h"
+#include <atomic>
+#include <thread>
+
+
+//========================== class FrameQueue ==============================
+//============================================================================
+/** \class FrameQueue FrameQueue.h
+ *	\brief Bounded lock-free single producer, single consumer queue of preallocated frames
+ *	\details The frames are allocated once and never copied: the queue passes their
+ *    indices around. The producer fills the frame returned by getWriteFrame() and
+ *    publishes it with push(); when the queue is full the oldest queued frame is
+ *    dropped, so the producer never waits. The consumer takes frames with pop(),
+ *    which gives the previous one back.
+ *
+ *    Both sides advance the read index with a compare-and-swap, which is how the
+ *    producer drops the oldest frame without racing the consumer. An index is
+ *    published with a release store and read with an acquire load, so the frame
+ *    behind it is complete when the other side sees it. There are two
+ *    frames more than the capacity, one owned by each side, so the producer always
+ *    has a free frame to write.
+ *
+ *    A push notifies the push signal and a pop the pop signal, when they are set,
+ *    so the consumer can sleep until there is a frame and the producer until there is room.
+ */
+
+template <class T>
+class FrameQueue
+{
+
+public:
+
+    //! Constructor
+    FrameQueue(int capacity);
+
+    //! Returns the frame the producer fills, it stays the same until push()
+    T& getWriteFrame() {return m_frames[m_writeFrame];}
+
+    //! Publishes the write frame, dropping the oldest queued frame if the queue is full
+    void push();
+
+    //! Returns the oldest queued frame, or NULL if there is none, giving back the previous one
+    T* pop();
+
+    //! Returns the number of frames pushed
+    unsigned int getNumPushed() const {return m_numPushed.load(std::memory_order_relaxed);}
+
+    //! Returns the number of frames popped
+    unsigned int getNumPopped() const {return m_numPopped.load(std::memory_order_relaxed);}
+
+    //! Returns the number of frames dropped because the queue was full
+    unsigned int getNumDropped() const {return m_numDropped.load(std::memory_order_relaxed);}
+
+    //! Returns the number of frames waiting to be popped
+    int size() const {return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);}
+
+    //! Returns whether the next push() would drop a frame. Only the producer can rely on it, the consumer may make room at any moment
+    bool isFull() const {return this->size() >= m_capacity;}
+
+    //! Sets the signal notified on every push, NULL for none
+    void setPushSignal(ThreadSignal* signal) {m_pushSignal = signal;}
+
+    //! Sets the signal notified on every pop of a frame, NULL for none
+    void setPopSignal(ThreadSignal* signal) {m_popSignal = signal;}
+
+private:
+
+    //! Takes a frame nobody is using for the producer
+    int acquireFreeFrame();
+
+private:
+
+    int                     m_capacity;         ///< maximum number of queued frames
+    int                     m_numFrames;        ///< number of allocated frames
+    std::vector<T>          m_frames;           ///< preallocated frames
+
+    std::vector<std::atomic<int> >  m_slots;            ///< ring of queued frame indices, read by the consumer while the producer may drop them
+    std::atomic<unsigned int>       m_head;             ///< next slot to write, only moved by the producer
+    std::atomic<unsigned int>       m_tail;             ///< next slot to read, moved by both sides with a compare-and-swap
+
+    std::vector<int>                m_returned;         ///< ring of frame indices given back by the consumer
+    std::atomic<unsigned int>       m_returnedHead;     ///< next returned slot to write, only moved by the consumer
+    unsigned int                    m_returnedTail;     ///< next returned slot to read, only used by the producer
+
+    std::vector<int>                m_dropped;          ///< frames dropped by the producer, free to write again
+    int                             m_writeFrame;       ///< frame being filled by the producer
+    int                             m_readFrame;        ///< frame being used by the consumer, -1 if none
+
+    std::atomic<unsigned int>       m_numPushed;        ///< number of frames pushed
+    std::atomic<unsigned int>       m_numPopped;        ///< number of frames popped
+    std::atomic<unsigned int>       m_numDropped;       ///< number of frames dropped
+
+    ThreadSignal*                   m_pushSignal;       ///< notified on every push, wakes the consumer
+    ThreadSignal*                   m_popSignal;        ///< notified on every pop, wakes the producer waiting for room
+};
+
+
+template <class T>
+FrameQueue<T>::FrameQueue(int capacity): m_capacity(capacity), m_numFrames(capacity + 2), m_slots(capacity), m_head(0), m_tail(0),
+    m_returnedHead(0), m_returnedTail(0), m_writeFrame(0), m_readFrame(-1), m_numPushed(0), m_numPopped(0), m_numDropped(0),
+    m_pushSignal(NULL), m_popSignal(NULL)
+{
+    m_frames.resize(m_numFrames);
+    m_returned.resize(m_numFrames);
+    m_dropped.reserve(m_numFrames);
+
+    for(int i = m_numFrames - 1; i > 0; i--) {
+        m_dropped.push_back(i);
+    }
+}
+
+template <class T>
+void FrameQueue<T>::push()
+{
+    // a single read of the tail, the consumer may drain the queue at any moment
+    unsigned int head = m_head.load(std::memory_order_relaxed);
+    unsigned int tail = m_tail.load(std::memory_order_acquire);
+    if(head - tail >= m_capacity)
+    {
+        // read the oldest index before claiming it, the slot can't be rewritten while it is queued
+        int oldest = m_slots[tail % m_capacity].load(std::memory_order_relaxed);
+        if(m_tail.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel)){
+            m_dropped.push_back(oldest);
+            m_numDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        // otherwise the consumer has just taken it and there is room
+    }
+
+    m_slots[head % m_capacity].store(m_writeFrame, std::memory_order_relaxed);
+    m_head.store(head + 1, std::memory_order_release);
+    m_numPushed.fetch_add(1, std::memory_order_relaxed);
+
+    if(m_pushSignal){
+        m_pushSignal->notify();
+    }
+
+    m_writeFrame = this->acquireFreeFrame();
+}
+
+template <class T>
+T* FrameQueue<T>::pop()
+{
+    // give the previous frame back first, so the consumer never holds two
+    if(m_readFrame >= 0){
+        unsigned int returnedHead = m_returnedHead.load(std::memory_order_relaxed);
+        m_returned[returnedHead % m_numFrames] = m_readFrame;
+        m_returnedHead.store(returnedHead + 1, std::memory_order_release);
+        m_readFrame = -1;
+    }
+
+    while(true)
+    {
+        unsigned int tail = m_tail.load(std::memory_order_acquire);
+        if(tail == m_head.load(std::memory_order_acquire)){
+            return NULL;
+        }
+
+        int frame = m_slots[tail % m_capacity].load(std::memory_order_relaxed);
+        if(m_tail.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel)){
+            m_readFrame = frame;
+            m_numPopped.fetch_add(1, std::memory_order_relaxed);
+            if(m_popSignal){
+                m_popSignal->notify();
+            }
+            return &m_frames[frame];
+        }
+        // the producer dropped it, try the next one
+    }
+}
+
+template <class T>
+int FrameQueue<T>::acquireFreeFrame()
+{
+    if(!m_dropped.empty()){
+        int frame = m_dropped.back();
+        m_dropped.pop_back();
+        return frame;
+    }
+
+    // the producer holds none, the consumer at most one and the ring at most its capacity,
+    // so one of the two extra frames has been given back
+    while(m_returnedTail == m_returnedHead.load(std::memory_order_acquire)){
+        std::this_thread::yield();
+    }
+
+    int frame = m_returned[m_returnedTail % m_numFrames];
+    m_returnedTail++;
+    return frame;
+}
+
+//==========================================================================
+
+
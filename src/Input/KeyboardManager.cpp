@@ -59,6 +59,18 @@ void KeyboardManager::keyPressed(ofKeyEventArgs &e)
     if(key == ' ') {
         AppManager::getInstance().toggleDebugMode();
     }
+    
+    if(key == 'p' || key == 'P') {
+        AppManager::getInstance().getProfilerManager().dumpCsv();
+    }
+    
+    if(key == 'j' || key == 'J') {
+        AppManager::getInstance().getProfilerManager().dumpJson();
+    }
+    
+    if(key == 'o' || key == 'O') {
+        AppManager::getInstance().getTrackingManager().togglePlayback();
+    }
 
 }
 
@@ -0,0 +1,127 @@
+/*
+ *  MessageQueue.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+
+
+//========================== class MessageQueue ==============================
+//============================================================================
+/** \class MessageQueue MessageQueue.h
+ *	\brief Bounded lock-free multiple producer, single consumer queue of small messages
+ *	\details The messages are copied into preallocated cells, so pushing never
+ *    allocates. Every cell carries a sequence number telling whether it is free for
+ *    the producers or ready for the consumer; producers claim a cell by advancing the
+ *    write index with a compare-and-swap. A cell is handed over by a release store of
+ *    its sequence, which the other side loads with acquire before touching the message.
+ *    When the queue is full the new message is dropped and counted.
+ */
+
+template <class T>
+class MessageQueue
+{
+
+public:
+
+    //! Constructor, the capacity is rounded up to a power of two
+    MessageQueue(int capacity);
+
+    //! Copies the message into the queue, returns false if the queue is full
+    bool push(const T& message);
+
+    //! Copies the oldest message out of the queue, returns false if there is none
+    bool pop(T& message);
+
+    //! Returns the number of messages dropped because the queue was full
+    unsigned int getNumDropped() const {return m_numDropped.load(std::memory_order_relaxed);}
+
+private:
+
+    //! A message and the sequence number of its cell
+    struct Cell
+    {
+        std::atomic<unsigned int>   sequence;   ///< write index the cell is free for, plus one once it is written
+        T                           message;    ///< the message
+    };
+
+    vector<Cell>                m_cells;        ///< preallocated cells
+    unsigned int                m_mask;         ///< number of cells minus one
+    std::atomic<unsigned int>   m_writeIndex;   ///< next cell the producers write to
+    unsigned int                m_readIndex;    ///< next cell the consumer reads from
+    std::atomic<unsigned int>   m_numDropped;   ///< number of messages dropped
+};
+
+
+template <class T>
+MessageQueue<T>::MessageQueue(int capacity): m_writeIndex(0), m_readIndex(0), m_numDropped(0)
+{
+    unsigned int size = 1;
+    while(size < capacity){
+        size <<= 1;
+    }
+
+    // the cells hold atomics, which can't be moved, so the vector is built at its size
+    vector<Cell>(size).swap(m_cells);
+    m_mask = size - 1;
+    for(unsigned int i = 0; i < size; i++) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <class T>
+bool MessageQueue<T>::push(const T& message)
+{
+    unsigned int index = m_writeIndex.load(std::memory_order_relaxed);
+    Cell* cell;
+    for(;;)
+    {
+        // pairs with the release of the consumer freeing the cell
+        cell = &m_cells[index & m_mask];
+        unsigned int sequence = cell->sequence.load(std::memory_order_acquire);
+
+        // a failed exchange loads the index another producer moved it to
+        int difference = int(sequence - index);
+        if(difference == 0){
+            if(m_writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)){
+                break;
+            }
+        }
+        else if(difference < 0){
+            m_numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else{
+            index = m_writeIndex.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->message = message;
+    cell->sequence.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+template <class T>
+bool MessageQueue<T>::pop(T& message)
+{
+    Cell& cell = m_cells[m_readIndex & m_mask];
+    unsigned int sequence = cell.sequence.load(std::memory_order_acquire);
+    if(int(sequence - (m_readIndex + 1)) < 0){
+        return false;
+    }
+
+    message = cell.message;
+    cell.sequence.store(m_readIndex + m_mask + 1, std::memory_order_release);
+    m_readIndex++;
+    return true;
+}
+
+//==========================================================================
+
+
@@ -0,0 +1,58 @@
+/*
+ *  OscDestination.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+#include "ofxOsc.h"
+#include "ContourStreamEncoder.h"
+#include "OscStats.h"
+
+
+//========================== struct OscDestination ==============================
+//============================================================================
+/** \struct OscDestination OscDestination.h
+ *	\brief A host the frames are sent to, with its own encoding, rate limit and statistics
+ *	\details The statistics are written by the sender thread and read by the main thread to be
+ *    shown, so they are atomic counters read with OscStats::get. A destination is only
+ *    copied while the destinations are set up, before the sender thread starts.
+ *    Every destination has a stream encoder of its own, as the deltas it sends are
+ *    relative to the frames that destination was sent, whatever its rate limit.
+ */
+
+struct OscDestination
+{
+    string                          name;               ///< name shown in the sending information
+    string                          host;               ///< unicast or multicast address
+    int                             port;               ///< UDP port
+    int                             encoding;           ///< contour encoding, or OscManager::ENCODING_PARAMETER to follow the GUI
+    float                           maxRate;            ///< maximum number of frames per second, 0 for no limit
+    ofPtr<ofxOscSender>             sender;             ///< socket the packets are sent through
+    ofPtr<ContourStreamEncoder>     streamEncoder;      ///< keyframes and deltas against the contours sent to this destination
+
+    bool                            due;                ///< whether the frame being sent goes to this destination
+    unsigned long long              nextFrameTime;      ///< earliest time of the next frame, in microseconds
+    std::atomic<unsigned int>       numFramesSent;      ///< number of frames sent
+    std::atomic<unsigned int>       numFramesSkipped;   ///< number of frames skipped by the rate limit
+    std::atomic<unsigned int>       numPackets;         ///< number of packets sent
+    std::atomic<unsigned long long> numBytes;           ///< number of bytes sent
+
+    OscDestination(): port(0), encoding(0), maxRate(0), due(false), nextFrameTime(0),
+        numFramesSent(0), numFramesSkipped(0), numPackets(0), numBytes(0) {}
+
+    //! Copies the destination, atomic counters can't be copied on their own
+    OscDestination(const OscDestination& other): name(other.name), host(other.host), port(other.port), encoding(other.encoding),
+        maxRate(other.maxRate), sender(other.sender), streamEncoder(other.streamEncoder), due(other.due), nextFrameTime(other.nextFrameTime),
+        numFramesSent(OscStats::get(other.numFramesSent)), numFramesSkipped(OscStats::get(other.numFramesSkipped)),
+        numPackets(OscStats::get(other.numPackets)), numBytes(OscStats::get(other.numBytes)) {}
+};
+
+//==========================================================================
+
+
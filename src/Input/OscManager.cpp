@@ -12,13 +12,29 @@
 #include "AppManager.h"
 
 
-OscManager::OscManager(): Manager()
+const int OscManager::MAX_PACKET_SIZE = 1472;
+const int OscManager::CONTOUR_MESSAGE_OVERHEAD = 52;
+const int OscManager::CONTOUR_VERTEX_SIZE = 10;
+const int OscManager::PACKET_BUFFER_SIZE = 327680;
+const int OscManager::CONTOUR_BLOB_OVERHEAD = 65;
+const int OscManager::NUM_CONTOURS_MESSAGE_SIZE = 40; // element size, "/MurmurRenderer/NumContours" padded, ",i" padded and the count
+const int OscManager::BUNDLE_HEADER_SIZE = 16;
+const int OscManager::FRAGMENT_PAYLOAD_SIZE = 1392; // MAX_PACKET_SIZE minus the bundle header, the element size and the fragment message header
+const float OscManager::STATS_REFRESH_RATE = 4;
+
+
+OscManager::OscManager(): Manager(), m_statsTime(0), m_previousNumReceived(0), m_numFrameMessages(0), m_frameId(0), m_frameBundle(true), m_contourEncoding(ENCODING_FLOAT),
+    m_keyframeInterval(30), m_streamTolerance(0.5), m_streamEncoder(&m_contourStreamEncoder), m_keyframeRequested(false)
 {
-    //Intentionally left empty
+    m_packetBuffer.resize(MAX_PACKET_SIZE);
+    m_messageBuffer.resize(PACKET_BUFFER_SIZE);
+    m_fragmentBuffer.resize(MAX_PACKET_SIZE);
 }
 
 OscManager::~OscManager()
 {
+   m_senderThread.stop();
+   m_receiverThread.stop();
    ofLogNotice() << "OscManager::destructor";
 }
 
@@ -42,19 +58,56 @@ void OscManager::setupOscReceiver()
 {
     int portReceive = AppManager::getInstance().getSettingsManager().getPortReceive();
     
-    m_oscReceiver.setup(portReceive);
+    this->setupParameters();
+    m_receiverThread.setup(portReceive);
    
     ofLogNotice() <<"OscManager::setupOscReceiver -> listening for osc messages on port  " << portReceive;
 }
 
 void OscManager::setupOscSender()
 {
-    int portSend = AppManager::getInstance().getSettingsManager().getPortSend();
-    string host = AppManager::getInstance().getSettingsManager().getIpAddress();
+    this->setupDestinations();
+    m_senderThread.start(this);
+}
+
+void OscManager::setupDestinations()
+{
+    // the contours of a benchmark replay must not reach the installation
+    if(AppManager::getInstance().getBenchmarkManager().isEnabled()){
+        ofLogNotice() <<"OscManager::setupDestinations -> benchmark mode, not sending osc";
+        return;
+    }
     
-    m_oscSender.setup(host, portSend);
+    OscDestination destination;
+    destination.name = "default";
+    destination.host = AppManager::getInstance().getSettingsManager().getIpAddress();
+    destination.port = AppManager::getInstance().getSettingsManager().getPortSend();
+    destination.encoding = ENCODING_PARAMETER;
+    m_destinations.push_back(destination);
+    
+    const DestinationSettingsVector& destinations = AppManager::getInstance().getSettingsManager().getDestinations();
+    for(int i = 0; i < destinations.size(); i++)
+    {
+        destination.name = destinations[i].name;
+        destination.host = destinations[i].ipAddress;
+        destination.port = destinations[i].port;
+        destination.encoding = this->getEncoding(destinations[i].encoding);
+        destination.maxRate = destinations[i].maxRate;
+        m_destinations.push_back(destination);
+    }
     
-    ofLogNotice() <<"OscManager::setupOscSender -> open osc connection " << host << ":" << portSend;
+    for(int i = 0; i < m_destinations.size(); i++)
+    {
+        // sending to a multicast group doesn't need anything else than its address
+        OscDestination& destination = m_destinations[i];
+        destination.sender = ofPtr<ofxOscSender>(new ofxOscSender());
+        destination.sender->setup(destination.host, destination.port);
+        destination.streamEncoder = ofPtr<ContourStreamEncoder>(new ContourStreamEncoder());
+        
+        int firstByte = ofToInt(ofSplitString(destination.host, ".").front());
+        string type = (firstByte >= 224 && firstByte <= 239) ? "multicast" : "unicast";
+        ofLogNotice() <<"OscManager::setupDestinations -> open " << type << " osc connection " << destination.name << " " << destination.host << ":" << destination.port;
+    }
 }
 
 void OscManager::setupText()
@@ -65,11 +118,9 @@ void OscManager::setupText()
     int fontSize = 12;
     position.x = positionTrackingVisual.x;
     position.y = positionTrackingVisual.y +  AppManager::getInstance().getTrackingManager().getWidth() + LayoutManager::MARGIN;
-    int height = fontSize*3;
+    int height = fontSize*(5 + m_destinations.size());
     
-    int portSend = AppManager::getInstance().getSettingsManager().getPortSend();
-    string host = AppManager::getInstance().getSettingsManager().getIpAddress();
-    string text = ">> OSC sending -> Host: " + host + ", Port: " + ofToString(portSend);
+    string text = ">> OSC sending";
     
     m_sendingInformation =  ofPtr<TextVisual> (new TextVisual(position, width, height));
     m_sendingInformation->setText(text, "fonts/open-sans/OpenSans-Semibold.ttf", fontSize);
@@ -95,201 +146,869 @@ void OscManager::setupText()
 
 void OscManager::update()
 {
-    // check for waiting messages
-    while(m_oscReceiver.hasWaitingMessages()){
-        // get the next message
-        ofxOscMessage m;
-        m_oscReceiver.getNextMessage(&m);
-        
-        m_latestOscMessage = m;
-        this->updateReceiveText();
-        
-        if(m.getAddress() == "/MurmurContourTracking/NearClipping"){
-            int nearClipping = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiNearClipping(nearClipping);
-        }
+    this->receiveMessages();
+    this->updateStats();
+}
+
+void OscManager::updateStats()
+{
+    float time = ofGetElapsedTimef();
+    float elapsedTime = time - m_statsTime;
+    if(elapsedTime < 1.0/STATS_REFRESH_RATE){
+        return;
+    }
+    
+    m_statsTime = time;
+    this->updateSendText(elapsedTime);
+    this->updateReceiveText(elapsedTime);
+}
+
+void OscManager::receiveMessages()
+{
+    // only the latest value of every address within a frame is applied
+    OscControlMessage message;
+    while(m_receiverThread.pop(message))
+    {
+        m_latestOscMessage = message;
         
-        else if(m.getAddress() == "/MurmurContourTracking/FarClipping"){
-            int farClipping = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiFarClipping(farClipping);
+        int index = this->findParameter(message);
+        if(index < 0){
+            continue;
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/AudioVolume"){
-            float value = m.getArgAsFloat(0);
-            AppManager::getInstance().getGuiManager().setAudioVolume(value);
-            this->updateReceiveText();
+        OscParameter& parameter = m_parameters[index];
+        if(!parameter.pending){
+            parameter.pending = true;
+            m_pendingParameters.push_back(index);
         }
-        
-        else if(m.getAddress() == "/MurmurContourTracking/Threslhold"){
-            int threshold = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiThreshold(threshold);
+        parameter.message = message;
+    }
+    
+    for(int i = 0; i < m_pendingParameters.size(); i++) {
+        OscParameter& parameter = m_parameters[m_pendingParameters[i]];
+        this->applyParameter(parameter);
+        parameter.pending = false;
+    }
+    
+    m_pendingParameters.clear();
+}
+
+void OscManager::setupParameters()
+{
+    this->addParameter("NearClipping", &GuiManager::setGuiNearClipping);
+    this->addParameter("FarClipping", &GuiManager::setGuiFarClipping);
+    this->addParameter("AudioVolume", &GuiManager::setAudioVolume);
+    this->addParameter("Threslhold", &GuiManager::setGuiThreshold);
+    this->addParameter("BackgroundThreslhold", &GuiManager::setGuiBackgroundThreshold);
+    this->addParameter("MinArea", &GuiManager::setGuiMinArea);
+    this->addParameter("MaxArea", &GuiManager::setGuiMaxArea);
+    this->addParameter("BackgroundSubstraction", &GuiManager::setBackgroundSubstraction);
+    this->addParameter("SendAllContours", &GuiManager::setSendAllContours);
+    this->addParameter("PyramidLevels", &GuiManager::setPyramidLevels);
+    this->addParameter("PyramidRefine", &GuiManager::setPyramidRefine);
+    this->addParameter("IncrementalContours", &GuiManager::setIncrementalContours);
+    this->addParameter("IncrementalMaxDirty", &GuiManager::setIncrementalMaxDirty);
+    this->addParameter("BitMask", &GuiManager::setBitMask);
+    this->addParameter("MaskOpen", &GuiManager::setMaskOpen);
+    this->addParameter("MaskClose", &GuiManager::setMaskClose);
+    this->addParameter("MaskShape", &GuiManager::setMaskShape);
+    this->addParameter("IdleMode", &GuiManager::setIdleMode);
+    this->addParameter("IdleFps", &GuiManager::setIdleFrameRate);
+    this->addParameter("VertexBudget", &GuiManager::setVertexBudget);
+    this->addParameter("PacketBytes", &GuiManager::setPacketBytes);
+    this->addParameter("FrameBytes", &GuiManager::setFrameBytes);
+    this->addParameter("SendBudget", &GuiManager::setSendBudget);
+    this->addParameter("MaxVertices", &GuiManager::setMaxVertices);
+    this->addParameter("MaxContours", &GuiManager::setMaxContours);
+    this->addParameter("FrameBundle", &GuiManager::setFrameBundle);
+    this->addParameter("ContourEncoding", &GuiManager::setContourEncoding);
+    this->addParameter("KeyframeInterval", &GuiManager::setKeyframeInterval);
+    this->addParameter("StreamTolerance", &GuiManager::setStreamTolerance);
+    this->addParameter("RequestKeyframe", &OscManager::requestKeyframe);
+    this->addParameter("FourierDescriptors", &GuiManager::setFourierDescriptors);
+    this->addParameter("FourierCoefficients", &GuiManager::setFourierCoefficients);
+    this->addParameter("SharedMemory", &GuiManager::setSharedMemory);
+    this->addParameter("ResetBackground", &OscManager::resetBackground);
+    this->addParameter("Profiler", &GuiManager::setProfiler);
+    this->addParameter("DumpProfileCsv", &OscManager::dumpProfileCsv);
+    this->addParameter("DumpProfileJson", &OscManager::dumpProfileJson);
+    this->addParameter("Source", &GuiManager::setSource);
+    this->addParameter("SyntheticPeople", &GuiManager::setSyntheticPeople);
+    this->addParameter("SyntheticFps", &GuiManager::setSyntheticFrameRate);
+    this->addParameter("SyntheticNoise", &GuiManager::setSyntheticNoise);
+    this->addParameter("SyntheticDropout", &GuiManager::setSyntheticDropout);
+    this->addParameter("Record", &GuiManager::setRecord);
+    this->addParameter("BlurScale", &GuiManager::setGuiBlurScale);
+    this->addParameter("BlurRotation", &GuiManager::setGuiBlurRotation);
+    this->addParameter("SimplifyContour", &GuiManager::setGuiSimplifyContour);
+    this->addParameter("SmoothingSize", &GuiManager::setGuiSmoothingSize);
+    this->addParameter("SmoothingShape", &GuiManager::setGuiSmoothingShape);
+    this->addParameter("CropBottom", &GuiManager::setCropBottom);
+    this->addParameter("CropLeft", &GuiManager::setCropLeft);
+    this->addParameter("CropRight", &GuiManager::setCropRight);
+    this->addParameter("CropTop", &GuiManager::setCropTop);
+    
+    this->setupParameterTable();
+}
+
+void OscManager::addParameter(const string& name, void (GuiManager::*setter)(int))
+{
+    OscParameter parameter(name, PARAMETER_INT);
+    parameter.setInt = setter;
+    m_parameters.push_back(parameter);
+}
+
+void OscManager::addParameter(const string& name, void (GuiManager::*setter)(float))
+{
+    OscParameter parameter(name, PARAMETER_FLOAT);
+    parameter.setFloat = setter;
+    m_parameters.push_back(parameter);
+}
+
+void OscManager::addParameter(const string& name, void (GuiManager::*setter)(bool))
+{
+    OscParameter parameter(name, PARAMETER_BOOL);
+    parameter.setBool = setter;
+    m_parameters.push_back(parameter);
+}
+
+void OscManager::addParameter(const string& name, void (OscManager::*action)())
+{
+    OscParameter parameter(name, PARAMETER_ACTION);
+    parameter.action = action;
+    m_parameters.push_back(parameter);
+}
+
+void OscManager::setupParameterTable()
+{
+    // open addressing with linear probing, kept at most a quarter full
+    int size = 1;
+    while(size < 4*m_parameters.size()){
+        size <<= 1;
+    }
+    
+    m_parameterTable.assign(size, -1);
+    for(int i = 0; i < m_parameters.size(); i++)
+    {
+        if(this->findParameter(m_parameters[i].hash, m_parameters[i].address.c_str()) >= 0){
+            ofLogError() <<"OscManager::setupParameterTable -> duplicated address " << m_parameters[i].address;
+            continue;
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/BackgroundThreslhold"){
-            int backgroundThreslhold = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiBackgroundThreshold(backgroundThreslhold);
+        int slot = m_parameters[i].hash & (size - 1);
+        while(m_parameterTable[slot] >= 0){
+            slot = (slot + 1) & (size - 1);
         }
-        
-        else if(m.getAddress() == "/MurmurContourTracking/MinArea"){
-            int minArea = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiMinArea(minArea);
+        m_parameterTable[slot] = i;
+    }
+}
+
+int OscManager::findParameter(const OscControlMessage& message) const
+{
+    return this->findParameter(message.hash, message.address);
+}
+
+int OscManager::findParameter(unsigned int hash, const char* address) const
+{
+    int mask = m_parameterTable.size() - 1;
+    for(int slot = hash & mask; m_parameterTable[slot] >= 0; slot = (slot + 1) & mask)
+    {
+        const OscParameter& parameter = m_parameters[m_parameterTable[slot]];
+        if(parameter.hash == hash && parameter.address == address){
+            return m_parameterTable[slot];
         }
-        
-        else if(m.getAddress() == "/MurmurContourTracking/MaxArea"){
-            int maxArea = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiMaxArea(maxArea);
+    }
+    
+    return -1;
+}
+
+void OscManager::applyParameter(const OscParameter& parameter)
+{
+    GuiManager& guiManager = AppManager::getInstance().getGuiManager();
+    const OscControlMessage& message = parameter.message;
+    
+    if(parameter.type == PARAMETER_ACTION){
+        (this->*parameter.action)();
+        return;
+    }
+    
+    if(message.numArgs < 1){
+        ofLogWarning() <<"OscManager::applyParameter -> missing argument: " << parameter.address;
+        return;
+    }
+    
+    switch (parameter.type)
+    {
+        case PARAMETER_INT:
+            (guiManager.*parameter.setInt)(message.ints[0]);
+            break;
+            
+        case PARAMETER_FLOAT:
+            (guiManager.*parameter.setFloat)(message.floats[0]);
+            break;
+            
+        case PARAMETER_BOOL:
+            (guiManager.*parameter.setBool)(message.ints[0] != 0);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+void OscManager::requestKeyframe()
+{
+    m_keyframeRequested.store(true, std::memory_order_relaxed);
+}
+
+void OscManager::resetBackground()
+{
+    AppManager::getInstance().getTrackingManager().onResetBackground();
+}
+
+void OscManager::dumpProfileCsv()
+{
+    AppManager::getInstance().getProfilerManager().dumpCsv();
+}
+
+void OscManager::dumpProfileJson()
+{
+    AppManager::getInstance().getProfilerManager().dumpJson();
+}
+
+void OscManager::draw()
+{
+    m_sendingInformation->draw();
+    m_receivingInformation->draw();
+}
+
+bool OscManager::sendContours(const ContourSet& contours, int degradation)
+{
+    OscFrame& frame = m_senderThread.getWriteFrame();
+    frame.type = OscFrame::CONTOURS;
+    frame.encoding = m_contourEncoding.load(std::memory_order_relaxed);
+    frame.bundle = m_frameBundle.load(std::memory_order_relaxed);
+    frame.keyframe = m_keyframeRequested.exchange(false, std::memory_order_relaxed);
+    frame.keyframeInterval = m_keyframeInterval.load(std::memory_order_relaxed);
+    frame.streamTolerance = m_streamTolerance.load(std::memory_order_relaxed);
+    frame.degradation = degradation;
+    bool larger = frame.marks.raise(contours);
+    frame.contours.copyFrom(contours);
+    m_senderThread.push();
+    return larger;
+}
+
+bool OscManager::sendFourierDescriptors(const FourierDescriptors& descriptors, unsigned long long timestamp)
+{
+    int numCoefficients = descriptors.getNumCoefficients();
+    
+    OscFrame& frame = m_senderThread.getWriteFrame();
+    frame.type = OscFrame::FOURIER_DESCRIPTORS;
+    frame.bundle = m_frameBundle.load(std::memory_order_relaxed);
+    frame.numCoefficients = numCoefficients;
+    frame.contours.clear();
+    frame.contours.setTimestamp(timestamp);
+    bool larger = (frame.labels.capacity() < descriptors.size() || frame.coefficients.capacity() < 2*numCoefficients*descriptors.size());
+    frame.labels.resize(descriptors.size());
+    frame.coefficients.resize(2*numCoefficients*descriptors.size());
+    for(int i = 0; i < descriptors.size(); i++) {
+        frame.labels[i] = descriptors.getLabel(i);
+        std::copy(descriptors.getCoefficients(i), descriptors.getCoefficients(i) + 2*numCoefficients, &frame.coefficients[2*numCoefficients*i]);
+    }
+    m_senderThread.push();
+    return larger;
+}
+
+void OscManager::sendAudioMax(float value)
+{
+    OscFrame& frame = m_senderThread.getMessageFrame();
+    frame.type = OscFrame::AUDIO_MAX;
+    frame.audioMax = value;
+    m_senderThread.pushMessage();
+}
+
+void OscManager::sendMessage(const OscMessage& message)
+{
+    OscFrame& frame = m_senderThread.getMessageFrame();
+    frame.type = OscFrame::MESSAGE;
+    frame.message = message;
+    m_senderThread.pushMessage();
+}
+
+//--------------------------------------------------------------
+
+void OscManager::sendFrame(const OscFrame& frame)
+{
+    unsigned long long time = ofGetSystemTimeMicros();
+    
+    // the audio maximum and other messages are tiny and never rate limited, the frames are limited per destination
+    bool message = (frame.type == OscFrame::AUDIO_MAX || frame.type == OscFrame::MESSAGE);
+    for(int i = 0; i < m_destinations.size(); i++)
+    {
+        OscDestination& destination = m_destinations[i];
+        destination.due = message || this->isFrameDue(destination, time);
+        if(message){
+            continue;
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/BackgroundSubstraction"){
-            bool backgroundSubstraction = ( m.getArgAsInt32(0) != 0);
-            AppManager::getInstance().getGuiManager().setBackgroundSubstraction(backgroundSubstraction);
+        // a destination skipping the frame still owes its renderer the keyframes
+        if(frame.type == OscFrame::CONTOURS && frame.keyframe){
+            destination.streamEncoder->requestKeyframe();
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/SendAllContours"){
-            bool value = ( m.getArgAsInt32(0) != 0);
-            AppManager::getInstance().getGuiManager().setSendAllContours(value);
+        if(destination.due){
+            OscStats::add(destination.numFramesSent, 1);
         }
-        
-        else if(m.getAddress() == "/MurmurContourTracking/ResetBackground"){
-            AppManager::getInstance().getTrackingManager().onResetBackground();
+        else{
+            OscStats::add(destination.numFramesSkipped, 1);
         }
-        
-        else if(m.getAddress() == "/MurmurContourTracking/NearClipping"){
-            int value = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiNearClipping(value);
+    }
+    
+    if(frame.type == OscFrame::CONTOURS){
+        m_frameId++;
+    }
+    
+    this->updateFrameStats(frame);
+    
+    // every encoding is serialised once and sent to all the destinations due a frame in that encoding,
+    // the stream encoding once per destination, as every destination gets deltas against its own frames
+    ProfilerManager& profiler = AppManager::getInstance().getProfilerManager();
+    int numFormats = (frame.type == OscFrame::CONTOURS) ? ENCODING_STREAM + 1 : 1;
+    for(int format = 0; format < numFormats; format++)
+    {
+        bool serialised = false;
+        for(int i = 0; i < m_destinations.size(); i++)
+        {
+            OscDestination& destination = m_destinations[i];
+            if(!destination.due || (frame.type == OscFrame::CONTOURS && this->getEncoding(destination, frame) != format)){
+                continue;
+            }
+            
+            if(!serialised || format == ENCODING_STREAM){
+                ProfileScope scope(profiler, ProfilerManager::STAGE_OSC_SERIALISE);
+                m_streamEncoder = destination.streamEncoder.get();
+                this->serialiseFrame(frame, format);
+                serialised = true;
+            }
+            
+            ProfileScope scope(profiler, ProfilerManager::STAGE_OSC_SEND);
+            this->sendPackets(destination);
         }
+    }
+}
+
+void OscManager::updateFrameStats(const OscFrame& frame)
+{
+    OscStats::add(m_stats.numFrames, 1);
+    
+    switch (frame.type)
+    {
+        case OscFrame::CONTOURS:
+            OscStats::set(m_stats.numContours, int(frame.contours.size()));
+            OscStats::set(m_stats.numVertices, int(frame.contours.getNumVertices()));
+            OscStats::set(m_stats.lastAddress, "/MurmurRenderer/NumContours");
+            break;
+            
+        case OscFrame::FOURIER_DESCRIPTORS:
+            OscStats::set(m_stats.numContours, int(frame.labels.size()));
+            OscStats::set(m_stats.numVertices, 0);
+            OscStats::set(m_stats.lastAddress, "/MurmurRenderer/ContourFourier");
+            break;
+            
+        case OscFrame::AUDIO_MAX:
+            OscStats::set(m_stats.lastAddress, "/MurmurRenderer/AudioMax");
+            break;
+            
+        default:
+            break;
+    }
+}
+
+int OscManager::serialise(const OscFrame& frame, int encoding)
+{
+    m_streamEncoder = &m_contourStreamEncoder;
+    this->serialiseFrame(frame, encoding);
+    return m_packetData.size();
+}
+
+void OscManager::serialiseFrame(const OscFrame& frame, int encoding)
+{
+    m_packetData.clear();
+    m_packetOffsets.assign(1, 0);
+    m_numFrameMessages = 0;
+    
+    switch (frame.type)
+    {
+        case OscFrame::CONTOURS:
+            this->serialiseContourFrame(frame, encoding);
+            break;
+            
+        case OscFrame::FOURIER_DESCRIPTORS:
+            this->serialiseFourierFrame(frame);
+            break;
+            
+        case OscFrame::AUDIO_MAX:
+            this->serialiseAudioMax(frame.audioMax);
+            break;
+            
+        case OscFrame::MESSAGE:
+            this->serialiseMessage(frame.message);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+void OscManager::addPacket(const osc::OutboundPacketStream& p)
+{
+    m_packetData.insert(m_packetData.end(), p.Data(), p.Data() + p.Size());
+    m_packetOffsets.push_back(m_packetData.size());
+}
+
+void OscManager::sendPackets(OscDestination& destination)
+{
+    for(int i = 0; i + 1 < m_packetOffsets.size(); i++)
+    {
+        int size = m_packetOffsets[i+1] - m_packetOffsets[i];
+        destination.sender->sendPacket(&m_packetData[m_packetOffsets[i]], size);
+        OscStats::add(destination.numPackets, 1);
+        OscStats::add(destination.numBytes, size);
+    }
+    
+    OscStats::add(m_stats.numMessages, m_numFrameMessages);
+    OscStats::add(m_stats.numPackets, m_packetOffsets.size() - 1);
+    OscStats::add(m_stats.numBytes, m_packetData.size());
+}
+
+bool OscManager::isFrameDue(OscDestination& destination, unsigned long long time)
+{
+    if(destination.maxRate <= 0){
+        return true;
+    }
+    
+    // a quarter of a period of slack, so that a jittery frame rate doesn't skip every other frame
+    unsigned long long period = 1000000/destination.maxRate;
+    if(time + period/4 < destination.nextFrameTime){
+        return false;
+    }
+    
+    destination.nextFrameTime = max(destination.nextFrameTime + period, time);
+    return true;
+}
+
+int OscManager::getEncoding(const OscDestination& destination, const OscFrame& frame) const
+{
+    return (destination.encoding == ENCODING_PARAMETER) ? frame.encoding : destination.encoding;
+}
+
+void OscManager::serialiseNumberContours(int num)
+{
+    osc::OutboundPacketStream p(&m_packetBuffer[0], m_packetBuffer.size());
+    p << osc::BeginMessage("/MurmurRenderer/NumContours") << (osc::int32) num << osc::EndMessage;
+    m_numFrameMessages++;
+    this->addPacket(p);
+}
+
+void OscManager::serialiseDegradation(int level)
+{
+    osc::OutboundPacketStream p(&m_packetBuffer[0], m_packetBuffer.size());
+    p << osc::BeginMessage("/MurmurRenderer/Degradation") << (osc::int32) level << osc::EndMessage;
+    m_numFrameMessages++;
+    this->addPacket(p);
+}
+
+void OscManager::serialiseContour(const OscFrame& frame, int i, int encoding)
+{
+    const vector<unsigned char>* blob = NULL;
+    int messageSize = this->prepareContour(frame, i, encoding, blob);
+    if(messageSize > m_messageBuffer.size()){
+        ofLogError() <<"OscManager::serialiseContour -> contour " << i << " doesn't fit in the message buffer: " << frame.contours.getNumVertices(i) << " vertices";
+        m_streamEncoder->requestKeyframe();
+        return;
+    }
+    
+    osc::OutboundPacketStream p(&m_messageBuffer[0], m_messageBuffer.size());
+    this->writeContour(p, frame, i, encoding, blob);
+    
+    if(p.Size() > MAX_PACKET_SIZE){
+        this->serialiseFragments(p.Data(), p.Size(), frame.contours.getLabel(i), false, 0);
+        return;
+    }
+    
+    m_numFrameMessages++;
+    this->addPacket(p);
+}
+
+int OscManager::prepareContour(const OscFrame& frame, int i, int encoding, const vector<unsigned char>*& blob)
+{
+    if(encoding != ENCODING_FLOAT){
+        blob = &this->encodeContour(frame.contours, i, encoding);
+        return this->getContourBlobMessageSize(blob->size(), encoding);
+    }
+    
+    blob = NULL;
+    return this->getContourMessageSize(i, frame.contours.getNumVertices(i));
+}
+
+void OscManager::writeContour(osc::OutboundPacketStream& p, const OscFrame& frame, int i, int encoding, const vector<unsigned char>* blob)
+{
+    if(blob){
+        p << osc::BeginMessage(this->getContourBlobAddress(encoding));
+        p << osc::Blob(&(*blob)[0], blob->size());
+        p << osc::EndMessage;
+        return;
+    }
+    
+    const ofVec2f* vertices = frame.contours.getVertices(i);
+    p << osc::BeginMessage(this->getContourAddress(i).c_str());
+    for (int j = 0; j < frame.contours.getNumVertices(i); j++) {
+        p << vertices[j].x / TrackingManager::DEPTH_CAMERA_WIDTH;
+        p << vertices[j].y / TrackingManager::DEPTH_CAMERA_HEIGHT;
+    }
+    p << osc::EndMessage;
+}
+
+void OscManager::serialiseFragments(const char* data, int size, unsigned int label, bool bundle, osc::uint64 timeTag)
+{
+    int count = (size + FRAGMENT_PAYLOAD_SIZE - 1)/FRAGMENT_PAYLOAD_SIZE;
+    
+    for(int index = 0; index < count; index++)
+    {
+        int offset = index*FRAGMENT_PAYLOAD_SIZE;
+        int fragmentSize = min(FRAGMENT_PAYLOAD_SIZE, size - offset);
         
-        else if(m.getAddress() == "/MurmurContourTracking/FarClipping"){
-            int value = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setGuiFarClipping(value);
+        osc::OutboundPacketStream p(&m_fragmentBuffer[0], m_fragmentBuffer.size());
+        if(bundle){
+            p << osc::BeginBundle(timeTag);
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/BlurScale"){
-            float value = m.getArgAsFloat(0);
-            AppManager::getInstance().getGuiManager().setGuiBlurScale(value);
-        }
+        p << osc::BeginMessage("/MurmurRenderer/ContourFragment");
+        p << (osc::int32) m_frameId << (osc::int32) label << (osc::int32) index << (osc::int32) count;
+        p << osc::Blob(data + offset, fragmentSize);
+        p << osc::EndMessage;
+        m_numFrameMessages++;
         
-        else if(m.getAddress() == "/MurmurContourTracking/BlurRotation"){
-            float value = m.getArgAsFloat(0);
-            AppManager::getInstance().getGuiManager().setGuiBlurRotation(value);
+        if(bundle){
+            p << osc::EndBundle;
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/SimplifyContour"){
-            float value = m.getArgAsFloat(0);
-            AppManager::getInstance().getGuiManager().setGuiSimplifyContour(value);
+        this->addPacket(p);
+    }
+}
+
+void OscManager::serialiseContourFrame(const OscFrame& frame, int encoding)
+{
+    // the stream settings come with the frame, the GUI never touches the encoder the sender thread is using
+    if(encoding == ENCODING_STREAM){
+        m_streamEncoder->setKeyframeInterval(frame.keyframeInterval);
+        m_streamEncoder->setTolerance(frame.streamTolerance);
+        if(frame.keyframe){
+            m_streamEncoder->requestKeyframe();
         }
+        m_streamEncoder->beginFrame(frame.contours);
+    }
+    
+    if(frame.bundle){
+        this->serialiseContourBundles(frame, encoding);
+        return;
+    }
+    
+    this->serialiseNumberContours(frame.contours.size());
+    if(frame.degradation >= 0){
+        this->serialiseDegradation(frame.degradation);
+    }
+    
+    for(int i = 0; i < frame.contours.size(); i++) {
+        this->serialiseContour(frame, i, encoding);
+    }
+}
+
+void OscManager::serialiseContourBundles(const OscFrame& frame, int encoding)
+{
+    const ContourSet& contours = frame.contours;
+    osc::uint64 timeTag = getTimeTag(contours.getTimestamp());
+    osc::OutboundPacketStream p(&m_packetBuffer[0], m_packetBuffer.size());
+    
+    p << osc::BeginBundle(timeTag);
+    p << osc::BeginMessage("/MurmurRenderer/NumContours") << (osc::int32) contours.size() << osc::EndMessage;
+    m_numFrameMessages++;
+    if(frame.degradation >= 0){
+        p << osc::BeginMessage("/MurmurRenderer/Degradation") << (osc::int32) frame.degradation << osc::EndMessage;
+        m_numFrameMessages++;
+    }
+    
+    for(int i = 0; i < contours.size(); i++)
+    {
+        const vector<unsigned char>* blob = NULL;
+        int messageSize = this->prepareContour(frame, i, encoding, blob);
         
-        else if(m.getAddress() == "/MurmurContourTracking/SmoothingSize"){
-            float value = m.getArgAsFloat(0);
-            AppManager::getInstance().getGuiManager().setGuiSmoothingSize(value);
+        if(messageSize > m_messageBuffer.size()){
+            ofLogError() <<"OscManager::serialiseContourBundles -> contour " << i << " doesn't fit in the message buffer: " << contours.getNumVertices(i) << " vertices";
+            m_streamEncoder->requestKeyframe();
+            continue;
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/SmoothingShape"){
-            float value = m.getArgAsFloat(0);
-            AppManager::getInstance().getGuiManager().setGuiSmoothingShape(value);
+        // contours that don't fit in a packet on their own are sent as fragments with the same time tag
+        if(BUNDLE_HEADER_SIZE + messageSize > MAX_PACKET_SIZE){
+            osc::OutboundPacketStream m(&m_messageBuffer[0], m_messageBuffer.size());
+            this->writeContour(m, frame, i, encoding, blob);
+            this->serialiseFragments(m.Data(), m.Size(), contours.getLabel(i), true, timeTag);
+            continue;
         }
         
-        else if(m.getAddress() == "/MurmurContourTracking/CropBottom"){
-            int value = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setCropBottom(value);
-        }
+        this->reserveBundleSpace(p, messageSize, timeTag);
+        this->writeContour(p, frame, i, encoding, blob);
+        m_numFrameMessages++;
+    }
+    
+    this->closeBundle(p);
+}
 
-        else if(m.getAddress() == "/MurmurContourTracking/CropLeft"){
-            int value = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setCropLeft(value);
-        }
-        
-        else if(m.getAddress() == "/MurmurContourTracking/CropRight"){
-            int value = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setCropRight(value);
-        }
-        
-        else if(m.getAddress() == "/MurmurContourTracking/CropTop"){
-            int value = m.getArgAsInt32(0);
-            AppManager::getInstance().getGuiManager().setCropTop(value);
+void OscManager::serialiseFourierFrame(const OscFrame& frame)
+{
+    int numContours = frame.labels.size();
+    int numCoefficients = frame.numCoefficients;
+    
+    if(!frame.bundle){
+        this->serialiseNumberContours(numContours);
+        for(int i = 0; i < numContours; i++)
+        {
+            this->setFourierMessage(frame, i);
+            osc::OutboundPacketStream p(&m_packetBuffer[0], m_packetBuffer.size());
+            m_fourierMessage.serialise(p);
+            m_numFrameMessages++;
+            this->addPacket(p);
         }
+        return;
+    }
+    
+    osc::uint64 timeTag = getTimeTag(frame.contours.getTimestamp());
+    osc::OutboundPacketStream p(&m_packetBuffer[0], m_packetBuffer.size());
+    
+    p << osc::BeginBundle(timeTag);
+    p << osc::BeginMessage("/MurmurRenderer/NumContours") << (osc::int32) numContours << osc::EndMessage;
+    m_numFrameMessages++;
+    
+    for(int i = 0; i < numContours; i++)
+    {
+        this->setFourierMessage(frame, i);
+        this->reserveBundleSpace(p, m_fourierMessage.getSize(true), timeTag);
+        m_fourierMessage.serialise(p);
+        m_numFrameMessages++;
+    }
+    
+    this->closeBundle(p);
+}
+
+void OscManager::setFourierMessage(const OscFrame& frame, int i)
+{
+    int numCoefficients = frame.numCoefficients;
+    
+    m_fourierMessage.clear();
+    m_fourierMessage.setAddress("/MurmurRenderer/ContourFourier");
+    m_fourierMessage.addIntArg(frame.labels[i]);
+    m_fourierMessage.addFloatArgs(&frame.coefficients[2*numCoefficients*i], 2*numCoefficients);
+    OscStats::set(m_stats.numMessageAllocations, m_fourierMessage.getNumAllocations());
+}
+
+void OscManager::serialiseAudioMax(float value)
+{
+    osc::OutboundPacketStream p(&m_packetBuffer[0], m_packetBuffer.size());
+    p << osc::BeginMessage("/MurmurRenderer/AudioMax") << value << osc::EndMessage;
+    m_numFrameMessages++;
+    this->addPacket(p);
+}
+
+void OscManager::serialiseMessage(const OscMessage& message)
+{
+    osc::OutboundPacketStream p(&m_packetBuffer[0], m_packetBuffer.size());
+    message.serialise(p);
+    m_numFrameMessages++;
+    this->addPacket(p);
+}
 
+void OscManager::reserveBundleSpace(osc::OutboundPacketStream& p, int messageSize, osc::uint64 timeTag)
+{
+    // start a new bundle with the same time tag when the message would push this one past the MTU
+    if(p.Size() > BUNDLE_HEADER_SIZE && p.Size() + messageSize > MAX_PACKET_SIZE){
+        this->closeBundle(p);
+        p.Clear();
+        p << osc::BeginBundle(timeTag);
     }
 }
 
-void OscManager::draw()
+void OscManager::closeBundle(osc::OutboundPacketStream& p)
 {
-    m_sendingInformation->draw();
-    m_receivingInformation->draw();
+    p << osc::EndBundle;
+    this->addPacket(p);
 }
 
-void OscManager::sendNumberContours(int num)
+int OscManager::getContourMessageSize(int i, int numVertices)
 {
-    ofxOscMessage m;
-    m.setAddress("/MurmurRenderer/NumContours");
-    m.addIntArg(num);
-    m_oscSender.sendMessage(m);
-    m_latestOscMessage = m;
-    this->updateSendText();
+    // element size, padded address, padded type tags (',' + 'f' per argument + '\0') and the float arguments
+    int addressSize = this->getContourAddress(i).size() + 1;
+    int typeTagsSize = 2*numVertices + 2;
+    return 4 + ((addressSize + 3) & ~3) + ((typeTagsSize + 3) & ~3) + 8*numVertices;
 }
 
-void OscManager::sendContour(const ofPolyline& contour, int i)
+const vector<unsigned char>& OscManager::encodeContour(const ContourSet& contours, int i, int encoding)
 {
-    string contourAddr = "/MurmurRenderer/Contour/" + ofToString(i);
-    ofxOscMessage m;
-    m.setAddress(contourAddr);
+    if(encoding == ENCODING_STREAM){
+        return m_streamEncoder->encode(contours, i);
+    }
     
-    for (ofPoint blobPoint : contour.getVertices()) {
-        m.addFloatArg(blobPoint.x / TrackingManager::DEPTH_CAMERA_WIDTH);
-        m.addFloatArg(blobPoint.y / TrackingManager::DEPTH_CAMERA_HEIGHT);
+    m_contourEncoder.setEncoding(encoding);
+    return m_contourEncoder.encode(contours, i);
+}
+
+const char* OscManager::getContourBlobAddress(int encoding) const
+{
+    if(encoding == ENCODING_STREAM){
+        return "/MurmurRenderer/ContourStream";
     }
     
-    m_oscSender.sendMessage(m);
-    //m_latestOscMessage = m;
-    //this->updateSendText();
+    return "/MurmurRenderer/ContourBlob";
 }
 
-void OscManager::sendAudioMax(float value)
+int OscManager::getContourBlobMessageSize(int blobSize, int encoding) const
+{
+    // element size, padded address, ",b" type tags, blob size and padded blob
+    int addressSize = strlen(this->getContourBlobAddress(encoding)) + 1;
+    return 4 + ((addressSize + 3) & ~3) + 4 + 4 + ((blobSize + 3) & ~3);
+}
+
+const string& OscManager::getContourAddress(int i)
 {
-    ofxOscMessage m;
-    m.setAddress("/MurmurRenderer/AudioMax");
-    m.addFloatArg(value);
-    m_oscSender.sendMessage(m);
-    m_latestOscMessage = m;
-    this->updateSendText();
+    while(m_contourAddresses.size() <= i){
+        m_contourAddresses.push_back("/MurmurRenderer/Contour/" + ofToString(m_contourAddresses.size()));
+    }
+    
+    return m_contourAddresses[i];
+}
+
+int OscManager::getEncoding(const string& name) const
+{
+    if(name == "float"){
+        return ENCODING_FLOAT;
+    }
+    else if(name == "quantized"){
+        return ENCODING_QUANTIZED;
+    }
+    else if(name == "delta"){
+        return ENCODING_DELTA;
+    }
+    else if(name == "stream"){
+        return ENCODING_STREAM;
+    }
+    
+    return ENCODING_PARAMETER;
+}
+
+osc::uint64 OscManager::getTimeTag(unsigned long long timestamp)
+{
+    // NTP format: seconds since 1900 in the high word, fraction of a second in the low word
+    static const osc::uint64 SECONDS_FROM_1900_TO_1970 = 2208988800ULL;
+    
+    osc::uint64 seconds = timestamp/1000000 + SECONDS_FROM_1900_TO_1970;
+    osc::uint64 fraction = ((timestamp%1000000) << 32)/1000000;
+    return (seconds << 32) | fraction;
+}
+
+int OscManager::getContourVertexBudget(int numBytes, int numContours) const
+{
+    int contourEncoding = m_contourEncoding.load(std::memory_order_relaxed);
+    if(contourEncoding == ENCODING_STREAM){
+        // keyframes cost as much as delta encoded blobs, with a longer header
+        int overhead = this->getContourBlobMessageSize(ContourStreamDecoder::HEADER_SIZE, ENCODING_STREAM) + 3;
+        int budget = (numBytes - numContours*overhead)/ContourEncoder::getVertexSize(ENCODING_DELTA);
+        return max(budget, 0);
+    }
+    
+    if(contourEncoding != ENCODING_FLOAT){
+        int budget = (numBytes - numContours*CONTOUR_BLOB_OVERHEAD)/ContourEncoder::getVertexSize(contourEncoding);
+        return max(budget, 0);
+    }
+    
+    // every vertex is two float arguments: 8 bytes of data and 2 bytes of type tags
+    int budget = (numBytes - numContours*CONTOUR_MESSAGE_OVERHEAD)/CONTOUR_VERTEX_SIZE;
+    return max(budget, 0);
 }
 
-void OscManager::updateSendText()
+int OscManager::getFrameVertexBudget(int numBytes, int numContours) const
 {
-    int portSend = AppManager::getInstance().getSettingsManager().getPortSend();
-    string host = AppManager::getInstance().getSettingsManager().getIpAddress();
-    string text = ">> OSC sending -> Host: " + host + ", Port: " + ofToString(portSend);
+    return this->getContourVertexBudget(numBytes - NUM_CONTOURS_MESSAGE_SIZE, numContours);
+}
+
+void OscManager::onContourEncodingChange(int & value)
+{
+    m_contourEncoding.store(ofClamp(value, ENCODING_FLOAT, ENCODING_STREAM), std::memory_order_relaxed);
     
-    text += ("\n   " + this->getMessageAsString(m_latestOscMessage));
+    // the renderer has to start from keyframes again
+    m_keyframeRequested.store(true, std::memory_order_relaxed);
+}
+
+void OscManager::updateSendText(float elapsedTime)
+{
+    unsigned int numMessages = OscStats::get(m_stats.numMessages);
+    unsigned int numPackets = OscStats::get(m_stats.numPackets);
+    unsigned int numBytes = OscStats::get(m_stats.numBytes);
+    
+    // the counters wrap around, their differences don't
+    float messageRate = (numMessages - OscStats::get(m_previousStats.numMessages))/elapsedTime;
+    float packetRate = (numPackets - OscStats::get(m_previousStats.numPackets))/elapsedTime;
+    float byteRate = (numBytes - OscStats::get(m_previousStats.numBytes))/elapsedTime;
+    OscStats::set(m_previousStats.numMessages, numMessages);
+    OscStats::set(m_previousStats.numPackets, numPackets);
+    OscStats::set(m_previousStats.numBytes, numBytes);
+    
+    string text = ">> OSC sending";
+    
+    for(int i = 0; i < m_destinations.size(); i++)
+    {
+        const OscDestination& destination = m_destinations[i];
+        text += ("\n   " + destination.name + " -> Host: " + destination.host + ", Port: " + ofToString(destination.port) +
+                 ", frames: " + ofToString(OscStats::get(destination.numFramesSent)) + ", skipped: " + ofToString(OscStats::get(destination.numFramesSkipped)) +
+                 ", packets: " + ofToString(OscStats::get(destination.numPackets)) + ", kB: " + ofToString(OscStats::get(destination.numBytes)/1024));
+    }
+    
+    text += ("\n   Messages/s: " + ofToString(messageRate, 0) + ", packets/s: " + ofToString(packetRate, 0) +
+             ", kB/s: " + ofToString(byteRate/1024, 1));
+    text += ("\n   Last frame: " + string(OscStats::get(m_stats.lastAddress)) + ", contours: " + ofToString(OscStats::get(m_stats.numContours)) +
+             ", vertices: " + ofToString(OscStats::get(m_stats.numVertices)));
+    text += ("\n   Frames queued: " + ofToString(m_senderThread.getNumQueued()) + ", sent: " + ofToString(m_senderThread.getNumSent()) +
+             ", dropped: " + ofToString(m_senderThread.getNumDropped()) + ", messages dropped: " + ofToString(m_senderThread.getNumMessagesDropped()));
+    text += ("\n   Message allocations: " + ofToString(OscStats::get(m_stats.numMessageAllocations)));
     m_sendingInformation->setText(text);
 }
 
-void OscManager::updateReceiveText()
+void OscManager::updateReceiveText(float elapsedTime)
 {
+    unsigned int numReceived = m_receiverThread.getNumReceived();
+    float messageRate = (numReceived - m_previousNumReceived)/elapsedTime;
+    m_previousNumReceived = numReceived;
+    
     int porReceive = AppManager::getInstance().getSettingsManager().getPortReceive();
     string text = ">> OSC receiving -> Port: " + ofToString(porReceive);
     
-    text += ("\n   " + this->getMessageAsString(m_latestOscMessage));
+    text += ("\n   Last: " + this->getMessageAsString(m_latestOscMessage));
+    text += ("\n   Messages/s: " + ofToString(messageRate, 0) + ", received: " + ofToString(numReceived) +
+             ", dropped: " + ofToString(m_receiverThread.getNumDropped()));
     m_receivingInformation->setText(text);
 }
 
 
-string OscManager::getMessageAsString(const ofxOscMessage& m) const
+string OscManager::getMessageAsString(const OscControlMessage& m) const
 {
     string msg_string;
-    msg_string = m.getAddress();
-    for(int i = 0; i < m.getNumArgs(); i++){
-        // get the argument type
+    msg_string = m.address;
+    for(int i = 0; i < m.numArgs; i++){
         msg_string += " ";
-        // display the argument - make sure we get the right type
-        if(m.getArgType(i) == OFXOSC_TYPE_INT32){
-            msg_string += ofToString(m.getArgAsInt32(i));
-        }
-        else if(m.getArgType(i) == OFXOSC_TYPE_FLOAT){
-            msg_string += ofToString(m.getArgAsFloat(i));
+        if(m.types[i] == osc::FLOAT_TYPE_TAG){
+            msg_string += ofToString(m.floats[i]);
         }
-        else if(m.getArgType(i) == OFXOSC_TYPE_STRING){
-            msg_string += m.getArgAsString(i);
+        else if(m.types[i] == osc::INT32_TYPE_TAG){
+            msg_string += ofToString(m.ints[i]);
         }
         else{
             msg_string += "unknown";
@@ -9,16 +9,34 @@
 
 #pragma once
 
+#include <atomic>
 #include "ofMain.h"
 #include "Manager.h"
 #include "ofxOsc.h"
 #include "TextVisual.h"
+#include "ContourSet.h"
+#include "ContourEncoder.h"
+#include "ContourStreamEncoder.h"
+#include "FourierDescriptors.h"
+#include "OscSenderThread.h"
+#include "OscDestination.h"
+#include "OscReceiverThread.h"
+#include "OscMessage.h"
+#include "OscStats.h"
+
+class GuiManager;
 
 //========================== class OscManager =======================================
 //==============================================================================
 /** \class OscManager OscManager.h
  *	\brief class for managing the OSC events
- *	\details It reads all the OSC events and create the proper application events
+ *	\details It reads all the OSC events and create the proper application events.
+ *    The received messages are dispatched through a hash table built from the
+ *    parameter registry, and only the latest value of every address is applied
+ *    each frame.
+ *    Every frame is serialised once per contour encoding and sent to all the
+ *    destinations using that encoding that are due a frame, except for the stream
+ *    encoding, which is serialised for every destination against what it was sent.
  */
 
 
@@ -26,6 +44,25 @@ class OscManager: public Manager
 {
 
 public:
+    
+    static const int MAX_PACKET_SIZE;           ///< maximum UDP payload that fits in an ethernet MTU
+    static const int CONTOUR_MESSAGE_OVERHEAD;  ///< bytes of a contour datagram that don't depend on its vertices
+    static const int CONTOUR_VERTEX_SIZE;       ///< bytes added to a contour datagram by each vertex
+    static const int PACKET_BUFFER_SIZE;        ///< size of the buffer the contour messages are serialised into
+    static const int CONTOUR_BLOB_OVERHEAD;     ///< bytes of a contour blob datagram that don't depend on its vertices
+    static const int NUM_CONTOURS_MESSAGE_SIZE; ///< bytes of the NumContours message starting every frame, as a bundle element
+    static const int BUNDLE_HEADER_SIZE;        ///< bytes of the "#bundle" string and the time tag
+    static const int FRAGMENT_PAYLOAD_SIZE;     ///< bytes of a serialised contour message carried by each fragment
+    static const float STATS_REFRESH_RATE;      ///< times per second the statistics are shown
+    
+    enum ContourEncoding {
+        ENCODING_PARAMETER = -1,                        ///< whatever the ContourEncoding parameter is set to
+        ENCODING_FLOAT = 0,                             ///< normalised float arguments
+        ENCODING_QUANTIZED = ContourDecoder::QUANTIZED, ///< blob of uint16 sensor coordinates
+        ENCODING_DELTA = ContourDecoder::DELTA,         ///< blob of int8 deltas from the previous vertex
+        ENCODING_STREAM = 3                             ///< blob of keyframes and per-label deltas from the previous frame
+    };
+    
     //! Constructor
     OscManager();
 
@@ -41,18 +78,73 @@ public:
     //! draws the manager
     void draw();
     
-    //! send number of contours
-    void sendNumberContours(int num);
+    //! queues all the contours of a frame to be sent with the degradation level of the send budget, if any, from the tracking emit thread only. Returns whether the queue slot had to grow
+    bool sendContours(const ContourSet& contours, int degradation = -1);
+    
+    //! queues the Fourier descriptors of all the contours of a frame captured at the given time, from the tracking emit thread only. Returns whether the queue slot had to grow
+    bool sendFourierDescriptors(const FourierDescriptors& descriptors, unsigned long long timestamp);
+    
+    //! serialises and sends a queued frame, called from the sender thread
+    void sendFrame(const OscFrame& frame);
+    
+    //! serialises a frame in the given encoding without sending it and returns its size in bytes, used by the micro benchmarks
+    int serialise(const OscFrame& frame, int encoding);
+    
+    //! Frame bundle toggle change controlled by GUI
+    void onFrameBundleChange(bool & value) {m_frameBundle.store(value, std::memory_order_relaxed);}
     
-    //! send contour
-    void sendContour(const ofPolyline& contour, int i);
+    //! Contour encoding change controlled by GUI
+    void onContourEncodingChange(int & value);
     
-    //! send audio maximum
+    //! Keyframe interval change controlled by GUI, passed to the stream encoder with the next frame
+    void onKeyframeIntervalChange(int & value) {m_keyframeInterval.store(value, std::memory_order_relaxed);}
+    
+    //! Stream tolerance change controlled by GUI, passed to the stream encoder with the next frame
+    void onStreamToleranceChange(float & value) {m_streamTolerance.store(value, std::memory_order_relaxed);}
+    
+    //! queues the audio maximum to be sent, from the render thread only
     void sendAudioMax(float value);
+    
+    //! queues a message to be sent to every destination, from the render thread only
+    void sendMessage(const OscMessage& message);
+    
+    //! returns the maximum number of vertices that fit in the given number of bytes of contour datagrams
+    int getContourVertexBudget(int numBytes, int numContours = 1) const;
+    
+    //! returns the maximum number of vertices of a frame of contours that fits in the given number of bytes, NumContours message included
+    int getFrameVertexBudget(int numBytes, int numContours) const;
+    
+    //! returns the OSC time tag of the given time, in microseconds since the epoch
+    static osc::uint64 getTimeTag(unsigned long long timestamp);
 
 
 private:
     
+    enum ParameterType {
+        PARAMETER_INT,
+        PARAMETER_FLOAT,
+        PARAMETER_BOOL,
+        PARAMETER_ACTION
+    };
+    
+    //! A GUI parameter or an action controlled through OSC, with its latest received value
+    struct OscParameter
+    {
+        string              address;                        ///< full OSC address
+        unsigned int        hash;                           ///< hash of the address
+        int                 type;                           ///< which of the handlers is set
+        void (GuiManager::*setInt)(int);                    ///< setter of integer parameters
+        void (GuiManager::*setFloat)(float);                ///< setter of float parameters
+        void (GuiManager::*setBool)(bool);                  ///< setter of boolean parameters
+        void (OscManager::*action)();                       ///< handler of actions
+        bool                pending;                        ///< whether a value was received this frame
+        OscControlMessage   message;                        ///< latest message received this frame
+        
+        OscParameter(const string& name, int type): address("/MurmurContourTracking/" + name),
+            hash(OscReceiverThread::getHash(address.c_str())), type(type), setInt(NULL), setFloat(NULL),
+            setBool(NULL), action(NULL), pending(false) {}
+    };
+    
     //! sets upt the osc receiver
     void setupOscReceiver();
     
@@ -62,21 +154,173 @@ private:
     //! setups the text visuals
     void setupText();
     
-    //! updates the sending information text visuals
-    void updateSendText();
+    //! refreshes the statistics at STATS_REFRESH_RATE
+    void updateStats();
+    
+    //! updates the sending information text visuals with the rates since the last update
+    void updateSendText(float elapsedTime);
     
-    //! updates receiving information text visuals
-    void updateReceiveText();
+    //! updates receiving information text visuals with the rates since the last update
+    void updateReceiveText(float elapsedTime);
+    
+    //! updates the frame gauges and counters, called from the sender thread
+    void updateFrameStats(const OscFrame& frame);
     
     //! gets string formatted OSC message
-    string getMessageAsString(const ofxOscMessage& m) const;
+    string getMessageAsString(const OscControlMessage& m) const;
+    
+    //! drains the received messages and applies the latest value of every address
+    void receiveMessages();
+    
+    //! registers all the parameters and actions controlled through OSC
+    void setupParameters();
+    
+    //! registers an integer GUI parameter under /MurmurContourTracking/name
+    void addParameter(const string& name, void (GuiManager::*setter)(int));
+    
+    //! registers a float GUI parameter under /MurmurContourTracking/name
+    void addParameter(const string& name, void (GuiManager::*setter)(float));
+    
+    //! registers a boolean GUI parameter under /MurmurContourTracking/name
+    void addParameter(const string& name, void (GuiManager::*setter)(bool));
+    
+    //! registers an action under /MurmurContourTracking/name
+    void addParameter(const string& name, void (OscManager::*action)());
+    
+    //! builds the hash table of the registered parameters
+    void setupParameterTable();
+    
+    //! returns the index of the parameter the message is addressed to, -1 if there is none
+    int findParameter(const OscControlMessage& message) const;
+    
+    //! returns the index of the parameter with the given address, -1 if there is none
+    int findParameter(unsigned int hash, const char* address) const;
+    
+    //! applies the latest received value of a parameter
+    void applyParameter(const OscParameter& parameter);
+    
+    //! asks the stream encoder for keyframes
+    void requestKeyframe();
+    
+    //! resets the background of the tracking
+    void resetBackground();
+    
+    //! dumps the profile of the pipeline as CSV
+    void dumpProfileCsv();
+    
+    //! dumps the profile of the pipeline as JSON
+    void dumpProfileJson();
+    
+    //! creates the destination of the network settings and the additional ones
+    void setupDestinations();
+    
+    //! serialises a frame in the given contour encoding into the packet list
+    void serialiseFrame(const OscFrame& frame, int encoding);
+    
+    //! appends a serialised packet to the packet list
+    void addPacket(const osc::OutboundPacketStream& p);
+    
+    //! sends all the packets of the packet list to the destination
+    void sendPackets(OscDestination& destination);
+    
+    //! returns whether the rate limit of the destination lets a frame through at the given time
+    bool isFrameDue(OscDestination& destination, unsigned long long time);
+    
+    //! returns the contour encoding the frame has to be sent to the destination with
+    int getEncoding(const OscDestination& destination, const OscFrame& frame) const;
+    
+    //! returns the contour encoding of the given name, ENCODING_PARAMETER if empty
+    int getEncoding(const string& name) const;
+    
+    //! serialises the number of contours
+    void serialiseNumberContours(int num);
+    
+    //! serialises the degradation level of the send budget
+    void serialiseDegradation(int level);
+    
+    //! serialises a contour, in fragments if it doesn't fit in a packet
+    void serialiseContour(const OscFrame& frame, int i, int encoding);
+    
+    //! encodes the given contour if needed and returns the serialised size of its message in a bundle
+    int prepareContour(const OscFrame& frame, int i, int encoding, const vector<unsigned char>*& blob);
+    
+    //! serialises the message of the given contour
+    void writeContour(osc::OutboundPacketStream& p, const OscFrame& frame, int i, int encoding, const vector<unsigned char>* blob);
+    
+    //! splits a serialised contour message into numbered fragments that fit in a packet
+    void serialiseFragments(const char* data, int size, unsigned int label, bool bundle, osc::uint64 timeTag);
+    
+    //! serialises the contours of a frame
+    void serialiseContourFrame(const OscFrame& frame, int encoding);
+    
+    //! serialises the frame as bundles time tagged with the capture time, each one fitting in a packet
+    void serialiseContourBundles(const OscFrame& frame, int encoding);
+    
+    //! serialises the Fourier descriptors of a frame
+    void serialiseFourierFrame(const OscFrame& frame);
+    
+    //! builds the Fourier descriptors message of the given contour
+    void setFourierMessage(const OscFrame& frame, int i);
+    
+    //! serialises the audio maximum
+    void serialiseAudioMax(float value);
+    
+    //! serialises any other message
+    void serialiseMessage(const OscMessage& message);
+    
+    //! closes the bundle being serialised and starts a new one if the message would not fit in the packet
+    void reserveBundleSpace(osc::OutboundPacketStream& p, int messageSize, osc::uint64 timeTag);
+    
+    //! closes the bundle being serialised and appends it to the packet list
+    void closeBundle(osc::OutboundPacketStream& p);
+    
+    //! returns the serialised size of a contour message
+    int getContourMessageSize(int i, int numVertices);
+    
+    //! encodes the given contour with the given blob encoding
+    const vector<unsigned char>& encodeContour(const ContourSet& contours, int i, int encoding);
+    
+    //! returns the address of the contour blob messages of the given encoding
+    const char* getContourBlobAddress(int encoding) const;
+    
+    //! returns the serialised size of a contour blob message
+    int getContourBlobMessageSize(int blobSize, int encoding) const;
+    
+    //! returns the address of the given contour, created once
+    const string& getContourAddress(int i);
 
 
  private:
     
-     ofxOscReceiver m_oscReceiver;          ///< OSC receiver class
-     ofxOscSender   m_oscSender;            ///< OSC sender class
-     ofxOscMessage  m_latestOscMessage;    ///< latest OSC message
+     OscReceiverThread m_receiverThread;    ///< listens for OSC messages away from the render thread
+     vector<OscParameter> m_parameters;     ///< registry of the parameters controlled through OSC
+     vector<int>    m_parameterTable;      ///< hash table of parameter indices, -1 for empty slots
+     vector<int>    m_pendingParameters;   ///< parameters received this frame, in arrival order
+     vector<OscDestination> m_destinations; ///< hosts the frames are sent to
+     OscControlMessage m_latestOscMessage; ///< latest OSC message received
+     OscMessage     m_fourierMessage;      ///< reusable Fourier descriptors message, built on the sender thread
+     OscStats       m_stats;               ///< counters and gauges of the traffic sent
+     OscStats       m_previousStats;       ///< counters at the last refresh of the statistics
+     float          m_statsTime;           ///< time of the last refresh of the statistics
+     unsigned int   m_previousNumReceived; ///< messages received at the last refresh of the statistics
+     int            m_numFrameMessages;    ///< messages of the frame being serialised
+    
+     vector<char>   m_packetBuffer;        ///< preallocated buffer the frame bundles are serialised into
+     vector<char>   m_messageBuffer;       ///< preallocated buffer the contours too big for a packet are serialised into
+     vector<char>   m_fragmentBuffer;      ///< preallocated buffer the fragments are serialised into
+     vector<char>   m_packetData;          ///< packets of the frame being sent, one after the other
+     vector<int>    m_packetOffsets;       ///< start of every packet of the frame, plus the end of the last one
+     int            m_frameId;             ///< id of the contour frame being sent, carried by its fragments
+     vector<string> m_contourAddresses;    ///< precomputed contour addresses
+     std::atomic<bool>  m_frameBundle;     ///< defines whether to send each frame as a single time tagged bundle
+     std::atomic<int>   m_contourEncoding; ///< wire format of the contours
+     std::atomic<int>   m_keyframeInterval;    ///< frames between keyframes of the stream encoding, set by the GUI
+     std::atomic<float> m_streamTolerance;     ///< distance a vertex has to move to be sent by the stream encoding, set by the GUI
+     ContourEncoder m_contourEncoder;      ///< packs the contours into blobs
+     ContourStreamEncoder m_contourStreamEncoder;  ///< packs the contours into keyframes and deltas when serialising outside of the destinations
+     ContourStreamEncoder* m_streamEncoder;        ///< stream encoder of the frame being serialised, only used by the sender thread
+     std::atomic<bool>  m_keyframeRequested;   ///< whether the next contour frame has to start from keyframes
+     OscSenderThread m_senderThread;       ///< serialises and sends the frames away from the render thread
     
      ofPtr<TextVisual>     m_sendingInformation;
      ofPtr<TextVisual>     m_receivingInformation;
@@ -0,0 +1,182 @@
+/*
+ *  OscMessage.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include <cassert>
+
+#include "OscMessage.h"
+
+
+OscMessage::OscMessage(): m_numAllocations(0)
+{
+    //Intentionally left empty
+}
+
+
+OscMessage::~OscMessage()
+{
+    //Intentionally left empty
+}
+
+
+void OscMessage::clear()
+{
+    m_address.clear();
+    m_typeTags.clear();
+    m_args.clear();
+    m_blobData.clear();
+}
+
+void OscMessage::reserve(int numArgs, int numBlobBytes)
+{
+    m_typeTags.reserve(numArgs);
+    m_args.reserve(numArgs);
+    m_blobData.reserve(numBlobBytes);
+}
+
+void OscMessage::setAddress(const char* address)
+{
+    size_t length = strlen(address);
+    if(length > m_address.capacity()){
+        m_numAllocations++;
+    }
+    
+    m_address.assign(address, length);
+}
+
+void OscMessage::addIntArg(int value)
+{
+    this->grow(m_args, 1);
+    this->grow(m_typeTags, 1);
+    
+    Argument argument;
+    argument.i = value;
+    m_args.push_back(argument);
+    m_typeTags.push_back(osc::INT32_TYPE_TAG);
+}
+
+void OscMessage::addFloatArg(float value)
+{
+    this->grow(m_args, 1);
+    this->grow(m_typeTags, 1);
+    
+    Argument argument;
+    argument.f = value;
+    m_args.push_back(argument);
+    m_typeTags.push_back(osc::FLOAT_TYPE_TAG);
+}
+
+void OscMessage::addFloatArgs(const float* values, int n)
+{
+    this->grow(m_args, n);
+    this->grow(m_typeTags, n);
+    
+    int first = m_args.size();
+    m_args.resize(first + n);
+    m_typeTags.resize(first + n, osc::FLOAT_TYPE_TAG);
+    for(int i = 0; i < n; i++) {
+        m_args[first + i].f = values[i];
+    }
+}
+
+void OscMessage::addBlobArg(const void* data, int size)
+{
+    this->grow(m_args, 1);
+    this->grow(m_typeTags, 1);
+    this->grow(m_blobData, size);
+    
+    Argument argument;
+    argument.blob.offset = m_blobData.size();
+    argument.blob.size = size;
+    m_args.push_back(argument);
+    m_typeTags.push_back(osc::BLOB_TYPE_TAG);
+    
+    const char* bytes = (const char*) data;
+    m_blobData.insert(m_blobData.end(), bytes, bytes + size);
+}
+
+void OscMessage::addStringArg(const char* value)
+{
+    int size = strlen(value) + 1;
+    this->grow(m_args, 1);
+    this->grow(m_typeTags, 1);
+    this->grow(m_blobData, size);
+    
+    Argument argument;
+    argument.blob.offset = m_blobData.size();
+    argument.blob.size = size;
+    m_args.push_back(argument);
+    m_typeTags.push_back(osc::STRING_TYPE_TAG);
+    
+    m_blobData.insert(m_blobData.end(), value, value + size);
+}
+
+int OscMessage::getSize(bool bundleElement) const
+{
+    // address + '\0' and ',' + type tags + '\0', both padded to 4 bytes, then every argument padded to 4 bytes
+    int size = ((m_address.size() + 4) & ~3) + ((m_typeTags.size() + 5) & ~3);
+    for(int i = 0; i < m_typeTags.size(); i++)
+    {
+        switch (m_typeTags[i])
+        {
+            case osc::BLOB_TYPE_TAG:
+                size += 4 + ((m_args[i].blob.size + 3) & ~3);
+                break;
+                
+            case osc::STRING_TYPE_TAG:
+                size += (m_args[i].blob.size + 3) & ~3;
+                break;
+                
+            default:
+                size += 4;
+                break;
+        }
+    }
+    
+    return bundleElement ? size + 4 : size;
+}
+
+void OscMessage::serialise(osc::OutboundPacketStream& p) const
+{
+#ifdef DEBUG
+    // the bundles are packed by the predicted size, so it has to match what oscpack writes
+    int start = p.Size();
+    bool bundleElement = p.IsBundleInProgress();
+#endif
+    
+    p << osc::BeginMessage(m_address.c_str());
+    for(int i = 0; i < m_typeTags.size(); i++)
+    {
+        switch (m_typeTags[i])
+        {
+            case osc::INT32_TYPE_TAG:
+                p << (osc::int32) m_args[i].i;
+                break;
+                
+            case osc::FLOAT_TYPE_TAG:
+                p << m_args[i].f;
+                break;
+                
+            case osc::BLOB_TYPE_TAG:
+                p << osc::Blob(&m_blobData[m_args[i].blob.offset], m_args[i].blob.size);
+                break;
+                
+            case osc::STRING_TYPE_TAG:
+                p << &m_blobData[m_args[i].blob.offset];
+                break;
+                
+            default:
+                break;
+        }
+    }
+    p << osc::EndMessage;
+    
+#ifdef DEBUG
+    assert(int(p.Size()) - start == this->getSize(bundleElement));
+#endif
+}
+
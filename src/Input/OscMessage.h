@@ -0,0 +1,121 @@
+/*
+ *  OscMessage.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "OscOutboundPacketStream.h"
+
+
+//========================== class OscMessage ==============================
+//============================================================================
+/** \class OscMessage OscMessage.h
+ *	\brief OSC message with its arguments stored contiguously
+ *	\details Unlike ofxOscMessage, which allocates every argument on the heap, the
+ *    type tags, the numeric arguments and the blob bytes live in three arrays that
+ *    keep their capacity when the message is cleared. Once the message has grown
+ *    to the size of the largest one built, building it again allocates nothing.
+ */
+
+class OscMessage
+{
+
+public:
+
+    //! Constructor
+    OscMessage();
+
+    //! Destructor
+    ~OscMessage();
+
+    //! Removes the address and the arguments, keeping the allocated memory
+    void clear();
+
+    //! Reserves memory for the given number of arguments and blob bytes
+    void reserve(int numArgs, int numBlobBytes = 0);
+
+    //! Sets the address of the message
+    void setAddress(const char* address);
+
+    //! Adds an integer argument
+    void addIntArg(int value);
+
+    //! Adds a float argument
+    void addFloatArg(float value);
+
+    //! Adds the given number of float arguments
+    void addFloatArgs(const float* values, int n);
+
+    //! Adds a blob argument
+    void addBlobArg(const void* data, int size);
+    
+    //! Adds a string argument
+    void addStringArg(const char* value);
+
+    //! Returns the address of the message
+    const string& getAddress() const {return m_address;}
+
+    //! Returns the number of arguments
+    int getNumArgs() const {return m_typeTags.size();}
+
+    //! Returns the OSC type tag of the given argument
+    char getArgType(int i) const {return m_typeTags[i];}
+
+    //! Returns the given integer argument
+    int getArgAsInt32(int i) const {return m_args[i].i;}
+
+    //! Returns the given float argument
+    float getArgAsFloat(int i) const {return m_args[i].f;}
+
+    //! Returns the number of bytes of the serialised message, as an element of a bundle if requested
+    int getSize(bool bundleElement = false) const;
+
+    //! Writes the message into the stream
+    void serialise(osc::OutboundPacketStream& p) const;
+
+    //! Returns the number of times the message had to grow its memory
+    unsigned int getNumAllocations() const {return m_numAllocations;}
+
+private:
+
+    //! Counts an allocation if the vector needs to grow to hold n more elements
+    template <class T>
+    void grow(vector<T>& v, int n);
+
+private:
+
+    //! A numeric argument, or the offset and size of a blob or string argument
+    union Argument
+    {
+        int     i;
+        float   f;
+        struct {
+            int offset;
+            int size;
+        } blob;
+    };
+
+    string              m_address;          ///< address of the message
+    vector<char>        m_typeTags;         ///< OSC type tag of every argument
+    vector<Argument>    m_args;             ///< value of every argument
+    vector<char>        m_blobData;         ///< bytes of all the blob and string arguments, one after the other
+    unsigned int        m_numAllocations;   ///< number of times the memory had to grow
+};
+
+
+template <class T>
+void OscMessage::grow(vector<T>& v, int n)
+{
+    if(v.size() + n > v.capacity()){
+        m_numAllocations++;
+    }
+}
+
+//==========================================================================
+
+
@@ -0,0 +1,116 @@
+/*
+ *  OscReceiverThread.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "OscReceiverThread.h"
+
+
+const int OscReceiverThread::QUEUE_CAPACITY = 1024;
+
+
+OscReceiverThread::OscReceiverThread(): m_queue(QUEUE_CAPACITY), m_socket(NULL), m_numReceived(0)
+{
+    //Intentionally left empty
+}
+
+
+OscReceiverThread::~OscReceiverThread()
+{
+    this->stop();
+}
+
+
+void OscReceiverThread::setup(int port)
+{
+    this->stop();
+
+    m_socket = new UdpListeningReceiveSocket(IpEndpointName(IpEndpointName::ANY_ADDRESS, port), this);
+    startThread();
+}
+
+void OscReceiverThread::stop()
+{
+    if(!m_socket){
+        return;
+    }
+
+    m_socket->AsynchronousBreak();
+    waitForThread(true);
+    delete m_socket;
+    m_socket = NULL;
+}
+
+void OscReceiverThread::threadedFunction()
+{
+    m_socket->Run();
+}
+
+void OscReceiverThread::ProcessPacket(const char* data, int size, const IpEndpointName& remoteEndpoint)
+{
+    // a malformed packet would otherwise throw out of the socket loop and end the thread
+    try
+    {
+        osc::OscPacketListener::ProcessPacket(data, size, remoteEndpoint);
+    }
+    catch(osc::Exception& e)
+    {
+        ofLogError() <<"OscReceiverThread::ProcessPacket -> malformed packet of " << size << " bytes: " << e.what();
+    }
+}
+
+void OscReceiverThread::ProcessMessage(const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint)
+{
+    OscControlMessage message;
+    const char* address = m.AddressPattern();
+    message.hash = getHash(address);
+    strncpy(message.address, address, OscControlMessage::MAX_ADDRESS_SIZE - 1);
+    message.address[OscControlMessage::MAX_ADDRESS_SIZE - 1] = '\0';
+    message.numArgs = 0;
+
+    try
+    {
+        osc::ReceivedMessage::const_iterator arg = m.ArgumentsBegin();
+        for(; arg != m.ArgumentsEnd() && message.numArgs < OscControlMessage::MAX_ARGUMENTS; ++arg)
+        {
+            int i = message.numArgs++;
+            message.types[i] = arg->TypeTag();
+            message.ints[i] = 0;
+            message.floats[i] = 0;
+
+            if(arg->IsInt32()){
+                message.ints[i] = arg->AsInt32Unchecked();
+                message.floats[i] = message.ints[i];
+            }
+            else if(arg->IsFloat()){
+                message.floats[i] = arg->AsFloatUnchecked();
+                message.ints[i] = message.floats[i];
+            }
+            else if(arg->IsBool()){
+                message.ints[i] = arg->AsBoolUnchecked();
+                message.floats[i] = message.ints[i];
+            }
+        }
+    }
+    catch(osc::Exception& e)
+    {
+        ofLogError() <<"OscReceiverThread::ProcessMessage -> malformed message " << address << ": " << e.what();
+        return;
+    }
+
+    m_numReceived.fetch_add(1, std::memory_order_relaxed);
+    m_queue.push(message);
+}
+
+unsigned int OscReceiverThread::getHash(const char* address)
+{
+    unsigned int hash = 2166136261u;
+    for(; *address; address++) {
+        hash = (hash ^ (unsigned char) *address) * 16777619u;
+    }
+
+    return hash;
+}
@@ -0,0 +1,101 @@
+/*
+ *  OscReceiverThread.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+#include "OscPacketListener.h"
+#include "UdpSocket.h"
+#include "MessageQueue.h"
+
+
+//========================== struct OscControlMessage ==============================
+//============================================================================
+/** \struct OscControlMessage OscReceiverThread.h
+ *	\brief Fixed size copy of a received control message
+ *	\details Only the numeric arguments are kept, as both an int and a float, which
+ *    is all the control messages carry. The address is hashed on the receiving thread.
+ */
+
+struct OscControlMessage
+{
+    enum {
+        MAX_ADDRESS_SIZE = 64,
+        MAX_ARGUMENTS = 4
+    };
+
+    unsigned int    hash;                       ///< hash of the whole address
+    char            address[MAX_ADDRESS_SIZE];  ///< address, truncated if too long
+    int             numArgs;                    ///< number of arguments kept
+    char            types[MAX_ARGUMENTS];       ///< OSC type tag of every argument
+    int             ints[MAX_ARGUMENTS];        ///< arguments as integers
+    float           floats[MAX_ARGUMENTS];      ///< arguments as floats
+};
+
+
+//========================== class OscReceiverThread ==============================
+//============================================================================
+/** \class OscReceiverThread OscReceiverThread.h
+ *	\brief Listens for OSC control messages on its own thread
+ *	\details The messages are copied into a lock-free queue that the main thread
+ *    drains once per frame, so receiving never takes a lock nor allocates.
+ */
+
+class OscReceiverThread: public ofThread, public osc::OscPacketListener
+{
+
+public:
+
+    static const int QUEUE_CAPACITY;
+
+    //! Constructor
+    OscReceiverThread();
+
+    //! Destructor
+    ~OscReceiverThread();
+
+    //! Starts listening on the given port
+    void setup(int port);
+
+    //! Stops listening and waits for the thread to finish
+    void stop();
+
+    //! Takes the oldest received message, returns false if there is none
+    bool pop(OscControlMessage& message) {return m_queue.pop(message);}
+
+    //! Returns the number of messages received
+    unsigned int getNumReceived() const {return m_numReceived.load(std::memory_order_relaxed);}
+
+    //! Returns the number of messages dropped because the main thread fell behind
+    unsigned int getNumDropped() const {return m_queue.getNumDropped();}
+
+    //! Returns the FNV-1a hash of an address
+    static unsigned int getHash(const char* address);
+
+    //! Parses a received packet, dropping it if it is malformed, called from the listening thread
+    virtual void ProcessPacket(const char* data, int size, const IpEndpointName& remoteEndpoint);
+
+protected:
+
+    //! Copies a received message into the queue, called from the listening thread
+    virtual void ProcessMessage(const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint);
+
+    //! Runs the socket until stop() is called
+    void threadedFunction();
+
+private:
+
+    MessageQueue<OscControlMessage> m_queue;        ///< messages waiting for the main thread
+    UdpListeningReceiveSocket*      m_socket;       ///< socket listening for the messages
+    std::atomic<unsigned int>       m_numReceived;  ///< number of messages received
+};
+
+//==========================================================================
+
+
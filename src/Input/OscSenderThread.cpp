@@ -0,0 +1,62 @@
+/*
+ *  OscSenderThread.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "OscSenderThread.h"
+#include "OscManager.h"
+
+
+const int OscSenderThread::QUEUE_CAPACITY = 8;
+
+
+OscSenderThread::OscSenderThread(): m_queue(QUEUE_CAPACITY), m_messageQueue(QUEUE_CAPACITY), m_oscManager(NULL)
+{
+    m_queue.setPushSignal(&m_signal);
+    m_messageQueue.setPushSignal(&m_signal);
+}
+
+
+OscSenderThread::~OscSenderThread()
+{
+    this->stop();
+}
+
+
+void OscSenderThread::start(OscManager* oscManager)
+{
+    m_oscManager = oscManager;
+    startThread();
+}
+
+void OscSenderThread::stop()
+{
+    if(isThreadRunning()){
+        stopThread();
+        m_signal.notify();
+        waitForThread(false);
+    }
+}
+
+void OscSenderThread::threadedFunction()
+{
+    while(isThreadRunning())
+    {
+        // the messages are tiny, they don't wait behind the contours
+        OscFrame* frame = m_messageQueue.pop();
+        if(!frame){
+            frame = m_queue.pop();
+        }
+        
+        if(frame){
+            m_oscManager->sendFrame(*frame);
+        }
+        else{
+            m_signal.wait();
+        }
+    }
+}
+
@@ -0,0 +1,122 @@
+/*
+ *  OscSenderThread.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ContourSet.h"
+#include "FrameQueue.h"
+#include "OscMessage.h"
+
+class OscManager;
+
+//========================== struct OscFrame ==============================
+//============================================================================
+/** \struct OscFrame OscSenderThread.h
+ *	\brief Everything the sender thread needs to serialise and send one frame
+ *	\details The data is copied in, so the frame doesn't depend on the state of the
+ *    tracking, and so are the settings the frame has to be sent with.
+ */
+
+struct OscFrame
+{
+    enum Type {
+        CONTOURS,
+        FOURIER_DESCRIPTORS,
+        AUDIO_MAX,
+        MESSAGE
+    };
+
+    int                     type;               ///< what the frame carries
+    int                     encoding;           ///< contour encoding of the destinations following the GUI
+    bool                    bundle;             ///< whether to send it as time tagged bundles
+    bool                    keyframe;           ///< whether the stream encoder should send keyframes
+    int                     keyframeInterval;   ///< frames between keyframes of a label of the stream encoding
+    float                   streamTolerance;    ///< distance a vertex has to move to be sent by the stream encoding
+    int                     degradation;        ///< degradation level of the send budget, -1 when it is off
+
+    ContourSet              contours;           ///< contours of the frame, with the capture time
+    vector<unsigned int>    labels;             ///< label of every Fourier described contour
+    vector<float>           coefficients;       ///< Fourier coefficients of all the contours
+    int                     numCoefficients;    ///< number of complex coefficients per contour
+    float                   audioMax;           ///< audio maximum
+    OscMessage              message;            ///< any other message
+    ContourMarks            marks;              ///< largest contours the slot has held, it only grows past them
+};
+
+
+//========================== class OscSenderThread ==============================
+//============================================================================
+/** \class OscSenderThread OscSenderThread.h
+ *	\brief Serialises and sends the OSC frames away from the render thread
+ *	\details Every queue has a single producer, so nothing is locked. The tracking emit
+ *    thread fills and pushes the contour frames, the render thread the audio maximum
+ *    and the other messages on a queue of their own, so they never evict a contour
+ *    frame. This thread pops the messages first, then the frames, and hands them to
+ *    the OscManager to be sent. The queues drop the oldest frame when the network
+ *    can't keep up, so tracking never waits for it.
+ */
+
+class OscSenderThread: public ofThread
+{
+
+public:
+
+    static const int QUEUE_CAPACITY;
+
+    //! Constructor
+    OscSenderThread();
+
+    //! Destructor
+    ~OscSenderThread();
+
+    //! Starts sending the frames through the given manager
+    void start(OscManager* oscManager);
+
+    //! Stops the thread once the frame being sent is out
+    void stop();
+
+    //! Returns the contour frame to fill before pushing it, from the tracking emit thread only
+    OscFrame& getWriteFrame() {return m_queue.getWriteFrame();}
+
+    //! Queues the contour frame to be sent
+    void push() {m_queue.push();}
+
+    //! Returns the message frame to fill before pushing it, from the render thread only
+    OscFrame& getMessageFrame() {return m_messageQueue.getWriteFrame();}
+
+    //! Queues the message frame to be sent
+    void pushMessage() {m_messageQueue.push();}
+
+    //! Returns the number of frames queued
+    unsigned int getNumQueued() const {return m_queue.getNumPushed();}
+
+    //! Returns the number of frames sent
+    unsigned int getNumSent() const {return m_queue.getNumPopped();}
+
+    //! Returns the number of frames dropped because the network couldn't keep up
+    unsigned int getNumDropped() const {return m_queue.getNumDropped();}
+
+    //! Returns the number of messages dropped because the network couldn't keep up
+    unsigned int getNumMessagesDropped() const {return m_messageQueue.getNumDropped();}
+
+private:
+
+    void threadedFunction();
+
+private:
+
+    FrameQueue<OscFrame>    m_queue;            ///< contour frames waiting to be sent
+    FrameQueue<OscFrame>    m_messageQueue;     ///< audio maximum and other messages waiting to be sent
+    OscManager*             m_oscManager;       ///< serialises and sends the frames
+    ThreadSignal            m_signal;           ///< notified on every push to either queue, wakes the thread
+};
+
+//==========================================================================
+
+
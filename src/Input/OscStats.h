@@ -0,0 +1,52 @@
+/*
+ *  OscStats.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+
+
+//========================== struct OscStats ==============================
+//============================================================================
+/** \struct OscStats OscStats.h
+ *	\brief Counters and gauges of the OSC traffic, written by the sender thread
+ *	\details The counters only ever grow, with relaxed atomic additions, and are turned
+ *    into rates by whoever reads them. The gauges describe the latest frame sent. Nothing
+ *    is formatted until the statistics are shown.
+ */
+
+struct OscStats
+{
+    std::atomic<unsigned int>   numMessages;            ///< messages sent to all the destinations
+    std::atomic<unsigned int>   numPackets;             ///< packets sent to all the destinations
+    std::atomic<unsigned int>   numBytes;               ///< bytes sent to all the destinations, wrapping around
+    std::atomic<unsigned int>   numFrames;              ///< frames serialised
+    std::atomic<int>            numContours;            ///< contours of the latest frame
+    std::atomic<int>            numVertices;            ///< vertices of the latest frame
+    std::atomic<const char*>    lastAddress;            ///< address of the first message of the latest frame, a string literal
+    std::atomic<unsigned int>   numMessageAllocations;  ///< times the reusable Fourier descriptors message had to grow
+
+    OscStats(): numMessages(0), numPackets(0), numBytes(0), numFrames(0), numContours(0), numVertices(0), lastAddress(""), numMessageAllocations(0) {}
+
+    //! Adds to one of the counters
+    static void add(std::atomic<unsigned int>& counter, unsigned int n) {counter.fetch_add(n, std::memory_order_relaxed);}
+
+    //! Adds to one of the counters that don't wrap around
+    static void add(std::atomic<unsigned long long>& counter, unsigned long long n) {counter.fetch_add(n, std::memory_order_relaxed);}
+
+    //! Sets one of the gauges
+    template <typename T> static void set(std::atomic<T>& gauge, T value) {gauge.store(value, std::memory_order_relaxed);}
+
+    //! Returns one of the counters or gauges
+    template <typename T> static T get(const std::atomic<T>& value) {return value.load(std::memory_order_relaxed);}
+};
+
+//==========================================================================
+
+
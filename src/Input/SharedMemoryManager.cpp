@@ -0,0 +1,197 @@
+/*
+ *  SharedMemoryManager.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "SharedMemoryManager.h"
+#include "AppManager.h"
+
+
+SharedMemoryManager::SharedMemoryManager(): Manager(), m_header(NULL), m_size(0), m_frameId(0), m_numTruncatedFrames(0), m_numLeftOut(0), m_numLeftOutWarned(0)
+{
+    //Intentionally left empty
+}
+
+
+SharedMemoryManager::~SharedMemoryManager()
+{
+    ofScopedLock lock(m_mutex);
+    this->close();
+    ofLogNotice() <<"SharedMemoryManager::destructor";
+}
+
+
+//--------------------------------------------------------------
+
+void SharedMemoryManager::setup()
+{
+    if(m_initialized)
+        return;
+    
+    Manager::setup();
+    
+    ofLogNotice() <<"SharedMemoryManager::initialized" ;
+}
+
+void SharedMemoryManager::update()
+{
+    int numLeftOut = m_numLeftOut.load(std::memory_order_relaxed);
+    if(numLeftOut == m_numLeftOutWarned){
+        return;
+    }
+    
+    m_numLeftOutWarned = numLeftOut;
+    if(numLeftOut > 0){
+        ofLogWarning() <<"SharedMemoryManager::update -> " << numLeftOut << " contours left out of the last frame, " << this->getNumTruncatedFrames() << " frames truncated so far";
+    }
+}
+
+void SharedMemoryManager::onSharedMemoryChange(bool & value)
+{
+    ofScopedLock lock(m_mutex);
+    if(value){
+        this->open();
+    }
+    else{
+        this->close();
+    }
+}
+
+bool SharedMemoryManager::open()
+{
+    if(m_header){
+        return true;
+    }
+    
+    const char* name = ContourSharedMemory::DEFAULT_NAME;
+    size_t size = ContourSharedMemory::getSize(ContourSharedMemory::NUM_SLOTS, ContourSharedMemory::MAX_CONTOURS, ContourSharedMemory::MAX_VERTICES);
+    
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if(fd < 0){
+        ofLogError() <<"SharedMemoryManager::open -> unable to create the shared memory " << name;
+        return false;
+    }
+    
+    void* memory = MAP_FAILED;
+    if(ftruncate(fd, size) == 0){
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    
+    if(memory == MAP_FAILED){
+        ofLogError() <<"SharedMemoryManager::open -> unable to map " << size << " bytes of shared memory " << name;
+        shm_unlink(name);
+        return false;
+    }
+    
+    // readers check the magic number, so it is written once everything else is in place
+    m_header = (ContourSharedMemory::Header*) memory;
+    m_header->magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    memset(m_header + 1, 0, size - sizeof(ContourSharedMemory::Header));
+    m_header->version = ContourSharedMemory::VERSION;
+    m_header->numSlots = ContourSharedMemory::NUM_SLOTS;
+    m_header->slotSize = ContourSharedMemory::getSlotSize(ContourSharedMemory::MAX_CONTOURS, ContourSharedMemory::MAX_VERTICES);
+    m_header->maxContours = ContourSharedMemory::MAX_CONTOURS;
+    m_header->maxVertices = ContourSharedMemory::MAX_VERTICES;
+    m_header->latestFrame.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = ContourSharedMemory::MAGIC;
+    
+    m_size = size;
+    m_frameId = 0;
+    
+    ofLogNotice() <<"SharedMemoryManager::open -> publishing contours in " << name << ", " << size << " bytes";
+    return true;
+}
+
+void SharedMemoryManager::close()
+{
+    if(!m_header){
+        return;
+    }
+    
+    munmap(m_header, m_size);
+    shm_unlink(ContourSharedMemory::DEFAULT_NAME);
+    m_header = NULL;
+    m_size = 0;
+    
+    ofLogNotice() <<"SharedMemoryManager::close";
+}
+
+void SharedMemoryManager::writeContours(const ContourSet& contours)
+{
+    ofScopedLock lock(m_mutex);
+    if(!m_header){
+        return;
+    }
+    
+    // frame ids start at 1, 0 means there is no frame yet
+    m_frameId++;
+    if(m_frameId == 0){
+        m_frameId = 1;
+    }
+    
+    unsigned char* slot = (unsigned char*) (m_header + 1) + (m_frameId % m_header->numSlots)*m_header->slotSize;
+    ContourSharedMemory::FrameHeader* frame = (ContourSharedMemory::FrameHeader*) slot;
+    
+    uint32_t maxContours = m_header->maxContours;
+    uint32_t* labels = (uint32_t*) (frame + 1);
+    uint32_t* offsets = labels + maxContours;
+    float* boundingBoxes = (float*) (offsets + maxContours + 1);
+    float* vertices = boundingBoxes + 4*maxContours;
+    
+    // the odd sequence is ordered before the writes of the frame
+    uint32_t sequence = frame->sequence.load(std::memory_order_relaxed);
+    frame->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    // contours that don't fit in the slot are left out whole
+    uint32_t numContours = 0, numVertices = 0;
+    offsets[0] = 0;
+    for(int i = 0; i < contours.size() && numContours < maxContours; i++)
+    {
+        int n = contours.getNumVertices(i);
+        if(numVertices + n > m_header->maxVertices){
+            continue;
+        }
+        
+        memcpy(vertices + 2*numVertices, contours.getVertices(i), n*sizeof(ofVec2f));
+        
+        const ofRectangle& boundingBox = contours.getBoundingBox(i);
+        boundingBoxes[4*numContours] = boundingBox.x;
+        boundingBoxes[4*numContours + 1] = boundingBox.y;
+        boundingBoxes[4*numContours + 2] = boundingBox.width;
+        boundingBoxes[4*numContours + 3] = boundingBox.height;
+        
+        labels[numContours] = contours.getLabel(i);
+        numVertices += n;
+        numContours++;
+        offsets[numContours] = numVertices;
+    }
+    
+    // the emit thread doesn't log, the main thread warns when the number left out changes
+    int numLeftOut = contours.size() - numContours;
+    m_numLeftOut.store(numLeftOut, std::memory_order_relaxed);
+    if(numLeftOut > 0){
+        m_numTruncatedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    frame->frameId = m_frameId;
+    frame->timestamp = contours.getTimestamp();
+    frame->writeTime = ofGetSystemTimeMicros();
+    frame->numContours = numContours;
+    frame->numVertices = numVertices;
+    frame->sensorWidth = TrackingManager::DEPTH_CAMERA_WIDTH;
+    frame->sensorHeight = TrackingManager::DEPTH_CAMERA_HEIGHT;
+    
+    frame->sequence.store(sequence + 2, std::memory_order_release);
+    m_header->latestFrame.store(m_frameId, std::memory_order_release);
+}
@@ -0,0 +1,80 @@
+/*
+ *  SharedMemoryManager.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+#include "Manager.h"
+#include "ContourSet.h"
+#include "ContourSharedMemory.h"
+
+//========================== class SharedMemoryManager ==============================
+//============================================================================
+/** \class SharedMemoryManager SharedMemoryManager.h
+ *	\brief Class publishing the contours in POSIX shared memory
+ *	\details A renderer running on the same machine reads the contours with
+ *    ContourSharedMemory instead of receiving them through OSC over the loopback,
+ *    so they are neither serialised nor copied through the kernel. The contours are
+ *    written from the tracking emit thread, so the mapping is locked while it changes.
+ *    The emit thread only counts the contours that don't fit in a slot, the main
+ *    thread warns about them when their number changes.
+ */
+
+
+class SharedMemoryManager: public Manager
+{
+    
+public:
+    
+    //! Constructor
+    SharedMemoryManager();
+    
+    //! Destructor
+    ~SharedMemoryManager();
+    
+    //! Setup the Shared Memory Manager
+    void setup();
+    
+    //! Update the Shared Memory Manager, warning about the contours left out
+    void update();
+    
+    //! Returns the number of frames written with contours left out
+    unsigned int getNumTruncatedFrames() const {return m_numTruncatedFrames.load(std::memory_order_relaxed);}
+    
+    //! Writes the contours of a frame to the next slot and publishes it
+    void writeContours(const ContourSet& contours);
+    
+    //! Shared memory toggle change controlled by GUI
+    void onSharedMemoryChange(bool & value);
+    
+private:
+    
+    //! Creates and maps the shared memory
+    bool open();
+    
+    //! Unmaps and removes the shared memory
+    void close();
+    
+    
+private:
+    
+    ContourSharedMemory::Header*    m_header;               ///< mapped shared memory, NULL while disabled
+    size_t                          m_size;                 ///< bytes mapped
+    uint32_t                        m_frameId;              ///< id of the last frame written
+    ofMutex                         m_mutex;                ///< keeps the mapping from being closed while it is written
+    std::atomic<unsigned int>       m_numTruncatedFrames;   ///< frames written with contours left out
+    std::atomic<int>                m_numLeftOut;           ///< contours left out of the last frame written
+    int                             m_numLeftOutWarned;     ///< contours left out the last warning was about
+    
+};
+
+//==========================================================================
+
+
@@ -79,6 +79,30 @@ void GuiManager::setupCameraGui()
     m_blurRotation.addListener(trackingManager, &TrackingManager::onBlurRotationChange);
     m_parametersCamera.add(m_blurRotation);
     
+    m_source.set("Source", 0, 0, DepthSource::RECORDING - 1);
+    m_source.addListener(trackingManager, &TrackingManager::onSourceChange);
+    m_parametersCamera.add(m_source);
+    
+    m_syntheticPeople.set("SyntheticPeople", 20, 5, 500);
+    m_syntheticPeople.addListener(trackingManager, &TrackingManager::onSyntheticPeopleChange);
+    m_parametersCamera.add(m_syntheticPeople);
+    
+    m_syntheticFrameRate.set("SyntheticFps", 30, 1, 120);
+    m_syntheticFrameRate.addListener(trackingManager, &TrackingManager::onSyntheticFrameRateChange);
+    m_parametersCamera.add(m_syntheticFrameRate);
+    
+    m_syntheticNoise.set("SyntheticNoise", 8, 0, 50);
+    m_syntheticNoise.addListener(trackingManager, &TrackingManager::onSyntheticNoiseChange);
+    m_parametersCamera.add(m_syntheticNoise);
+    
+    m_syntheticDropout.set("SyntheticDropout", 0.01, 0.0, 0.2);
+    m_syntheticDropout.addListener(trackingManager, &TrackingManager::onSyntheticDropoutChange);
+    m_parametersCamera.add(m_syntheticDropout);
+    
+    m_record.set("Record", false);
+    m_record.addListener(trackingManager, &TrackingManager::onRecordChange);
+    m_parametersCamera.add(m_record);
+    
     m_gui.add(m_parametersCamera);
 
 }
@@ -121,10 +145,109 @@ void GuiManager::setupTrackingGui()
     m_backgroundSubstraction.addListener(trackingManager, &TrackingManager::onBackgroundSubstractionChange);
     m_parametersTracking.add(m_backgroundSubstraction);
     
+    m_pyramidLevels.set("PyramidLevels", 0, 0, 2);
+    m_pyramidLevels.addListener(trackingManager, &TrackingManager::onPyramidLevelsChange);
+    m_parametersTracking.add(m_pyramidLevels);
+    
+    m_pyramidRefine.set("PyramidRefine", true);
+    m_pyramidRefine.addListener(trackingManager, &TrackingManager::onPyramidRefineChange);
+    m_parametersTracking.add(m_pyramidRefine);
+    
+    m_incrementalContours.set("IncrementalContours", false);
+    m_incrementalContours.addListener(trackingManager, &TrackingManager::onIncrementalContoursChange);
+    m_parametersTracking.add(m_incrementalContours);
+    
+    m_incrementalMaxDirty.set("IncrementalMaxDirty", 25, 0, 100);
+    m_incrementalMaxDirty.addListener(trackingManager, &TrackingManager::onIncrementalMaxDirtyChange);
+    m_parametersTracking.add(m_incrementalMaxDirty);
+    
+    m_bitMask.set("BitMask", false);
+    m_bitMask.addListener(trackingManager, &TrackingManager::onBitMaskChange);
+    m_parametersTracking.add(m_bitMask);
+    
+    m_maskOpen.set("MaskOpen", 1, 0, 5);
+    m_maskOpen.addListener(trackingManager, &TrackingManager::onMaskOpenChange);
+    m_parametersTracking.add(m_maskOpen);
+    
+    m_maskClose.set("MaskClose", 1, 0, 5);
+    m_maskClose.addListener(trackingManager, &TrackingManager::onMaskCloseChange);
+    m_parametersTracking.add(m_maskClose);
+    
+    m_maskShape.set("MaskShape", StructuringElement::ELLIPSE, 0, StructuringElement::NUM_SHAPES - 1);
+    m_maskShape.addListener(trackingManager, &TrackingManager::onMaskShapeChange);
+    m_parametersTracking.add(m_maskShape);
+    
+    m_idleMode.set("IdleMode", true);
+    m_idleMode.addListener(trackingManager, &TrackingManager::onIdleModeChange);
+    m_parametersTracking.add(m_idleMode);
+    
+    m_idleFrameRate.set("IdleFps", 0, 0, 30);
+    m_idleFrameRate.addListener(trackingManager, &TrackingManager::onIdleFrameRateChange);
+    m_parametersTracking.add(m_idleFrameRate);
+    
     m_sendAllContours.set("SendAllContours", true);
     m_sendAllContours.addListener(trackingManager, &TrackingManager::onSendAllContoursChange);
     m_parametersTracking.add(m_sendAllContours);
     
+    m_vertexBudget.set("VertexBudget", false);
+    m_vertexBudget.addListener(trackingManager, &TrackingManager::onVertexBudgetChange);
+    m_parametersTracking.add(m_vertexBudget);
+    
+    m_packetBytes.set("PacketBytes", OscManager::MAX_PACKET_SIZE, 256, OscManager::MAX_PACKET_SIZE);
+    m_packetBytes.addListener(trackingManager, &TrackingManager::onPacketBytesChange);
+    m_parametersTracking.add(m_packetBytes);
+    
+    m_frameBytes.set("FrameBytes", 16384, 1024, 65536);
+    m_frameBytes.addListener(trackingManager, &TrackingManager::onFrameBytesChange);
+    m_parametersTracking.add(m_frameBytes);
+    
+    m_sendBudget.set("SendBudget", false);
+    m_sendBudget.addListener(trackingManager, &TrackingManager::onSendBudgetChange);
+    m_parametersTracking.add(m_sendBudget);
+    
+    m_maxVertices.set("MaxVertices", 4096, 256, 32768);
+    m_maxVertices.addListener(trackingManager, &TrackingManager::onMaxVerticesChange);
+    m_parametersTracking.add(m_maxVertices);
+    
+    m_maxContours.set("MaxContours", 16, 1, 64);
+    m_maxContours.addListener(trackingManager, &TrackingManager::onMaxContoursChange);
+    m_parametersTracking.add(m_maxContours);
+    
+    m_fourierDescriptors.set("FourierDescriptors", false);
+    m_fourierDescriptors.addListener(trackingManager, &TrackingManager::onFourierDescriptorsChange);
+    m_parametersTracking.add(m_fourierDescriptors);
+    
+    m_fourierCoefficients.set("FourierCoefficients", 16, 2, FourierDescriptors::MAX_COEFFICIENTS);
+    m_fourierCoefficients.addListener(trackingManager, &TrackingManager::onFourierCoefficientsChange);
+    m_parametersTracking.add(m_fourierCoefficients);
+    
+    OscManager* oscManager = &AppManager::getInstance().getOscManager();
+    m_frameBundle.set("FrameBundle", true);
+    m_frameBundle.addListener(oscManager, &OscManager::onFrameBundleChange);
+    m_parametersTracking.add(m_frameBundle);
+    
+    m_contourEncoding.set("ContourEncoding", OscManager::ENCODING_FLOAT, OscManager::ENCODING_FLOAT, OscManager::ENCODING_STREAM);
+    m_contourEncoding.addListener(oscManager, &OscManager::onContourEncodingChange);
+    m_parametersTracking.add(m_contourEncoding);
+    
+    m_keyframeInterval.set("KeyframeInterval", 30, 1, 300);
+    m_keyframeInterval.addListener(oscManager, &OscManager::onKeyframeIntervalChange);
+    m_parametersTracking.add(m_keyframeInterval);
+    
+    m_streamTolerance.set("StreamTolerance", 0.5, 0.0, 4.0);
+    m_streamTolerance.addListener(oscManager, &OscManager::onStreamToleranceChange);
+    m_parametersTracking.add(m_streamTolerance);
+    
+    SharedMemoryManager* sharedMemoryManager = &AppManager::getInstance().getSharedMemoryManager();
+    m_sharedMemory.set("SharedMemory", false);
+    m_sharedMemory.addListener(sharedMemoryManager, &SharedMemoryManager::onSharedMemoryChange);
+    m_parametersTracking.add(m_sharedMemory);
+    
+    ProfilerManager* profilerManager = &AppManager::getInstance().getProfilerManager();
+    m_profiler.set("Profiler", false);
+    m_profiler.addListener(profilerManager, &ProfilerManager::onProfilerChange);
+    m_parametersTracking.add(m_profiler);
+    
     m_cropLeft.set("CropLeft", 0.0, 0.0, TrackingManager::DEPTH_CAMERA_WIDTH*0.5);
     m_cropLeft.addListener(trackingManager, &TrackingManager::onCropLeft);
     m_parametersTracking.add(m_cropLeft);
@@ -188,6 +311,29 @@ void GuiManager::loadGuiValues()
     m_gui.loadFromFile(GUI_SETTINGS_FILE_NAME);
 }
 
+string GuiManager::getTrackingSettings()
+{
+    // the source, the recording, the sending and the profiler leave the contours as they are
+    static const string ignored[] = {"Source", "SyntheticPeople", "SyntheticFps", "SyntheticNoise", "SyntheticDropout", "Record",
+        "FrameBundle", "ContourEncoding", "KeyframeInterval", "StreamTolerance", "SharedMemory", "Profiler"};
+    const set<string> ignoredNames(ignored, ignored + sizeof(ignored)/sizeof(ignored[0]));
+    
+    string settings;
+    ofParameterGroup* groups[] = {&m_parametersCamera, &m_parametersTracking};
+    for(int i = 0; i < 2; i++)
+    {
+        for(int j = 0; j < groups[i]->size(); j++)
+        {
+            ofAbstractParameter& parameter = groups[i]->get(j);
+            if(ignoredNames.count(parameter.getName()) == 0){
+                settings += (settings.empty() ? "" : " ") + parameter.getName() + "=" + parameter.toString();
+            }
+        }
+    }
+    
+    return settings;
+}
+
 void GuiManager::toggleGui()
 {
     ofLogNotice() <<"GuiManager::toggleGui -> show GUI "<< m_showGui;
@@ -42,6 +42,9 @@ public:
     
     void loadGuiValues();
     
+    //! Returns the camera and tracking settings the contours depend on, as name=value pairs
+    string getTrackingSettings();
+    
     void toggleGui();
     
     void showGui(bool show){m_showGui=show;}
@@ -50,7 +53,7 @@ public:
     
     int getHeight()  {return m_gui.getHeight();}
     
-    void setAudioVolume(float& value){m_audioVolume = value;}
+    void setAudioVolume(float value){m_audioVolume = value;}
     
     void setGuiNearClipping(int value) {m_nearClipping = value;}
     
@@ -78,6 +81,66 @@ public:
     
     void setSendAllContours(bool value) {m_sendAllContours = value;}
     
+    void setPyramidLevels(int value) {m_pyramidLevels = value;}
+    
+    void setPyramidRefine(bool value) {m_pyramidRefine = value;}
+    
+    void setIncrementalContours(bool value) {m_incrementalContours = value;}
+    
+    void setIncrementalMaxDirty(int value) {m_incrementalMaxDirty = value;}
+    
+    void setBitMask(bool value) {m_bitMask = value;}
+    
+    void setMaskOpen(int value) {m_maskOpen = value;}
+    
+    void setMaskClose(int value) {m_maskClose = value;}
+    
+    void setMaskShape(int value) {m_maskShape = value;}
+    
+    void setIdleMode(bool value) {m_idleMode = value;}
+    
+    void setIdleFrameRate(int value) {m_idleFrameRate = value;}
+    
+    void setVertexBudget(bool value) {m_vertexBudget = value;}
+    
+    void setPacketBytes(int value) {m_packetBytes = value;}
+    
+    void setFrameBytes(int value) {m_frameBytes = value;}
+    
+    void setSendBudget(bool value) {m_sendBudget = value;}
+    
+    void setMaxVertices(int value) {m_maxVertices = value;}
+    
+    void setMaxContours(int value) {m_maxContours = value;}
+    
+    void setFrameBundle(bool value) {m_frameBundle = value;}
+    
+    void setContourEncoding(int value) {m_contourEncoding = value;}
+    
+    void setKeyframeInterval(int value) {m_keyframeInterval = value;}
+    
+    void setStreamTolerance(float value) {m_streamTolerance = value;}
+    
+    void setFourierDescriptors(bool value) {m_fourierDescriptors = value;}
+    
+    void setFourierCoefficients(int value) {m_fourierCoefficients = value;}
+    
+    void setSharedMemory(bool value) {m_sharedMemory = value;}
+    
+    void setProfiler(bool value) {m_profiler = value;}
+    
+    void setSource(int value) {m_source = value;}
+    
+    void setSyntheticPeople(int value) {m_syntheticPeople = value;}
+    
+    void setSyntheticFrameRate(float value) {m_syntheticFrameRate = value;}
+    
+    void setSyntheticNoise(float value) {m_syntheticNoise = value;}
+    
+    void setSyntheticDropout(float value) {m_syntheticDropout = value;}
+    
+    void setRecord(bool value) {m_record = value;}
+    
     void setCropBottom(int value) {m_cropBottom = value;}
     
     void setCropLeft(int value) {m_cropLeft = value;}
@@ -122,6 +185,36 @@ private:
     ofParameter<float>   m_smoothingShape;
     ofParameter<bool>	 m_backgroundSubstraction;
     ofParameter<bool>	 m_sendAllContours;
+    ofParameter<int>	 m_pyramidLevels;
+    ofParameter<bool>	 m_pyramidRefine;
+    ofParameter<bool>	 m_incrementalContours;
+    ofParameter<int>	 m_incrementalMaxDirty;
+    ofParameter<bool>	 m_bitMask;
+    ofParameter<int>	 m_maskOpen;
+    ofParameter<int>	 m_maskClose;
+    ofParameter<int>	 m_maskShape;
+    ofParameter<bool>	 m_idleMode;
+    ofParameter<int>	 m_idleFrameRate;
+    ofParameter<bool>	 m_vertexBudget;
+    ofParameter<int>	 m_packetBytes;
+    ofParameter<int>	 m_frameBytes;
+    ofParameter<bool>	 m_sendBudget;
+    ofParameter<int>	 m_maxVertices;
+    ofParameter<int>	 m_maxContours;
+    ofParameter<bool>	 m_frameBundle;
+    ofParameter<int>	 m_contourEncoding;
+    ofParameter<int>	 m_keyframeInterval;
+    ofParameter<float>	 m_streamTolerance;
+    ofParameter<bool>	 m_fourierDescriptors;
+    ofParameter<int>	 m_fourierCoefficients;
+    ofParameter<bool>	 m_sharedMemory;
+    ofParameter<bool>	 m_profiler;
+    ofParameter<int>	 m_source;
+    ofParameter<int>	 m_syntheticPeople;
+    ofParameter<float>	 m_syntheticFrameRate;
+    ofParameter<float>	 m_syntheticNoise;
+    ofParameter<float>	 m_syntheticDropout;
+    ofParameter<bool>	 m_record;
     
     ofParameter<float>   m_audioVolume;
     ofParameter<int>     m_audioNumPeaks;
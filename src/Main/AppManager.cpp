@@ -29,6 +29,8 @@ AppManager::AppManager(): Manager(), m_debugMode(true)
 
 AppManager::~AppManager()
 {
+    // the tracking threads send through the managers destroyed before the tracking one
+    m_trackingManager.stop();
     ofLogNotice() <<"AppManager::Destructor";
 }
 
@@ -50,6 +52,13 @@ void AppManager::setup()
 
 void AppManager::setupOF()
 {
+   // a benchmark runs as fast as the pipeline goes
+   if(m_benchmarkManager.isEnabled()){
+       ofSetVerticalSync(false);
+       ofSetFrameRate(0);
+       return;
+   }
+    
    ofSetVerticalSync(true);
    ofSetFrameRate(60);
    ofShowCursor();
@@ -59,27 +68,44 @@ void AppManager::setupOF()
 void AppManager::setupManagers()
 {
     m_viewManager.setup();
+    m_profilerManager.setup();
     m_visualEffectsManager.setup();
     m_settingsManager.setup();
     m_layoutManager.setup();
     m_oscManager.setup();
+    m_sharedMemoryManager.setup();
     m_trackingManager.setup();
     m_keyboardManager.setup();
     m_audioManager.setup();
     m_guiManager.setup();
+    m_benchmarkManager.setup();
 }
 
 void AppManager::update()
 {
+    if(m_benchmarkManager.isEnabled()){
+        m_trackingManager.update();
+        m_oscManager.update();
+        m_profilerManager.update();
+        m_benchmarkManager.update();
+        return;
+    }
+    
     m_trackingManager.update();
     m_audioManager.update();
     m_visualEffectsManager.update();
     m_oscManager.update();
+    m_sharedMemoryManager.update();
+    m_profilerManager.update();
 }
 
 
 void AppManager::draw()
 {
+    if(m_benchmarkManager.isEnabled()){
+        return;
+    }
+    
     m_viewManager.draw();
     
     if (!m_debugMode) {
@@ -88,6 +114,7 @@ void AppManager::draw()
     
     m_trackingManager.draw();
     m_audioManager.draw();
+    m_profilerManager.draw();
     m_guiManager.draw();
 }
 
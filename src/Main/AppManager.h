@@ -21,6 +21,9 @@
 #include "ViewManager.h"
 #include "KeyboardManager.h"
 #include "OscManager.h"
+#include "SharedMemoryManager.h"
+#include "ProfilerManager.h"
+#include "BenchmarkManager.h"
 #include "AudioManager.h"
 
 //========================== class AppManager ==============================
@@ -75,8 +78,17 @@ public:
     //! Returns the  OSC manager
     OscManager&  getOscManager() { return m_oscManager; }
     
+    //! Returns the  shared memory manager
+    SharedMemoryManager&  getSharedMemoryManager() { return m_sharedMemoryManager; }
+    
     //! Returns the  audio manager
     AudioManager&  getAudioManager() { return m_audioManager;}
+    
+    //! Returns the  profiler manager
+    ProfilerManager&  getProfilerManager() { return m_profilerManager;}
+    
+    //! Returns the  benchmark manager
+    BenchmarkManager&  getBenchmarkManager() { return m_benchmarkManager;}
 
     
     //==========================================================================
@@ -119,8 +131,11 @@ private:
     ViewManager                     m_viewManager;              ///< Manages the visuals
     VisualEffectsManager            m_visualEffectsManager;     ///< Manages the visual effects
     OscManager                      m_oscManager;               ///< Manages the OSC messages
+    SharedMemoryManager             m_sharedMemoryManager;      ///< Manages the contours published in shared memory
     KeyboardManager                 m_keyboardManager;          ///< Manages the keboard input
     AudioManager                    m_audioManager;             ///< Manages the audio input
+    ProfilerManager                 m_profilerManager;          ///< Manages the timing of the pipeline stages
+    BenchmarkManager                m_benchmarkManager;         ///< Manages the replay of a recording as a benchmark
 
     bool                            m_debugMode;
 };
@@ -0,0 +1,242 @@
+/*
+ *  BenchmarkManager.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include <sys/resource.h>
+
+#include "BenchmarkManager.h"
+#include "AllocationCounter.h"
+#include "AppManager.h"
+
+
+const string BenchmarkManager::BENCHMARKS_FOLDER = "benchmarks/";
+const string BenchmarkManager::GOLDEN_EXTENSION = "golden";
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+
+BenchmarkManager::BenchmarkManager(): Manager(), m_numRecordingFrames(0), m_numFrames(0), m_hash(FNV_OFFSET_BASIS),
+    m_startTime(0), m_startAllocations(0), m_pyramidLevels(0), m_pyramidRefine(false), m_incrementalContours(false), m_bitMask(false), m_finished(false)
+{
+    //Intentionally left empty
+}
+
+
+BenchmarkManager::~BenchmarkManager()
+{
+    ofLogNotice() <<"BenchmarkManager::destructor";
+}
+
+
+//--------------------------------------------------------------
+
+void BenchmarkManager::setRecording(const string& recordingPath, const string& goldenPath)
+{
+    // the paths of the command line are relative to the working directory, not to the data folder
+    m_recordingPath = ofFilePath::getAbsolutePath(recordingPath, false);
+    m_goldenPath = goldenPath.empty() ? ofFilePath::removeExt(m_recordingPath) + "." + GOLDEN_EXTENSION : ofFilePath::getAbsolutePath(goldenPath, false);
+}
+
+void BenchmarkManager::setup()
+{
+    if(m_initialized || !this->isEnabled())
+        return;
+    
+    Manager::setup();
+    
+    bool profile = true;
+    AppManager::getInstance().getProfilerManager().onProfilerChange(profile);
+    
+    TrackingManager& trackingManager = AppManager::getInstance().getTrackingManager();
+    trackingManager.setLossless(true);
+    if(!trackingManager.playRecording(m_recordingPath)){
+        ofLogError() <<"BenchmarkManager::setup -> unable to replay " << m_recordingPath;
+        ofExit(2);
+        return;
+    }
+    
+    m_numRecordingFrames = trackingManager.getNumPlaybackFrames();
+    m_pyramidLevels = trackingManager.getPyramidLevels();
+    m_pyramidRefine = trackingManager.getPyramidRefine();
+    m_incrementalContours = trackingManager.getIncrementalContours();
+    m_bitMask = trackingManager.getBitMask();
+    m_settings = AppManager::getInstance().getGuiManager().getTrackingSettings();
+    m_startAllocations = AllocationCounter::getNumAllocations();
+    m_startTime = ofGetElapsedTimeMicros();
+    
+    ofLogNotice() <<"BenchmarkManager::initialized -> replaying " << m_numRecordingFrames << " frames of " << m_recordingPath
+                  << ", tracking at 1/" << (1 << m_pyramidLevels) << " resolution" << (m_pyramidLevels > 0 && m_pyramidRefine ? ", refined" : "")
+                  << (m_incrementalContours ? ", incremental contours" : "") << (m_bitMask ? ", bit-packed mask" : "");
+}
+
+void BenchmarkManager::update()
+{
+    if(!m_initialized || m_finished){
+        return;
+    }
+    
+    // the hash of the frames counted is complete once the count is seen
+    if(m_numFrames.load(std::memory_order_acquire) >= m_numRecordingFrames){
+        this->finish();
+    }
+}
+
+void BenchmarkManager::addFrame(const ContourSet& contours)
+{
+    if(!m_initialized){
+        return;
+    }
+    
+    // the vertices are hashed to a hundredth of a pixel, so the hash doesn't depend on the float rounding of the compiler
+    unsigned long long timestamp = contours.getTimestamp();
+    int numContours = contours.size();
+    this->hash(&timestamp, sizeof(timestamp));
+    this->hash(&numContours, sizeof(numContours));
+    
+    for(int i = 0; i < numContours; i++)
+    {
+        unsigned int label = contours.getLabel(i);
+        int numVertices = contours.getNumVertices(i);
+        this->hash(&label, sizeof(label));
+        this->hash(&numVertices, sizeof(numVertices));
+        
+        const ofVec2f* vertices = contours.getVertices(i);
+        for(int j = 0; j < numVertices; j++) {
+            int position[2] = {int(roundf(vertices[j].x*100)), int(roundf(vertices[j].y*100))};
+            this->hash(position, sizeof(position));
+        }
+    }
+    
+    m_numFrames.fetch_add(1, std::memory_order_release);
+}
+
+void BenchmarkManager::hash(const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+    for(size_t i = 0; i < size; i++) {
+        m_hash = (m_hash ^ bytes[i])*FNV_PRIME;
+    }
+}
+
+void BenchmarkManager::finish()
+{
+    m_finished = true;
+    
+    double seconds = (ofGetElapsedTimeMicros() - m_startTime)/1000000.0;
+    double allocationsPerFrame = double(AllocationCounter::getNumAllocations() - m_startAllocations)/max(int(m_numFrames), 1);
+    double peakMemory = getPeakMemory();
+    
+    ProfilerManager& profiler = AppManager::getInstance().getProfilerManager();
+    profiler.report();
+    
+    ofLogNotice() <<"BenchmarkManager::finish -> " << m_numFrames << " frames in " << seconds << " s, " << int(m_numFrames)/max(seconds, 0.001) << " fps";
+    ofLogNotice() <<"BenchmarkManager::finish -> peak memory " << peakMemory << " MB, " << allocationsPerFrame << " allocations per frame";
+    for(int i = 0; i < ProfilerManager::NUM_STAGES; i++)
+    {
+        const ProfileHistogram& histogram = profiler.getTotals(i);
+        ofLogNotice() <<"BenchmarkManager::finish -> " << ProfilerManager::getStageName(i) << " (us): p50 " << histogram.getPercentile(50)
+                      << ", p95 " << histogram.getPercentile(95) << ", p99 " << histogram.getPercentile(99) << ", max " << histogram.getMax();
+    }
+    
+    const ProfileHistogram& frameAllocations = profiler.getAllocationTotals(ProfilerManager::FRAME_ALLOCATIONS);
+    const ProfileHistogram& frameBytes = profiler.getAllocationTotals(ProfilerManager::FRAME_BYTES);
+    ofLogNotice() <<"BenchmarkManager::finish -> the pipeline allocated " << frameAllocations.getMean() << " times and " << frameBytes.getMean()
+                  << " bytes per frame, at most " << frameAllocations.getMax() << " times and " << frameBytes.getMax() << " bytes";
+    
+    string golden;
+    bool match = this->checkGolden(golden);
+    this->writeReport(golden, seconds, allocationsPerFrame, peakMemory);
+    
+    ofExit(match ? 0 : 1);
+}
+
+bool BenchmarkManager::checkGolden(string& result)
+{
+    string hash = ofToHex(m_hash) + " " + ofToString(int(m_numFrames));
+    
+    // a setting changed over OSC while replaying leaves a hash no run can reproduce
+    if(AppManager::getInstance().getGuiManager().getTrackingSettings() != m_settings){
+        ofLogError() <<"BenchmarkManager::checkGolden -> the settings changed during the replay, the hash " << hash << " is meaningless";
+        result = "settings changed";
+        return false;
+    }
+    
+    if(!ofFile::doesFileExist(m_goldenPath)){
+        ofFile golden(m_goldenPath, ofFile::WriteOnly);
+        golden << hash << endl << m_settings << endl;
+        ofLogNotice() <<"BenchmarkManager::checkGolden -> no golden hash yet, wrote " << hash << " to " << m_goldenPath;
+        result = "recorded";
+        return true;
+    }
+    
+    ofFile file(m_goldenPath, ofFile::ReadOnly);
+    string expected, expectedSettings;
+    getline(file, expected);
+    getline(file, expectedSettings);
+    
+    // the hash of other settings says nothing about the code, the golden file has to be recorded again
+    if(expectedSettings != m_settings){
+        ofLogError() <<"BenchmarkManager::checkGolden -> the golden hash was recorded with the settings " << expectedSettings << ", not " << m_settings;
+        result = "settings mismatch";
+        return false;
+    }
+    
+    if(expected != hash){
+        ofLogError() <<"BenchmarkManager::checkGolden -> the output changed: " << hash << ", expected " << expected;
+        result = "mismatch";
+        return false;
+    }
+    
+    ofLogNotice() <<"BenchmarkManager::checkGolden -> the output matches the golden hash " << hash;
+    result = "match";
+    return true;
+}
+
+void BenchmarkManager::writeReport(const string& golden, double seconds, double allocationsPerFrame, double peakMemory)
+{
+    ofDirectory::createDirectory(BENCHMARKS_FOLDER, true, true);
+    string path = ofToDataPath(BENCHMARKS_FOLDER + "benchmark_" + ofGetTimestampString("%Y%m%d_%H%M%S") + ".json");
+    ofFile file(path, ofFile::WriteOnly);
+    
+    file << "{\n  \"recording\": \"" << m_recordingPath << "\",\n  \"frames\": " << m_numFrames << ",\n  \"seconds\": " << seconds
+         << ",\n  \"fps\": " << int(m_numFrames)/max(seconds, 0.001) << ",\n  \"peakMemoryMB\": " << peakMemory
+         << ",\n  \"allocationsPerFrame\": " << allocationsPerFrame << ",\n  \"pyramidLevels\": " << m_pyramidLevels
+         << ",\n  \"pyramidRefine\": " << (m_pyramidRefine ? "true" : "false")
+         << ",\n  \"incrementalContours\": " << (m_incrementalContours ? "true" : "false")
+         << ",\n  \"bitMask\": " << (m_bitMask ? "true" : "false") << ",\n  \"settings\": \"" << m_settings << "\"";
+    
+    const ProfilerManager& profiler = AppManager::getInstance().getProfilerManager();
+    file << ",\n  \"pipelineAllocationsPerFrame\": " << profiler.getAllocationTotals(ProfilerManager::FRAME_ALLOCATIONS).getMean()
+         << ",\n  \"pipelineBytesPerFrame\": " << profiler.getAllocationTotals(ProfilerManager::FRAME_BYTES).getMean()
+         << ",\n  \"hash\": \"" << ofToHex(m_hash) << "\",\n  \"golden\": \"" << golden << "\",\n  \"unit\": \"us\",\n  \"stages\": [";
+    
+    for(int i = 0; i < ProfilerManager::NUM_STAGES; i++)
+    {
+        const ProfileHistogram& histogram = profiler.getTotals(i);
+        file << (i > 0 ? ",\n" : "\n") << "    {\"name\": \"" << ProfilerManager::getStageName(i) << "\", \"count\": " << histogram.getCount()
+             << ", \"mean\": " << histogram.getMean() << ", \"p50\": " << histogram.getPercentile(50) << ", \"p95\": "
+             << histogram.getPercentile(95) << ", \"p99\": " << histogram.getPercentile(99) << ", \"max\": " << histogram.getMax() << "}";
+    }
+    file << "\n  ]\n}\n";
+    
+    ofLogNotice() <<"BenchmarkManager::writeReport -> " << path;
+}
+
+double BenchmarkManager::getPeakMemory()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    
+    // macOS gives the peak in bytes, Linux in kilobytes
+    #ifdef TARGET_OSX
+        return usage.ru_maxrss/(1024.0*1024.0);
+    #else
+        return usage.ru_maxrss/1024.0;
+    #endif
+}
+
@@ -0,0 +1,105 @@
+/*
+ *  BenchmarkManager.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+#include "Manager.h"
+#include "ContourSet.h"
+
+//========================== class BenchmarkManager ==============================
+//============================================================================
+/** \class BenchmarkManager BenchmarkManager.h
+ *	\brief Class replaying a depth recording through the tracking pipeline as fast as it goes
+ *	\details Started with --benchmark <recording> [<golden file>], the application
+ *    draws nothing and steps through every frame of the recording, with the pipeline
+ *    queues waiting instead of dropping frames, so the contours are the same on every
+ *    run. Every emitted frame is hashed; at the end the throughput, the percentiles of
+ *    every stage, the peak resident memory and the allocations per frame are logged and
+ *    written as JSON into the benchmarks folder, and the hash is checked against the
+ *    golden file, or written to it if there is none yet. The hash depends on the
+ *    settings of gui.xml, so the golden file keeps them on a second line and a run with
+ *    other settings fails instead of passing off a mismatch as a regression. Nothing is
+ *    sent over OSC. The exit status is non-zero when the hash or the settings don't
+ *    match, so a build box can run it without a Kinect. The pyramid
+ *    settings are part of the report, since the output and the time depend on them, and
+ *    so are the incremental contours, which order the contours differently, and the
+ *    bit-packed mask, whose morphology replaces the blur.
+ */
+
+
+class BenchmarkManager: public Manager
+{
+    
+public:
+    
+    static const string BENCHMARKS_FOLDER;  ///< data folder the reports are written into
+    static const string GOLDEN_EXTENSION;   ///< extension of the golden file next to the recording
+    
+    //! Constructor
+    BenchmarkManager();
+    
+    //! Destructor
+    ~BenchmarkManager();
+    
+    //! Switches the application to benchmark mode, before it is set up
+    void setRecording(const string& recordingPath, const string& goldenPath = "");
+    
+    //! Returns whether the application runs a benchmark
+    bool isEnabled() const {return !m_recordingPath.empty();}
+    
+    //! Setup the Benchmark Manager, starting the replay
+    void setup();
+    
+    //! Finishes the benchmark once every frame of the recording has been emitted
+    void update();
+    
+    //! Adds the contours of an emitted frame to the output hash, called from the emit thread
+    void addFrame(const ContourSet& contours);
+    
+private:
+    
+    //! Reports the results, checks the golden hash and exits
+    void finish();
+    
+    //! Compares the output hash and the settings with the golden file, writing it if there is none. Returns false on a mismatch
+    bool checkGolden(string& result);
+    
+    //! Writes the report as JSON into the benchmarks folder
+    void writeReport(const string& golden, double seconds, double allocationsPerFrame, double peakMemory);
+    
+    //! Adds bytes to the output hash
+    void hash(const void* data, size_t size);
+    
+    //! Returns the peak resident memory of the process in megabytes
+    static double getPeakMemory();
+    
+    
+private:
+    
+    string                  m_recordingPath;        ///< recording replayed
+    string                  m_goldenPath;           ///< file holding the expected hash of the output
+    int                     m_numRecordingFrames;   ///< frames of the recording
+    std::atomic<int>        m_numFrames;            ///< frames emitted so far, publishes the hash to the main thread
+    uint64_t                m_hash;                 ///< FNV-1a hash of the emitted contours
+    unsigned long long      m_startTime;            ///< time the replay started, in microseconds
+    unsigned long long      m_startAllocations;     ///< allocations made before the replay started
+    int                     m_pyramidLevels;        ///< times the frame was halved for the tracking, the output depends on it
+    bool                    m_pyramidRefine;        ///< whether the coarse contours were refined at full resolution
+    bool                    m_incrementalContours;  ///< whether only the parts of the mask that changed were traced again
+    bool                    m_bitMask;              ///< whether the mask was bit-packed and filtered by morphology instead of the blur
+    string                  m_settings;             ///< settings of the GUI the output depends on, when the replay started
+    bool                    m_finished;             ///< whether the results have been reported
+    
+};
+
+//==========================================================================
+
+
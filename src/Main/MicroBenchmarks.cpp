@@ -0,0 +1,936 @@
+/*
+ *  MicroBenchmarks.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ofxCv.h"
+#include "ofxFFTBase.h"
+
+#include "MicroBenchmarks.h"
+#include "BenchmarkManager.h"
+#include "OscManager.h"
+#include "ContourSet.h"
+#include "ContourPyramid.h"
+#include "IncrementalContourFinder.h"
+#include "BitMask.h"
+
+using namespace ofxCv;
+
+
+const int MicroBenchmarks::WARMUP_BATCHES = 3;
+const int MicroBenchmarks::NUM_BATCHES = 20;
+const unsigned long long MicroBenchmarks::MIN_BATCH_TIME = 2000;
+
+static const int MAX_ITERATIONS = 1 << 20;
+static const int NUM_FRAMES = 16;   // frames of moving input cycled through
+static const int SEED = 17;
+
+
+//! Wraps a coordinate into [0, size)
+static inline int wrap(float value, int size)
+{
+    float wrapped = fmod(value, float(size));
+    return wrapped < 0 ? wrapped + size : wrapped;
+}
+
+//! Draws discs covering about the given fraction of the image, each moving in its own direction, at the given frame
+static void drawBlobs(cv::Mat& image, int numBlobs, float density, int frame, const cv::Scalar& color)
+{
+    float radius = sqrt(density*image.cols*image.rows/(numBlobs*PI));
+
+    ofSeedRandom(SEED);
+    for(int i = 0; i < numBlobs; i++)
+    {
+        ofVec2f position(ofRandom(image.cols), ofRandom(image.rows));
+        ofVec2f velocity = ofVec2f(ofRandom(1, 3), 0).getRotatedRad(ofRandom(TWO_PI));
+        position += velocity*frame;
+
+        cv::Point centre(wrap(position.x, image.cols), wrap(position.y, image.rows));
+        cv::circle(image, centre, max(int(radius), 1), color, -1);
+    }
+}
+
+//! Draws a floor sloping away from the sensor with some sensor noise and people walking over it, at the given frame
+static void drawCrowd(ofPixels& pixels, int width, int height, int numBlobs, int frame)
+{
+    pixels.allocate(width, height, 1);
+    cv::Mat image = toCv(pixels);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            image.at<unsigned char>(y, x) = 60 + 120*y/height + ofRandom(-4, 4);
+        }
+    }
+    if(numBlobs > 0){
+        drawBlobs(image, numBlobs, 0.1, frame, cv::Scalar::all(230));
+    }
+}
+
+//! Fills the contours of a set into a mask, the holes left empty
+static void fillContours(const ContourSet& contours, cv::Mat& mask)
+{
+    // a sub-pixel precision of 4 bits keeps the vertices off the integer grid
+    const int shift = 4;
+    vector<vector<cv::Point> > polygons(contours.size());
+    for(int i = 0; i < contours.size(); i++) {
+        const ofVec2f* vertices = contours.getVertices(i);
+        for(int j = 0; j < contours.getNumVertices(i); j++) {
+            polygons[i].push_back(cv::Point(roundf(vertices[j].x*(1 << shift)), roundf(vertices[j].y*(1 << shift))));
+        }
+    }
+
+    // filled all at once, a hole inside a contour is crossed twice and stays empty
+    vector<const cv::Point*> points;
+    vector<int> numPoints;
+    for(int i = 0; i < polygons.size(); i++) {
+        if(!polygons[i].empty()){
+            points.push_back(&polygons[i][0]);
+            numPoints.push_back(polygons[i].size());
+        }
+    }
+
+    mask.setTo(0);
+    if(!points.empty()){
+        cv::fillPoly(mask, &points[0], &numPoints[0], points.size(), cv::Scalar::all(255), 8, shift);
+    }
+}
+
+//! Returns a noisy circle of the given number of vertices
+static vector<ofVec2f> makeOutline(int numVertices, float radius, const ofVec2f& centre)
+{
+    vector<ofVec2f> vertices(numVertices);
+    for(int i = 0; i < numVertices; i++) {
+        float angle = TWO_PI*i/numVertices;
+        float r = radius + ofRandom(-3, 3);
+        vertices[i].set(centre.x + r*cos(angle), centre.y + r*sin(angle));
+    }
+    
+    return vertices;
+}
+
+//! Returns a closed polyline through the given vertices
+static ofPolyline makePolyline(const vector<ofVec2f>& vertices)
+{
+    ofPolyline polyline;
+    for(int i = 0; i < vertices.size(); i++) {
+        polyline.addVertex(vertices[i].x, vertices[i].y);
+    }
+    polyline.close();
+    
+    return polyline;
+}
+
+//! Adds a contour through the given vertices to a set
+static void addOutline(ContourSet& contours, const vector<ofVec2f>& vertices, unsigned int label)
+{
+    ofPolyline polyline = makePolyline(vertices);
+    contours.addContour(&vertices[0], vertices.size(), label, polyline.getBoundingBox(), polyline.getArea());
+}
+
+
+//--------------------------------------------------------------
+
+class BackgroundBenchmark: public MicroBenchmark
+{
+public:
+
+    BackgroundBenchmark(int width, int height, int numBlobs): m_frames(NUM_FRAMES)
+    {
+        for(int i = 0; i < m_frames.size(); i++) {
+            drawCrowd(m_frames[i], width, height, numBlobs, i);
+        }
+
+        m_background.setLearningTime(10*30);
+        m_background.setThresholdValue(10);
+    }
+
+    void run(int iteration) {m_background.update(m_frames[iteration % m_frames.size()], m_mask);}
+
+private:
+
+    vector<ofPixels>    m_frames;
+    ofPixels            m_mask;
+    RunningBackground   m_background;
+};
+
+class ContourFinderBenchmark: public MicroBenchmark
+{
+public:
+
+    ContourFinderBenchmark(int numBlobs, float density): m_masks(NUM_FRAMES)
+    {
+        for(int i = 0; i < m_masks.size(); i++) {
+            m_masks[i].allocate(512, 424, 1);
+            m_masks[i].set(0);
+            cv::Mat mask = toCv(m_masks[i]);
+            drawBlobs(mask, numBlobs, density, i, cv::Scalar::all(255));
+        }
+
+        // set up like the tracking, but keeping the smallest blobs
+        m_contourFinder.setMinAreaRadius(1);
+        m_contourFinder.setMaxAreaRadius(1000);
+        m_contourFinder.setTargetColor(ofColor::white, TRACK_COLOR_RGB);
+        m_contourFinder.setThreshold(80);
+        m_contourFinder.getTracker().setPersistence(5*30);
+        m_contourFinder.setFindHoles(true);
+        m_contourFinder.setBuildPolylines(false);
+    }
+
+    void run(int iteration) {m_contourFinder.findContours(m_masks[iteration % m_masks.size()]);}
+
+private:
+
+    vector<ofPixels>    m_masks;
+    ContourFinder       m_contourFinder;
+};
+
+//! Many people standing still and a few walking, traced again every frame or only where the mask changed
+class IncrementalBenchmark: public MicroBenchmark
+{
+public:
+
+    IncrementalBenchmark(int numMoving, bool incremental): m_masks(NUM_FRAMES)
+    {
+        for(int i = 0; i < m_masks.size(); i++) {
+            m_masks[i].allocate(512, 424, 1);
+            m_masks[i].set(0);
+            cv::Mat mask = toCv(m_masks[i]);
+            drawBlobs(mask, 40, 0.15, 0, cv::Scalar::all(255));
+            drawBlobs(mask, numMoving, 0.01*numMoving, i, cv::Scalar::all(255));
+        }
+
+        IncrementalBenchmark::setup(m_contourFinder);
+        m_contourFinder.setIncremental(incremental);
+    }
+
+    void run(int iteration) {m_contourFinder.findContours(m_masks[iteration % m_masks.size()]);}
+
+    // the fraction of frames whose contours are the same as the ones of the contour finder of ofxCv
+    double getQuality()
+    {
+        ContourFinder reference;
+        IncrementalContourFinder contourFinder;
+        IncrementalBenchmark::setup(reference);
+        IncrementalBenchmark::setup(contourFinder);
+        contourFinder.setIncremental(true);
+
+        int numSame = 0;
+        for(int i = 0; i < 2*m_masks.size(); i++)
+        {
+            reference.findContours(m_masks[i % m_masks.size()]);
+            contourFinder.findContours(m_masks[i % m_masks.size()]);
+            numSame += reference.getContours() == contourFinder.getContours();
+        }
+
+        return double(numSame)/(2*m_masks.size());
+    }
+
+private:
+
+    // set up like the tracking, but keeping the smallest blobs
+    static void setup(ContourFinder& contourFinder)
+    {
+        contourFinder.setMinAreaRadius(1);
+        contourFinder.setMaxAreaRadius(1000);
+        contourFinder.setTargetColor(ofColor::white, TRACK_COLOR_RGB);
+        contourFinder.setThreshold(80);
+        contourFinder.getTracker().setPersistence(5*30);
+        contourFinder.setFindHoles(true);
+        contourFinder.setBuildPolylines(false);
+    }
+
+private:
+
+    vector<ofPixels>            m_masks;
+    IncrementalContourFinder    m_contourFinder;
+};
+
+//! The segmentation and contour finding of the tracking, at full resolution or on a decimated frame
+class PyramidTracking
+{
+public:
+
+    PyramidTracking(int scale, bool refine, ofPixels& floor): m_scale(scale), m_refine(refine && scale > 1)
+    {
+        // set up like the tracking, but keeping smaller people
+        m_contourFinder.setMinAreaRadius(10.0/scale);
+        m_contourFinder.setMaxAreaRadius(200.0/scale);
+        m_contourFinder.setTargetColor(ofColor::white, TRACK_COLOR_RGB);
+        m_contourFinder.setThreshold(80);
+        m_contourFinder.getTracker().setPersistence(5*30);
+        m_contourFinder.getTracker().setMaximumDistance(64.0/scale);
+        m_contourFinder.setFindHoles(true);
+        m_contourFinder.setBuildPolylines(false);
+
+        m_background.setLearningTime(10*30);
+        m_background.setThresholdValue(10);
+        m_pyramid.setScale(scale);
+        m_pyramid.setThresholds(10, 80);
+
+        // the background starts from the empty floor
+        this->update(floor);
+    }
+
+    void update(ofPixels& depth)
+    {
+        ofPixels* pixels = &depth;
+        if(m_scale > 1){
+            ContourPyramid::decimate(depth, m_decimated, m_scale);
+            pixels = &m_decimated;
+        }
+
+        m_background.update(*pixels, m_mask);
+        m_contourFinder.findContours(m_mask);
+
+        if(m_scale == 1){
+            m_contours.setFromContourFinder(m_contourFinder);
+        }
+        else if(!m_refine){
+            m_pyramid.upscale(m_contourFinder, m_contours);
+        }
+        else{
+            const cv::Mat& background = m_background.getBackground();
+            m_backgroundCopy.allocate(background.cols, background.rows, background.channels());
+            cv::Mat copy = toCv(m_backgroundCopy);
+            background.copyTo(copy);
+            m_pyramid.refine(m_contourFinder, depth, m_backgroundCopy, m_contours);
+        }
+    }
+
+    const ContourSet& getContours() const {return m_contours;}
+
+private:
+
+    int                 m_scale;
+    bool                m_refine;
+    RunningBackground   m_background;
+    ContourFinder       m_contourFinder;
+    ContourPyramid      m_pyramid;
+    ofPixels            m_decimated;
+    ofPixels            m_mask;
+    ofPixels            m_backgroundCopy;
+    ContourSet          m_contours;
+};
+
+class PyramidBenchmark: public MicroBenchmark
+{
+public:
+
+    PyramidBenchmark(int scale, bool refine): m_frames(NUM_FRAMES), m_scale(scale), m_refine(refine)
+    {
+        drawCrowd(m_floor, 512, 424, 0, 0);
+        for(int i = 0; i < m_frames.size(); i++) {
+            drawCrowd(m_frames[i], 512, 424, 10, i);
+        }
+
+        m_tracking = ofPtr<PyramidTracking>(new PyramidTracking(scale, refine, m_floor));
+    }
+
+    void run(int iteration) {m_tracking->update(m_frames[iteration % m_frames.size()]);}
+
+    // the overlap of the people found with the ones found at full resolution, frame by frame from the empty floor
+    double getQuality()
+    {
+        PyramidTracking reference(1, false, m_floor);
+        PyramidTracking tracking(m_scale, m_refine, m_floor);
+        cv::Mat expected(424, 512, CV_8UC1), actual(424, 512, CV_8UC1), intersection, coverage;
+
+        double quality = 0;
+        for(int i = 0; i < m_frames.size(); i++)
+        {
+            reference.update(m_frames[i]);
+            tracking.update(m_frames[i]);
+            fillContours(reference.getContours(), expected);
+            fillContours(tracking.getContours(), actual);
+
+            cv::bitwise_and(expected, actual, intersection);
+            cv::bitwise_or(expected, actual, coverage);
+            quality += double(cv::countNonZero(intersection))/max(cv::countNonZero(coverage), 1);
+        }
+
+        return quality/m_frames.size();
+    }
+
+private:
+
+    ofPixels                    m_floor;
+    vector<ofPixels>            m_frames;
+    int                         m_scale;
+    bool                        m_refine;
+    ofPtr<PyramidTracking>      m_tracking;
+};
+
+class TrackerBenchmark: public MicroBenchmark
+{
+public:
+
+    TrackerBenchmark(int numObjects): m_frames(NUM_FRAMES)
+    {
+        // the area grows with the number of objects, so they are as crowded at every size
+        float side = sqrt(float(numObjects))*40;
+
+        ofSeedRandom(SEED);
+        for(int i = 0; i < numObjects; i++)
+        {
+            ofVec2f position(ofRandom(side), ofRandom(side));
+            ofVec2f velocity = ofVec2f(ofRandom(1, 3), 0).getRotatedRad(ofRandom(TWO_PI));
+            for(int j = 0; j < m_frames.size(); j++) {
+                ofVec2f p = position + velocity*j;
+                m_frames[j].push_back(cv::Rect(p.x, p.y, 20, 20));
+            }
+        }
+
+        m_tracker.setPersistence(5*30);
+        m_tracker.setMaximumDistance(64);
+    }
+
+    void run(int iteration) {m_tracker.track(m_frames[iteration % m_frames.size()]);}
+
+private:
+
+    vector<vector<cv::Rect> >   m_frames;
+    RectTracker                 m_tracker;
+};
+
+class SmoothPolylineBenchmark: public MicroBenchmark
+{
+public:
+
+    SmoothPolylineBenchmark(int numVertices): m_polyline(makePolyline(makeOutline(numVertices, 100, ofVec2f(256, 212)))) {}
+
+    void run(int iteration) {m_smoothed = m_polyline.getSmoothed(5, 0.5);}
+
+private:
+
+    ofPolyline      m_polyline;
+    ofPolyline      m_smoothed;
+};
+
+class SimplifyPolylineBenchmark: public MicroBenchmark
+{
+public:
+
+    SimplifyPolylineBenchmark(int numVertices): m_polyline(makePolyline(makeOutline(numVertices, 100, ofVec2f(256, 212)))) {}
+
+    // simplifying works in place, so every iteration gets its own copy
+    void prepare(int numIterations) {m_copies.assign(numIterations, m_polyline);}
+
+    void run(int iteration) {m_copies[iteration].simplify(1.0);}
+
+private:
+
+    ofPolyline              m_polyline;
+    vector<ofPolyline>      m_copies;
+};
+
+class ContourSetBenchmark: public MicroBenchmark
+{
+public:
+
+    ContourSetBenchmark(int numVertices, bool simplify): m_simplify(simplify)
+    {
+        addOutline(m_contours, makeOutline(numVertices, 100, ofVec2f(256, 212)), 1);
+    }
+
+    // both work in place, so every iteration gets its own copy
+    void prepare(int numIterations)
+    {
+        m_copies.resize(numIterations);
+        for(int i = 0; i < m_copies.size(); i++) {
+            m_copies[i].copyFrom(m_contours);
+        }
+    }
+
+    void run(int iteration)
+    {
+        if(m_simplify){
+            m_copies[iteration].simplify(1.0);
+        }
+        else{
+            m_copies[iteration].smooth(5, 0.5);
+        }
+    }
+
+private:
+
+    ContourSet              m_contours;
+    vector<ContourSet>      m_copies;
+    bool                    m_simplify;
+};
+
+class BlurBenchmark: public MicroBenchmark
+{
+public:
+
+    BlurBenchmark(int radius): m_size(2*radius + 1, 2*radius + 1)
+    {
+        // the fbo the blur reads is RGB
+        m_image = cv::Mat::zeros(424, 512, CV_8UC3);
+        drawBlobs(m_image, 20, 0.1, 0, cv::Scalar::all(255));
+    }
+
+    void run(int iteration) {cv::GaussianBlur(m_image, m_blurred, m_size, 0);}
+
+private:
+
+    cv::Mat         m_image;
+    cv::Mat         m_blurred;
+    cv::Size        m_size;
+};
+
+//! The opening of a mask of people with sensor specks, on 8-bit pixels with OpenCV or on bits
+class MorphologyBenchmark: public MicroBenchmark
+{
+public:
+
+    MorphologyBenchmark(int radius, bool packed): m_element(StructuringElement::ELLIPSE, radius), m_packed(packed)
+    {
+        m_pixels.allocate(512, 424, 1);
+        m_pixels.set(0);
+        m_image = toCv(m_pixels);
+        drawBlobs(m_image, 20, 0.1, 0, cv::Scalar::all(255));
+
+        ofSeedRandom(SEED);
+        for(int i = 0; i < m_image.rows*m_image.cols/100; i++) {
+            m_image.at<unsigned char>(ofRandom(m_image.rows), ofRandom(m_image.cols)) ^= 255;
+        }
+
+        m_kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2*radius + 1, 2*radius + 1));
+        m_mask.threshold(m_pixels, 128);
+    }
+
+    void run(int iteration)
+    {
+        // the bits are opened in place, so every iteration starts from a copy
+        if(m_packed){
+            m_opened = m_mask;
+            m_filter.open(m_opened, m_element);
+        }
+        else{
+            cv::morphologyEx(m_image, m_filtered, cv::MORPH_OPEN, m_kernel);
+        }
+    }
+
+    // the fraction of pixels the same as the opening of OpenCV
+    double getQuality()
+    {
+        if(!m_packed){
+            return -1;
+        }
+
+        cv::morphologyEx(m_image, m_filtered, cv::MORPH_OPEN, m_kernel);
+        this->run(0);
+        m_opened.unpack(m_unpacked);
+        return 1.0 - double(cv::countNonZero(m_filtered != toCv(m_unpacked)))/(m_image.rows*m_image.cols);
+    }
+
+private:
+
+    ofPixels            m_pixels;
+    ofPixels            m_unpacked;
+    cv::Mat             m_image;
+    cv::Mat             m_filtered;
+    cv::Mat             m_kernel;
+    BitMask             m_mask;
+    BitMask             m_opened;
+    BitMaskFilter       m_filter;
+    StructuringElement  m_element;
+    bool                m_packed;
+};
+
+class OscSerialisationBenchmark: public MicroBenchmark
+{
+public:
+
+    OscSerialisationBenchmark(int numContours, int numVertices, int encoding): m_frames(NUM_FRAMES), m_encoding(encoding)
+    {
+        // the contours move from frame to frame, for the stream encoding to have deltas to send
+        for(int i = 0; i < m_frames.size(); i++)
+        {
+            OscFrame& frame = m_frames[i];
+            frame.type = OscFrame::CONTOURS;
+            frame.encoding = encoding;
+            frame.bundle = true;
+            frame.keyframe = false;
+            frame.keyframeInterval = 30;
+            frame.streamTolerance = 0.5;
+            frame.degradation = -1;
+            frame.contours.setTimestamp(1000000 + i*33333);
+
+            for(int j = 0; j < numContours; j++) {
+                addOutline(frame.contours, makeOutline(numVertices, 30, ofVec2f(40 + 60*(j % 8) + i, 60 + 100*(j / 8))), j + 1);
+            }
+        }
+    }
+
+    void run(int iteration) {m_oscManager.serialise(m_frames[iteration % m_frames.size()], m_encoding);}
+
+private:
+
+    vector<OscFrame>    m_frames;
+    OscManager          m_oscManager;
+    int                 m_encoding;
+};
+
+class FftBenchmark: public MicroBenchmark
+{
+public:
+
+    FftBenchmark(bool onlyAudioData): m_onlyAudioData(onlyAudioData)
+    {
+        m_samples.resize(m_fft.getBufferSize());
+        for(int i = 0; i < m_samples.size(); i++) {
+            m_samples[i] = 0.5*sin(TWO_PI*i*8/m_samples.size()) + 0.2*sin(TWO_PI*i*45/m_samples.size()) + ofRandom(-0.05, 0.05);
+        }
+
+        m_magnitudes.resize(m_samples.size()/2);
+        for(int i = 0; i < m_magnitudes.size(); i++) {
+            m_magnitudes[i] = ofRandom(0, 2);
+        }
+        m_fft.initAudioData(m_audioData, m_magnitudes.size());
+        m_fft.audioIn(&m_samples[0]);
+    }
+
+    void run(int iteration)
+    {
+        if(m_onlyAudioData){
+            m_fft.updateAudioData(m_audioData, &m_magnitudes[0]);
+        }
+        else{
+            m_fft.update();
+        }
+    }
+
+private:
+
+    ofxFFTBase          m_fft;
+    ofxFFTData          m_audioData;
+    vector<float>       m_samples;
+    vector<float>       m_magnitudes;
+    bool                m_onlyAudioData;
+};
+
+
+//--------------------------------------------------------------
+
+MicroBenchmarks::MicroBenchmarks(const string& filter): m_filter(filter)
+{
+    //Intentionally left empty
+}
+
+int MicroBenchmarks::run()
+{
+    ofLogNotice() <<"MicroBenchmarks::run -> " << (m_filter.empty() ? "all the operations" : "operations matching \"" + m_filter + "\"")
+                  << ", " << NUM_BATCHES << " batches of at least " << MIN_BATCH_TIME << " us";
+
+    this->runBackground();
+    this->runContourFinder();
+    this->runIncrementalContourFinder();
+    this->runTracker();
+    this->runPolylines();
+    this->runContourSet();
+    this->runPyramid();
+    this->runBlur();
+    this->runMorphology();
+    this->runOscSerialisation();
+    this->runFft();
+
+    this->writeResults();
+    return 0;
+}
+
+void MicroBenchmarks::runBackground()
+{
+    string name = "RunningBackground::update";
+    if(!this->isSelected(name)){
+        return;
+    }
+
+    int sizes[] = {1, 2};
+    for(int i = 0; i < 2; i++) {
+        int width = 512*sizes[i], height = 424*sizes[i];
+        BackgroundBenchmark benchmark(width, height, 20);
+        this->measure(name, ofToString(width) + "x" + ofToString(height), benchmark);
+    }
+}
+
+void MicroBenchmarks::runContourFinder()
+{
+    string name = "ContourFinder::findContours";
+    if(!this->isSelected(name)){
+        return;
+    }
+
+    int blobs[] = {1, 10, 50, 200};
+    float densities[] = {0.05, 0.25, 0.5};
+    for(int i = 0; i < 4; i++) {
+        for(int j = 0; j < 3; j++) {
+            ContourFinderBenchmark benchmark(blobs[i], densities[j]);
+            this->measure(name, "blobs=" + ofToString(blobs[i]) + " density=" + ofToString(densities[j]), benchmark);
+        }
+    }
+}
+
+void MicroBenchmarks::runIncrementalContourFinder()
+{
+    string name = "IncrementalContourFinder::findContours";
+    if(!this->isSelected(name)){
+        return;
+    }
+
+    int moving[] = {1, 4, 16};
+    for(int i = 0; i < 3; i++) {
+        for(int incremental = 0; incremental < 2; incremental++) {
+            IncrementalBenchmark benchmark(moving[i], incremental);
+            this->measure(name, "still=40 moving=" + ofToString(moving[i]) + (incremental ? " incremental" : " rescan"), benchmark);
+        }
+    }
+}
+
+void MicroBenchmarks::runTracker()
+{
+    string name = "RectTracker::track";
+    if(!this->isSelected(name)){
+        return;
+    }
+
+    int objects[] = {10, 100, 1000, 5000};
+    for(int i = 0; i < 4; i++) {
+        TrackerBenchmark benchmark(objects[i]);
+        this->measure(name, "objects=" + ofToString(objects[i]), benchmark);
+    }
+}
+
+void MicroBenchmarks::runPolylines()
+{
+    int vertices[] = {64, 256, 1024, 4096};
+
+    if(this->isSelected("ofPolyline::getSmoothed")){
+        for(int i = 0; i < 4; i++) {
+            SmoothPolylineBenchmark benchmark(vertices[i]);
+            this->measure("ofPolyline::getSmoothed", "vertices=" + ofToString(vertices[i]) + " size=5 shape=0.5", benchmark);
+        }
+    }
+
+    if(this->isSelected("ofPolyline::simplify")){
+        for(int i = 0; i < 4; i++) {
+            SimplifyPolylineBenchmark benchmark(vertices[i]);
+            this->measure("ofPolyline::simplify", "vertices=" + ofToString(vertices[i]) + " tolerance=1", benchmark);
+        }
+    }
+}
+
+void MicroBenchmarks::runContourSet()
+{
+    int vertices[] = {64, 256, 1024, 4096};
+
+    if(this->isSelected("ContourSet::smooth")){
+        for(int i = 0; i < 4; i++) {
+            ContourSetBenchmark benchmark(vertices[i], false);
+            this->measure("ContourSet::smooth", "vertices=" + ofToString(vertices[i]) + " size=5 shape=0.5", benchmark);
+        }
+    }
+
+    if(this->isSelected("ContourSet::simplify")){
+        for(int i = 0; i < 4; i++) {
+            ContourSetBenchmark benchmark(vertices[i], true);
+            this->measure("ContourSet::simplify", "vertices=" + ofToString(vertices[i]) + " tolerance=1", benchmark);
+        }
+    }
+}
+
+void MicroBenchmarks::runPyramid()
+{
+    // the full resolution first, the quality of the others is measured against it
+    string name = "ContourPyramid::track";
+    if(!this->isSelected(name)){
+        return;
+    }
+
+    PyramidBenchmark reference(1, false);
+    this->measure(name, "512x424 full", reference);
+
+    int scales[] = {2, 4};
+    for(int i = 0; i < 2; i++) {
+        for(int refine = 0; refine < 2; refine++) {
+            PyramidBenchmark benchmark(scales[i], refine);
+            this->measure(name, "512x424 1/" + ofToString(scales[i]) + (refine ? " refined" : " upscaled"), benchmark);
+        }
+    }
+}
+
+void MicroBenchmarks::runBlur()
+{
+    // the CPU equivalent of the ofxBlur passes, to compare with the GPU
+    string name = "cv::GaussianBlur";
+    if(!this->isSelected(name)){
+        return;
+    }
+
+    int radii[] = {2, 4, 8};
+    for(int i = 0; i < 3; i++) {
+        BlurBenchmark benchmark(radii[i]);
+        this->measure(name, "512x424 RGB radius=" + ofToString(radii[i]), benchmark);
+    }
+}
+
+void MicroBenchmarks::runMorphology()
+{
+    // the bits stand in for the blur, so they are measured against the 8-bit opening they replace
+    int radii[] = {1, 2, 4};
+
+    if(this->isSelected("cv::morphologyEx")){
+        for(int i = 0; i < 3; i++) {
+            MorphologyBenchmark benchmark(radii[i], false);
+            this->measure("cv::morphologyEx", "512x424 open ellipse radius=" + ofToString(radii[i]), benchmark);
+        }
+    }
+
+    if(this->isSelected("BitMaskFilter::open")){
+        for(int i = 0; i < 3; i++) {
+            MorphologyBenchmark benchmark(radii[i], true);
+            this->measure("BitMaskFilter::open", "512x424 open ellipse radius=" + ofToString(radii[i]), benchmark);
+        }
+    }
+}
+
+void MicroBenchmarks::runOscSerialisation()
+{
+    string name = "OscManager::serialise";
+    if(!this->isSelected(name)){
+        return;
+    }
+
+    // the bundles are packed by the predicted message sizes, so they are checked against oscpack for every type tag padding
+    vector<char> buffer(1024);
+    OscMessage message;
+    for(int numArgs = 0; numArgs <= 8; numArgs++)
+    {
+        message.clear();
+        message.setAddress("/MurmurRenderer/Check");
+        for(int i = 0; i < numArgs; i++) {
+            message.addFloatArg(i);
+        }
+
+        osc::OutboundPacketStream p(&buffer[0], buffer.size());
+        message.serialise(p);
+        if(p.Size() != message.getSize()){
+            ofLogError() <<"MicroBenchmarks::runOscSerialisation -> OscMessage::getSize() predicts " << message.getSize() << " bytes for "
+                         << numArgs << " arguments, oscpack writes " << p.Size();
+        }
+    }
+
+    int encodings[] = {OscManager::ENCODING_FLOAT, OscManager::ENCODING_QUANTIZED, OscManager::ENCODING_DELTA, OscManager::ENCODING_STREAM};
+    const char* encodingNames[] = {"float", "quantized", "delta", "stream"};
+    int contours[] = {1, 16};
+    for(int i = 0; i < 4; i++) {
+        for(int j = 0; j < 2; j++) {
+            OscSerialisationBenchmark benchmark(contours[j], 256, encodings[i]);
+            this->measure(name, string(encodingNames[i]) + " contours=" + ofToString(contours[j]) + " vertices=256", benchmark);
+        }
+    }
+}
+
+void MicroBenchmarks::runFft()
+{
+    if(this->isSelected("ofxFFTBase::update")){
+        FftBenchmark benchmark(false);
+        this->measure("ofxFFTBase::update", "buffer=512", benchmark);
+    }
+
+    if(this->isSelected("ofxFFTBase::updateAudioData")){
+        FftBenchmark benchmark(true);
+        this->measure("ofxFFTBase::updateAudioData", "bins=256", benchmark);
+    }
+}
+
+void MicroBenchmarks::measure(const string& name, const string& parameters, MicroBenchmark& benchmark)
+{
+    // the iterations of a batch are doubled until it is long enough to time, which also warms the caches up
+    int numIterations = 1;
+    while(true)
+    {
+        benchmark.prepare(numIterations);
+        unsigned long long start = ofGetElapsedTimeMicros();
+        for(int i = 0; i < numIterations; i++) {
+            benchmark.run(i);
+        }
+
+        if(ofGetElapsedTimeMicros() - start >= MIN_BATCH_TIME || numIterations >= MAX_ITERATIONS){
+            break;
+        }
+        numIterations *= 2;
+    }
+
+    vector<double> times;
+    for(int batch = 0; batch < WARMUP_BATCHES + NUM_BATCHES; batch++)
+    {
+        benchmark.prepare(numIterations);
+        unsigned long long start = ofGetElapsedTimeMicros();
+        for(int i = 0; i < numIterations; i++) {
+            benchmark.run(i);
+        }
+        unsigned long long elapsed = ofGetElapsedTimeMicros() - start;
+
+        if(batch >= WARMUP_BATCHES){
+            times.push_back(elapsed*1000.0/numIterations);
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+
+    Result result;
+    result.name = name;
+    result.parameters = parameters;
+    result.numIterations = numIterations;
+    result.min = times.front();
+    result.max = times.back();
+    result.median = (times[(times.size() - 1)/2] + times[times.size()/2])/2;
+    result.mean = 0;
+    for(int i = 0; i < times.size(); i++) {
+        result.mean += times[i];
+    }
+    result.mean /= times.size();
+    result.deviation = 0;
+    for(int i = 0; i < times.size(); i++) {
+        result.deviation += (times[i] - result.mean)*(times[i] - result.mean);
+    }
+    result.deviation = sqrt(result.deviation/max(int(times.size()) - 1, 1));
+    result.quality = benchmark.getQuality();
+    m_results.push_back(result);
+
+    ofLogNotice() <<"MicroBenchmarks::measure -> " << name << " [" << parameters << "]: median " << ofToString(result.median, 0) << " ns, mean "
+                  << ofToString(result.mean, 0) << " +- " << ofToString(result.deviation, 0) << " ns (" << numIterations << " iterations per batch)"
+                  << (result.quality >= 0 ? ", quality " + ofToString(result.quality, 3) : "");
+}
+
+bool MicroBenchmarks::isSelected(const string& name) const
+{
+    return m_filter.empty() || ofIsStringInString(name, m_filter);
+}
+
+void MicroBenchmarks::writeResults()
+{
+    ofDirectory::createDirectory(BenchmarkManager::BENCHMARKS_FOLDER, true, true);
+    string path = ofToDataPath(BenchmarkManager::BENCHMARKS_FOLDER + "micro_" + ofGetTimestampString("%Y%m%d_%H%M%S") + ".json");
+    ofFile file(path, ofFile::WriteOnly);
+
+    file << "{\n  \"unit\": \"ns\",\n  \"warmupBatches\": " << WARMUP_BATCHES << ",\n  \"batches\": " << NUM_BATCHES << ",\n  \"benchmarks\": [";
+    for(int i = 0; i < m_results.size(); i++)
+    {
+        const Result& result = m_results[i];
+        file << (i > 0 ? ",\n" : "\n") << "    {\"name\": \"" << result.name << "\", \"parameters\": \"" << result.parameters
+             << "\", \"iterations\": " << result.numIterations << ", \"mean\": " << result.mean << ", \"median\": " << result.median
+             << ", \"deviation\": " << result.deviation << ", \"min\": " << result.min << ", \"max\": " << result.max;
+        if(result.quality >= 0){
+            file << ", \"quality\": " << result.quality;
+        }
+        file << "}";
+    }
+    file << "\n  ]\n}\n";
+
+    ofLogNotice() <<"MicroBenchmarks::writeResults -> " << path;
+}
+
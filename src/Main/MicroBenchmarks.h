@@ -0,0 +1,125 @@
+/*
+ *  MicroBenchmarks.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+
+#pragma once
+
+#include "ofMain.h"
+
+
+//========================== class MicroBenchmark ==============================
+//============================================================================
+/** \class MicroBenchmark MicroBenchmarks.h
+ *	\brief One measured operation of the micro benchmark suite, on synthetic input
+ */
+
+class MicroBenchmark
+{
+    
+public:
+    
+    //! Destructor
+    virtual ~MicroBenchmark() {}
+    
+    //! Prepares the input of the given number of iterations, untimed
+    virtual void prepare(int numIterations) {}
+    
+    //! Runs one iteration of the operation
+    virtual void run(int iteration) = 0;
+    
+    //! Returns how close the output is to the exact one, from 0 to 1, or a negative value for an exact operation
+    virtual double getQuality() {return -1;}
+};
+
+
+//========================== class MicroBenchmarks ==============================
+//============================================================================
+/** \class MicroBenchmarks MicroBenchmarks.h
+ *	\brief Suite timing the vision, contour, OSC and audio primitives one by one
+ *	\details Started with --microbenchmarks [<filter>], before any window is opened.
+ *    Every operation runs on synthetic input generated from a fixed seed over a range
+ *    of sizes. The number of iterations of a batch is doubled until a batch takes
+ *    MIN_BATCH_TIME, which also warms the caches up, then WARMUP_BATCHES are run
+ *    untimed and NUM_BATCHES timed. The mean, median, deviation, minimum and maximum
+ *    time per iteration over the batches are logged and written as JSON into the
+ *    benchmarks folder, so two builds can be compared operation by operation. An
+ *    approximate operation also reports the quality of its output, to weigh it
+ *    against the time it saves.
+ */
+
+class MicroBenchmarks
+{
+    
+public:
+    
+    static const int WARMUP_BATCHES;                    ///< batches run before timing
+    static const int NUM_BATCHES;                       ///< batches timed
+    static const unsigned long long MIN_BATCH_TIME;     ///< minimum duration of a batch, in microseconds
+    
+    //! Constructor, only the operations whose name contains the filter are run
+    MicroBenchmarks(const string& filter = "");
+    
+    //! Runs the suite and writes the results. Returns the exit status
+    int run();
+    
+private:
+    
+    //! Statistics of an operation, in nanoseconds per iteration
+    struct Result
+    {
+        string      name;               ///< operation measured
+        string      parameters;         ///< input of the operation
+        int         numIterations;      ///< iterations of every batch
+        double      mean;               ///< mean time
+        double      median;             ///< median time
+        double      deviation;          ///< standard deviation of the time
+        double      min;                ///< fastest batch
+        double      max;                ///< slowest batch
+        double      quality;            ///< closeness of the output to the exact one, negative for an exact operation
+    };
+    
+    void runBackground();
+    
+    void runContourFinder();
+    
+    void runIncrementalContourFinder();
+    
+    void runTracker();
+    
+    void runPolylines();
+    
+    void runContourSet();
+    
+    void runPyramid();
+    
+    void runBlur();
+    
+    void runMorphology();
+    
+    void runOscSerialisation();
+    
+    void runFft();
+    
+    //! Measures an operation if its name passes the filter
+    void measure(const string& name, const string& parameters, MicroBenchmark& benchmark);
+    
+    //! Returns whether an operation passes the filter
+    bool isSelected(const string& name) const;
+    
+    //! Writes the results as JSON into the benchmarks folder
+    void writeResults();
+    
+private:
+    
+    string              m_filter;       ///< part of the name of the operations to run
+    vector<Result>      m_results;      ///< statistics of every operation measured
+};
+
+//==========================================================================
+
+
@@ -10,8 +10,18 @@
 
 #include "MurmurContourTrackingApp.h"
 
+MurmurContourTrackingApp::MurmurContourTrackingApp(const string& benchmarkRecording, const string& benchmarkGolden):
+    m_benchmarkRecording(benchmarkRecording), m_benchmarkGolden(benchmarkGolden)
+{
+    //Intentionally left empty
+}
+
 //--------------------------------------------------------------
 void MurmurContourTrackingApp::setup(){
+    if(!m_benchmarkRecording.empty()){
+        AppManager::getInstance().getBenchmarkManager().setRecording(m_benchmarkRecording, m_benchmarkGolden);
+    }
+    
     AppManager::getInstance().setup();
 }
 
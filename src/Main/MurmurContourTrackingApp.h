@@ -13,9 +13,16 @@
 class MurmurContourTrackingApp : public ofBaseApp{
 
 	public:
+		//! Constructor, a recording makes the application run it as a benchmark
+		MurmurContourTrackingApp(const string& benchmarkRecording = "", const string& benchmarkGolden = "");
+		
 		void setup();
 		void update();
 		void draw();
 		void exit();
+		
+	private:
+		string m_benchmarkRecording;	///< depth recording replayed as a benchmark, empty to run normally
+		string m_benchmarkGolden;		///< golden hash file of the benchmark, empty for the one next to the recording
 };
 
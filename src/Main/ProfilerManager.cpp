@@ -0,0 +1,247 @@
+/*
+ *  ProfilerManager.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ProfilerManager.h"
+#include "TextVisual.h"
+#include "AppManager.h"
+
+
+const float ProfilerManager::REPORT_PERIOD = 1.0;
+const string ProfilerManager::PROFILES_FOLDER = "profiles/";
+
+
+ProfilerManager::ProfilerManager(): Manager(), m_enabled(false), m_reportTime(0)
+{
+    //Intentionally left empty
+}
+
+
+ProfilerManager::~ProfilerManager()
+{
+    ofLogNotice() <<"ProfilerManager::destructor";
+}
+
+
+//--------------------------------------------------------------
+
+void ProfilerManager::setup()
+{
+    if(m_initialized)
+        return;
+    
+    Manager::setup();
+    
+    this->setupText();
+    
+    ofLogNotice() <<"ProfilerManager::initialized" ;
+}
+
+void ProfilerManager::setupText()
+{
+    TrackingManager& trackingManager = AppManager::getInstance().getTrackingManager();
+    int fontSize = 12;
+    ofVec3f position;
+    position.x = trackingManager.getPosition().x + trackingManager.getWidth() + LayoutManager::MARGIN;
+    position.y = trackingManager.getPosition().y;
+    int width = 400;
+    int height = fontSize*(NUM_STAGES + NUM_ALLOCATIONS + 2);
+    
+    m_text = ofPtr<TextVisual> (new TextVisual(position, width, height));
+    m_text->setText(">> Profiler", "fonts/open-sans/OpenSans-Semibold.ttf", fontSize);
+    m_text->setColor(ofColor::white);
+    m_text->setLineHeight(2.5);
+}
+
+void ProfilerManager::update()
+{
+    if(!this->isEnabled()){
+        return;
+    }
+    
+    float time = ofGetElapsedTimef();
+    if(time - m_reportTime < REPORT_PERIOD){
+        return;
+    }
+    
+    m_reportTime = time;
+    this->report();
+}
+
+void ProfilerManager::report()
+{
+    for(int i = 0; i < NUM_STAGES; i++) {
+        m_reports[i].clear();
+        m_histograms[i].moveTo(m_reports[i]);
+        m_totals[i].add(m_reports[i]);
+    }
+    
+    for(int i = 0; i < NUM_ALLOCATIONS; i++) {
+        m_allocationReports[i].clear();
+        m_allocationHistograms[i].moveTo(m_allocationReports[i]);
+        m_allocationTotals[i].add(m_allocationReports[i]);
+    }
+    
+    this->updateText();
+    this->sendStats();
+}
+
+void ProfilerManager::updateText()
+{
+    string text = ">> Profiler (us): p50 / p95 / p99 / max";
+    for(int i = 0; i < NUM_STAGES; i++)
+    {
+        const ProfileHistogram& histogram = m_reports[i];
+        text += ("\n   " + string(getStageName(i)) + ": " + ofToString(histogram.getPercentile(50)) + " / " +
+                 ofToString(histogram.getPercentile(95)) + " / " + ofToString(histogram.getPercentile(99)) + " / " +
+                 ofToString(histogram.getMax()));
+    }
+    
+    text += "\n>> Allocations per frame: p50 / p99 / max";
+    for(int i = 0; i < NUM_ALLOCATIONS; i++)
+    {
+        const ProfileHistogram& histogram = m_allocationReports[i];
+        text += ("\n   " + string(getAllocationsName(i)) + ": " + ofToString(histogram.getPercentile(50)) + " / " +
+                 ofToString(histogram.getPercentile(99)) + " / " + ofToString(histogram.getMax()));
+    }
+    
+    m_text->setText(text);
+}
+
+void ProfilerManager::sendStats()
+{
+    // the name and the p50, p95 and p99 in microseconds of every stage
+    m_statsMessage.clear();
+    m_statsMessage.setAddress("/MurmurContourTracking/Stats");
+    for(int i = 0; i < NUM_STAGES; i++)
+    {
+        m_statsMessage.addStringArg(getStageName(i));
+        m_statsMessage.addIntArg(m_reports[i].getPercentile(50));
+        m_statsMessage.addIntArg(m_reports[i].getPercentile(95));
+        m_statsMessage.addIntArg(m_reports[i].getPercentile(99));
+    }
+    
+    // followed by the allocations of the frames, the same way
+    for(int i = 0; i < NUM_ALLOCATIONS; i++)
+    {
+        m_statsMessage.addStringArg(getAllocationsName(i));
+        m_statsMessage.addIntArg(m_allocationReports[i].getPercentile(50));
+        m_statsMessage.addIntArg(m_allocationReports[i].getPercentile(95));
+        m_statsMessage.addIntArg(m_allocationReports[i].getPercentile(99));
+    }
+    
+    AppManager::getInstance().getOscManager().sendMessage(m_statsMessage);
+}
+
+void ProfilerManager::draw()
+{
+    if(!this->isEnabled()){
+        return;
+    }
+    
+    m_text->draw();
+}
+
+void ProfilerManager::dumpCsv()
+{
+    string path = this->getFilePath("csv");
+    ofFile file(path, ofFile::WriteOnly);
+    
+    file << "stage,count,mean,p50,p95,p99,max" << endl;
+    for(int i = 0; i < NUM_STAGES; i++)
+    {
+        const ProfileHistogram& histogram = m_totals[i];
+        file << getStageName(i) << "," << histogram.getCount() << "," << histogram.getMean() << "," << histogram.getPercentile(50) << ","
+             << histogram.getPercentile(95) << "," << histogram.getPercentile(99) << "," << histogram.getMax() << endl;
+    }
+    
+    for(int i = 0; i < NUM_ALLOCATIONS; i++)
+    {
+        const ProfileHistogram& histogram = m_allocationTotals[i];
+        file << getAllocationsName(i) << "," << histogram.getCount() << "," << histogram.getMean() << "," << histogram.getPercentile(50) << ","
+             << histogram.getPercentile(95) << "," << histogram.getPercentile(99) << "," << histogram.getMax() << endl;
+    }
+    
+    ofLogNotice() <<"ProfilerManager::dumpCsv -> " << path;
+}
+
+void ProfilerManager::dumpJson()
+{
+    string path = this->getFilePath("json");
+    ofFile file(path, ofFile::WriteOnly);
+    
+    file << "{\n  \"unit\": \"us\",\n  \"stages\": [";
+    for(int i = 0; i < NUM_STAGES; i++)
+    {
+        const ProfileHistogram& histogram = m_totals[i];
+        file << (i > 0 ? ",\n" : "\n") << "    {\"name\": \"" << getStageName(i) << "\", \"count\": " << histogram.getCount()
+             << ", \"mean\": " << histogram.getMean() << ", \"p50\": " << histogram.getPercentile(50) << ", \"p95\": "
+             << histogram.getPercentile(95) << ", \"p99\": " << histogram.getPercentile(99) << ", \"max\": " << histogram.getMax() << "}";
+    }
+    file << "\n  ],\n  \"allocations\": [";
+    for(int i = 0; i < NUM_ALLOCATIONS; i++)
+    {
+        const ProfileHistogram& histogram = m_allocationTotals[i];
+        file << (i > 0 ? ",\n" : "\n") << "    {\"name\": \"" << getAllocationsName(i) << "\", \"count\": " << histogram.getCount()
+             << ", \"mean\": " << histogram.getMean() << ", \"p50\": " << histogram.getPercentile(50) << ", \"p95\": "
+             << histogram.getPercentile(95) << ", \"p99\": " << histogram.getPercentile(99) << ", \"max\": " << histogram.getMax() << "}";
+    }
+    file << "\n  ]\n}\n";
+    
+    ofLogNotice() <<"ProfilerManager::dumpJson -> " << path;
+}
+
+string ProfilerManager::getFilePath(const string& extension) const
+{
+    ofDirectory::createDirectory(PROFILES_FOLDER, true, true);
+    return ofToDataPath(PROFILES_FOLDER + "profile_" + ofGetTimestampString("%Y%m%d_%H%M%S") + "." + extension);
+}
+
+const char* ProfilerManager::getStageName(int stage)
+{
+    static const char* names[NUM_STAGES] = {
+        "capture", "upload", "clip", "blur", "readPixels", "decimate", "background",
+        "morphology", "findContours", "refine", "contours", "oscSerialise", "oscSend", "audioFft"
+    };
+    
+    return names[stage];
+}
+
+const char* ProfilerManager::getAllocationsName(int allocations)
+{
+    static const char* names[NUM_ALLOCATIONS] = {"frameAllocations", "frameBytes"};
+    return names[allocations];
+}
+
+void ProfilerManager::recordAllocations(unsigned int numAllocations, unsigned int numBytes)
+{
+    if(!this->isEnabled()){
+        return;
+    }
+    
+    m_allocationHistograms[FRAME_ALLOCATIONS].record(numAllocations);
+    m_allocationHistograms[FRAME_BYTES].record(numBytes);
+}
+
+void ProfilerManager::onProfilerChange(bool & value)
+{
+    if(value && !this->isEnabled()){
+        // the totals start again every time the profiler is switched on
+        for(int i = 0; i < NUM_STAGES; i++) {
+            m_histograms[i].clear();
+            m_totals[i].clear();
+        }
+        for(int i = 0; i < NUM_ALLOCATIONS; i++) {
+            m_allocationHistograms[i].clear();
+            m_allocationTotals[i].clear();
+        }
+        m_reportTime = ofGetElapsedTimef();
+    }
+    
+    m_enabled.store(value, std::memory_order_relaxed);
+}
+
@@ -0,0 +1,172 @@
+/*
+ *  ProfilerManager.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+#include "Manager.h"
+#include "ProfileHistogram.h"
+#include "OscMessage.h"
+
+class TextVisual;
+
+//========================== class ProfilerManager ==============================
+//============================================================================
+/** \class ProfilerManager ProfilerManager.h
+ *	\brief Class timing every stage of the tracking pipeline
+ *	\details Every stage records its durations into a lock-free histogram from
+ *    whichever thread runs it. Once per report period the histograms are taken
+ *    away and their percentiles shown in the debug view and sent over OSC. The
+ *    totals since the profiler was switched on can be dumped as CSV or JSON. The heap
+ *    allocations of every frame go through histograms of their own.
+ *    While disabled, timing a stage costs a single test of a flag.
+ */
+
+
+class ProfilerManager: public Manager
+{
+    
+public:
+    
+    enum Stage {
+        STAGE_CAPTURE,          ///< camera update and frame swap
+        STAGE_UPLOAD,           ///< depth texture upload
+        STAGE_CLIP,             ///< depth clipping shader and cropping
+        STAGE_BLUR,             ///< blur passes
+        STAGE_READ_PIXELS,      ///< read back of the blurred frame
+        STAGE_DECIMATE,         ///< decimation of the frame for the coarse tracking
+        STAGE_BACKGROUND,       ///< background subtraction
+        STAGE_MORPHOLOGY,       ///< opening and closing of the bit-packed mask
+        STAGE_FIND_CONTOURS,    ///< contour finding and tracking
+        STAGE_REFINE,           ///< refinement of the coarse contours at full resolution
+        STAGE_CONTOURS,         ///< ranking, smoothing and simplification of the contours
+        STAGE_OSC_SERIALISE,    ///< serialisation of a frame, on the sender thread
+        STAGE_OSC_SEND,         ///< sending of a frame, on the sender thread
+        STAGE_AUDIO_FFT,        ///< audio FFT
+        NUM_STAGES
+    };
+    
+    enum Allocations {
+        FRAME_ALLOCATIONS,      ///< heap allocations of a frame through the pipeline
+        FRAME_BYTES,            ///< bytes allocated for a frame through the pipeline
+        NUM_ALLOCATIONS
+    };
+    
+    static const float REPORT_PERIOD;       ///< seconds between two reports
+    static const string PROFILES_FOLDER;    ///< data folder the profiles are dumped into
+    
+    //! Constructor
+    ProfilerManager();
+    
+    //! Destructor
+    ~ProfilerManager();
+    
+    //! Setup the Profiler Manager
+    void setup();
+    
+    //! Reports the stages once per report period
+    void update();
+    
+    //! Draws the latest report
+    void draw();
+    
+    //! Returns whether the stages are being timed
+    bool isEnabled() const {return m_enabled.load(std::memory_order_relaxed);}
+    
+    //! Takes the recorded durations away into the totals and reports them, update() does it once per report period
+    void report();
+    
+    //! Returns the durations of a stage since the profiler was switched on, up to the latest report
+    const ProfileHistogram& getTotals(int stage) const {return m_totals[stage];}
+    
+    //! Records the duration of a stage in microseconds, from any thread
+    void record(Stage stage, unsigned int duration) {m_histograms[stage].record(duration);}
+    
+    //! Records the heap allocations of a frame, from any thread
+    void recordAllocations(unsigned int numAllocations, unsigned int numBytes);
+    
+    //! Returns the allocations of the frames since the profiler was switched on, up to the latest report
+    const ProfileHistogram& getAllocationTotals(int allocations) const {return m_allocationTotals[allocations];}
+    
+    //! Writes the totals of every stage as CSV into the profiles folder
+    void dumpCsv();
+    
+    //! Writes the totals of every stage as JSON into the profiles folder
+    void dumpJson();
+    
+    //! Returns the name of a stage
+    static const char* getStageName(int stage);
+    
+    //! Returns the name of an allocation histogram
+    static const char* getAllocationsName(int allocations);
+    
+    //! Profiler toggle change controlled by GUI
+    void onProfilerChange(bool & value);
+    
+private:
+    
+    //! Setups the text visual of the report
+    void setupText();
+    
+    //! Updates the text visual with the latest report
+    void updateText();
+    
+    //! Sends the latest report over OSC
+    void sendStats();
+    
+    //! Returns the path of a new profile file with the given extension
+    string getFilePath(const string& extension) const;
+    
+    
+private:
+    
+    ProfileHistogram        m_histograms[NUM_STAGES];   ///< durations being recorded
+    ProfileHistogram        m_reports[NUM_STAGES];      ///< durations of the latest report period
+    ProfileHistogram        m_totals[NUM_STAGES];       ///< durations since the profiler was switched on
+    ProfileHistogram        m_allocationHistograms[NUM_ALLOCATIONS];    ///< allocations of the frames being recorded
+    ProfileHistogram        m_allocationReports[NUM_ALLOCATIONS];       ///< allocations of the frames of the latest report period
+    ProfileHistogram        m_allocationTotals[NUM_ALLOCATIONS];        ///< allocations of the frames since the profiler was switched on
+    std::atomic<bool>       m_enabled;                  ///< whether the stages are being timed
+    float                   m_reportTime;               ///< time of the latest report
+    OscMessage              m_statsMessage;             ///< reusable message of the latest report
+    ofPtr<TextVisual>       m_text;                     ///< latest report shown in the debug view
+    
+};
+
+
+//========================== class ProfileScope ==============================
+//============================================================================
+/** \class ProfileScope ProfilerManager.h
+ *	\brief Times a stage from its construction to the end of its scope
+ */
+
+class ProfileScope
+{
+
+public:
+
+    //! Constructor, starts timing the stage if the profiler is enabled
+    ProfileScope(ProfilerManager& profiler, ProfilerManager::Stage stage): m_profiler(profiler), m_stage(stage),
+        m_enabled(profiler.isEnabled()), m_startTime(m_enabled ? ofGetElapsedTimeMicros() : 0) {}
+
+    //! Destructor, records the duration of the stage
+    ~ProfileScope() {if(m_enabled) m_profiler.record(m_stage, ofGetElapsedTimeMicros() - m_startTime);}
+
+private:
+
+    ProfilerManager&            m_profiler;     ///< profiler the duration is recorded in
+    ProfilerManager::Stage      m_stage;        ///< stage being timed
+    bool                        m_enabled;      ///< whether the profiler was enabled when the stage started
+    unsigned long long          m_startTime;    ///< time the stage started, in microseconds
+};
+
+//==========================================================================
+
+
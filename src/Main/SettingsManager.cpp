@@ -46,6 +46,7 @@ void SettingsManager::loadAllSettings()
     this->setWindowProperties();
     this->setDebugProperties();
     this->setNetworkProperties();
+    this->loadDestinations();
     this->loadTextureSettings();
     this->loadSvgSettings();
     this->loadColors();
@@ -150,6 +151,43 @@ void SettingsManager::setNetworkProperties()
     ofLogNotice() <<"SettingsManager::setNetworkProperties->  path not found: " << networkPath ;
 }
 
+void SettingsManager::loadDestinations()
+{
+    m_xmlSettings.setTo("//");
+    
+    string destinationsPath = "//of_settings/destinations";
+    if(m_xmlSettings.exists(destinationsPath + "/destination[0]")) {
+        
+        typedef   std::map<string, string>   AttributesMap;
+        AttributesMap attributes;
+        
+        destinationsPath = "//of_settings/destinations/destination[0]";
+        m_xmlSettings.setTo(destinationsPath);
+        do {
+            
+            attributes = m_xmlSettings.getAttributes();
+            
+            DestinationSettings destination;
+            destination.name = attributes["name"];
+            destination.ipAddress = attributes["ipAddress"];
+            destination.port = ofToInt(attributes["port"]);
+            destination.encoding = attributes["encoding"];
+            destination.maxRate = ofToFloat(attributes["maxRate"]);
+            m_destinations.push_back(destination);
+            
+            ofLogNotice() <<"SettingsManager::loadDestinations->  destination = " << destination.name << ", ipAddress = " << destination.ipAddress
+            <<", port = "<< destination.port << ", encoding = " << destination.encoding << ", maxRate = " << destination.maxRate;
+        }
+        while(m_xmlSettings.setToSibling()); // go to the next destination
+        
+        
+        ofLogNotice() <<"SettingsManager::loadDestinations->  successfully loaded the network destinations" ;
+        return;
+    }
+    
+    ofLogNotice() <<"SettingsManager::loadDestinations->  path not found: " << destinationsPath ;
+}
+
 void SettingsManager::loadColors()
 {
     m_xmlSettings.setTo("//");
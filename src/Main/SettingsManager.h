@@ -22,6 +22,18 @@
 
 typedef  map<string,string>               ResourcesPathMap;       ///< defines a map of path attached to the resources name
 
+//! Network destination the frames are sent to, on top of the one of the network settings
+struct DestinationSettings
+{
+    string  name;           ///< name shown in the sending information
+    string  ipAddress;      ///< unicast or multicast address
+    int     port;           ///< UDP port
+    string  encoding;       ///< contour encoding: float, quantized, delta or stream
+    float   maxRate;        ///< maximum number of frames per second, 0 for no limit
+};
+
+typedef  vector<DestinationSettings>      DestinationSettingsVector;  ///< defines a list of network destinations
+
 
 class SettingsManager: public Manager
 {
@@ -54,6 +66,8 @@ class SettingsManager: public Manager
         int getPortReceive() const {return m_portReceive;}
     
         int getPortSend() const {return m_portSend;}
+    
+        const DestinationSettingsVector& getDestinations() const {return m_destinations;}
 
 
     private:
@@ -69,6 +83,9 @@ class SettingsManager: public Manager
 
         //! Sets all the network properties
         void setNetworkProperties();
+    
+        //! Loads the additional network destinations
+        void loadDestinations();
 
         //! Sets all the window properties
         void setWindowProperties();
@@ -97,6 +114,7 @@ class SettingsManager: public Manager
         int                     m_portReceive;          ///< stores the UDP port to receive from
         int                     m_portSend;             ///< stores the UDP port to send to
         string                  m_ipAddress;             ///< stores the Ip Address used for the Network communications
+        DestinationSettingsVector m_destinations;       ///< stores the additional network destinations
 };
 
 
@@ -1,12 +1,28 @@
 #include "ofMain.h"
 #include "ofAppGlutWindow.h"
 #include "MurmurContourTrackingApp.h"
+#include "MicroBenchmarks.h"
 
 
 //========================================================================
-int main( ){
+int main(int argc, char *argv[]){
 
+    // --microbenchmarks [<filter>] times the tracking primitives one by one and exits, no window is needed
+    if(argc >= 2 && string(argv[1]) == "--microbenchmarks"){
+        MicroBenchmarks benchmarks(argc >= 3 ? argv[2] : "");
+        return benchmarks.run();
+    }
+    
     ofAppGlutWindow window;
+    
+    // --benchmark <recording> [<golden file>] replays a depth recording as fast as it goes and exits,
+    // the window is only kept small for the GL context of the clipping and blur passes
+    if(argc >= 3 && string(argv[1]) == "--benchmark"){
+        ofSetupOpenGL(&window, 64, 64, OF_WINDOW);
+        ofRunApp( new MurmurContourTrackingApp(argv[2], argc >= 4 ? argv[3] : ""));
+        return 0;
+    }
+    
     ofSetupOpenGL(&window,1280, 1024, OF_WINDOW);
     ofRunApp( new MurmurContourTrackingApp());
 
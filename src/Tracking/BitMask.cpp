@@ -0,0 +1,346 @@
+/*
+ *  BitMask.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "BitMask.h"
+
+
+StructuringElement::StructuringElement(Shape shape, int radius): m_shape(shape), m_radius(max(radius, 0))
+{
+    m_halfWidths.resize(2*m_radius + 1);
+    for(int dy = -m_radius; dy <= m_radius; dy++)
+    {
+        int halfWidth = m_radius;
+        if(m_shape == CROSS){
+            halfWidth = dy == 0 ? m_radius : 0;
+        }
+        else if(m_shape == ELLIPSE){
+            halfWidth = floor(sqrt(double(m_radius*m_radius - dy*dy)) + 0.5);
+        }
+        m_halfWidths[dy + m_radius] = halfWidth;
+    }
+}
+
+
+BitMask::BitMask(): m_width(0), m_height(0), m_wordsPerRow(0), m_lastWordMask(0)
+{
+    //Intentionally left empty
+}
+
+
+BitMask::~BitMask()
+{
+    //Intentionally left empty
+}
+
+
+void BitMask::allocate(int width, int height)
+{
+    if(width == m_width && height == m_height && this->isAllocated()){
+        return;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_wordsPerRow = (width + 63)/64;
+
+    int lastBits = width - (m_wordsPerRow - 1)*64;
+    m_lastWordMask = lastBits >= 64 ? ~0ULL : (1ULL << lastBits) - 1;
+    m_words.assign(m_wordsPerRow*height, 0);
+}
+
+void BitMask::clear()
+{
+    std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+void BitMask::threshold(const ofPixels& pixels, int minValue)
+{
+    this->allocate(pixels.getWidth(), pixels.getHeight());
+
+    int numChannels = pixels.getNumChannels();
+    for(int y = 0; y < m_height; y++)
+    {
+        const unsigned char* row = pixels.getPixels() + y*m_width*numChannels;
+        uint64_t* words = this->getRow(y);
+        for(int i = 0; i < m_wordsPerRow; i++)
+        {
+            int x0 = i*64;
+            int x1 = min(x0 + 64, m_width);
+            uint64_t word = 0;
+            for(int x = x0; x < x1; x++) {
+                word |= uint64_t(row[x*numChannels] >= minValue) << (x - x0);
+            }
+            words[i] = word;
+        }
+    }
+}
+
+void BitMask::unpack(ofPixels& pixels) const
+{
+    if(pixels.getWidth() != m_width || pixels.getHeight() != m_height || pixels.getNumChannels() != 1){
+        pixels.allocate(m_width, m_height, 1);
+    }
+
+    // the rows are cleared, then the runs filled in
+    for(int y = 0; y < m_height; y++)
+    {
+        unsigned char* row = pixels.getPixels() + y*m_width;
+        const uint64_t* words = this->getRow(y);
+        memset(row, 0, m_width);
+
+        int start = this->findSet(words, 0);
+        while(start < m_width) {
+            int end = this->findClear(words, start);
+            memset(row + start, 255, end - start);
+            start = this->findSet(words, end);
+        }
+    }
+}
+
+int BitMask::count() const
+{
+    int numPixels = 0;
+    for(int i = 0; i < m_words.size(); i++) {
+        numPixels += __builtin_popcountll(m_words[i]);
+    }
+
+    return numPixels;
+}
+
+void BitMask::getRuns(vector<Run>& runs) const
+{
+    runs.clear();
+    for(int y = 0; y < m_height; y++)
+    {
+        const uint64_t* words = this->getRow(y);
+        int start = this->findSet(words, 0);
+        while(start < m_width) {
+            Run run;
+            run.y = y;
+            run.start = start;
+            run.end = this->findClear(words, start);
+            runs.push_back(run);
+            start = this->findSet(words, run.end);
+        }
+    }
+}
+
+int BitMask::findSet(const uint64_t* row, int x) const
+{
+    if(x >= m_width){
+        return m_width;
+    }
+
+    int i = x/64;
+    uint64_t word = row[i] & (~0ULL << (x % 64));
+    while(word == 0) {
+        if(++i == m_wordsPerRow){
+            return m_width;
+        }
+        word = row[i];
+    }
+
+    return i*64 + __builtin_ctzll(word);
+}
+
+int BitMask::findClear(const uint64_t* row, int x) const
+{
+    if(x >= m_width){
+        return m_width;
+    }
+
+    // the bits past the width are clear, so a run ends at the width at the latest
+    int i = x/64;
+    uint64_t word = ~row[i] & (~0ULL << (x % 64));
+    while(word == 0) {
+        if(++i == m_wordsPerRow){
+            return m_width;
+        }
+        word = ~row[i];
+    }
+
+    return min(i*64 + __builtin_ctzll(word), m_width);
+}
+
+
+BitMaskFilter::BitMaskFilter(): m_numWords(0)
+{
+    //Intentionally left empty
+}
+
+
+BitMaskFilter::~BitMaskFilter()
+{
+    //Intentionally left empty
+}
+
+
+void BitMaskFilter::erode(BitMask& mask, const StructuringElement& element)
+{
+    this->apply(mask, element, true);
+}
+
+void BitMaskFilter::dilate(BitMask& mask, const StructuringElement& element)
+{
+    this->apply(mask, element, false);
+}
+
+void BitMaskFilter::open(BitMask& mask, const StructuringElement& element)
+{
+    this->apply(mask, element, true);
+    this->apply(mask, element, false);
+}
+
+void BitMaskFilter::close(BitMask& mask, const StructuringElement& element)
+{
+    this->apply(mask, element, false);
+    this->apply(mask, element, true);
+}
+
+void BitMaskFilter::apply(BitMask& mask, const StructuringElement& element, bool erode)
+{
+    if(!mask.isAllocated()){
+        return;
+    }
+
+    // every half width of the element is passed once, whatever the number of rows it has
+    int radius = element.getRadius();
+    int maxHalfWidth = 0;
+    for(int dy = -radius; dy <= radius; dy++) {
+        maxHalfWidth = max(maxHalfWidth, element.getHalfWidth(dy));
+    }
+
+    // the passes only grow, so that elements of other sizes don't reallocate them every frame
+    if(m_passes.size() < maxHalfWidth + 1){
+        m_passes.resize(maxHalfWidth + 1);
+    }
+
+    m_used.assign(m_passes.size(), 0);
+    for(int dy = -radius; dy <= radius; dy++) {
+        int halfWidth = element.getHalfWidth(dy);
+        if(halfWidth >= 0 && !m_used[halfWidth]){
+            m_used[halfWidth] = 1;
+            this->passRows(mask, halfWidth, erode, m_passes[halfWidth]);
+        }
+    }
+
+    // the rows out of the mask are left out, which neither erodes nor dilates
+    int numWords = mask.getWordsPerRow();
+    uint64_t identity = erode ? ~0ULL : 0;
+    for(int y = 0; y < mask.getHeight(); y++)
+    {
+        uint64_t* result = mask.getRow(y);
+        std::fill(result, result + numWords, identity);
+
+        for(int dy = -radius; dy <= radius; dy++)
+        {
+            int halfWidth = element.getHalfWidth(dy);
+            int source = y + dy;
+            if(halfWidth < 0 || source < 0 || source >= mask.getHeight()){
+                continue;
+            }
+
+            const uint64_t* row = m_passes[halfWidth].getRow(source);
+            if(erode){
+                for(int i = 0; i < numWords; i++) {
+                    result[i] &= row[i];
+                }
+            }
+            else{
+                for(int i = 0; i < numWords; i++) {
+                    result[i] |= row[i];
+                }
+            }
+        }
+
+        result[numWords - 1] &= mask.getLastWordMask();
+    }
+}
+
+void BitMaskFilter::passRows(const BitMask& mask, int halfWidth, bool erode, BitMask& result)
+{
+    result.allocate(mask.getWidth(), mask.getHeight());
+
+    // the span starts half a width before the row, so it is long enough to hold the whole row shifted
+    int numWords = mask.getWordsPerRow();
+    m_numWords = (mask.getWidth() + halfWidth + 63)/64;
+    m_span.resize(m_numWords);
+    m_shifted.resize(m_numWords);
+
+    // past the ends of a row, the pixels count as set when eroding and as clear when dilating
+    uint64_t fill = erode ? ~0ULL : 0;
+    uint64_t lastWordMask = mask.getLastWordMask();
+    int length = 2*halfWidth + 1;
+
+    for(int y = 0; y < mask.getHeight(); y++)
+    {
+        const uint64_t* row = mask.getRow(y);
+        std::copy(row, row + numWords, m_shifted.begin());
+        std::fill(m_shifted.begin() + numWords, m_shifted.end(), fill);
+        m_shifted[numWords - 1] |= fill & ~lastWordMask;
+        this->shiftRow(&m_shifted[0], -halfWidth, fill, &m_span[0]);
+
+        // pixel x of the span combines the pixels from x to x + span - 1 of the shifted row, the span doubling every step
+        int span = 1;
+        while(2*span <= length) {
+            this->combine(span, fill, erode);
+            span *= 2;
+        }
+
+        if(span < length){
+            this->combine(length - span, fill, erode);
+        }
+
+        uint64_t* passed = result.getRow(y);
+        std::copy(m_span.begin(), m_span.begin() + numWords, passed);
+        passed[numWords - 1] &= lastWordMask;
+    }
+}
+
+void BitMaskFilter::combine(int shift, uint64_t fill, bool erode)
+{
+    this->shiftRow(&m_span[0], shift, fill, &m_shifted[0]);
+    if(erode){
+        for(int i = 0; i < m_numWords; i++) {
+            m_span[i] &= m_shifted[i];
+        }
+    }
+    else{
+        for(int i = 0; i < m_numWords; i++) {
+            m_span[i] |= m_shifted[i];
+        }
+    }
+}
+
+void BitMaskFilter::shiftRow(const uint64_t* row, int shift, uint64_t fill, uint64_t* result) const
+{
+    int wordShift = abs(shift)/64;
+    int bitShift = abs(shift) % 64;
+
+    if(shift >= 0)
+    {
+        // the pixels come down from the words above
+        for(int i = 0; i < m_numWords; i++) {
+            int j = i + wordShift;
+            uint64_t low = j < m_numWords ? row[j] : fill;
+            uint64_t high = j + 1 < m_numWords ? row[j + 1] : fill;
+            result[i] = bitShift == 0 ? low : (low >> bitShift) | (high << (64 - bitShift));
+        }
+    }
+    else
+    {
+        // the pixels go up from the words below
+        for(int i = 0; i < m_numWords; i++) {
+            int j = i - wordShift;
+            uint64_t high = j >= 0 ? row[j] : fill;
+            uint64_t low = j - 1 >= 0 ? row[j - 1] : fill;
+            result[i] = bitShift == 0 ? high : (high << bitShift) | (low >> (64 - bitShift));
+        }
+    }
+}
+
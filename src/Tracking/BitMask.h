@@ -0,0 +1,204 @@
+/*
+ *  BitMask.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+
+
+//========================== class StructuringElement ==============================
+//============================================================================
+/** \class StructuringElement BitMask.h
+ *	\brief Shape the morphology of a BitMask works with
+ *	\details Every shape is symmetric and convex, so it is kept as the half width of
+ *    each of its rows, from -radius to radius; -1 for a row it doesn't cover. The
+ *    ellipse is the one OpenCV builds for the same size.
+ */
+
+class StructuringElement
+{
+
+public:
+
+    enum Shape {
+        RECTANGLE,
+        CROSS,
+        ELLIPSE,
+        NUM_SHAPES
+    };
+
+    //! Constructor, 2*radius + 1 pixels on each side
+    StructuringElement(Shape shape = RECTANGLE, int radius = 1);
+
+    //! Returns the shape
+    Shape getShape() const {return m_shape;}
+
+    //! Returns the number of rows above and below the centre
+    int getRadius() const {return m_radius;}
+
+    //! Returns the half width of the row at the given offset from the centre, -1 if it covers no pixel
+    int getHalfWidth(int dy) const {return m_halfWidths[dy + m_radius];}
+
+private:
+
+    Shape           m_shape;            ///< shape of the element
+    int             m_radius;           ///< rows above and below the centre
+    vector<int>     m_halfWidths;       ///< half width of every row, from the top one
+};
+
+
+//========================== class BitMask ==============================
+//============================================================================
+/** \class BitMask BitMask.h
+ *	\brief Binary mask packed one bit per pixel
+ *	\details Pixel x of a row is bit x % 64 of its word x / 64, and every row starts on
+ *    a word of its own; the bits past the width are kept clear. A 512x424 mask is
+ *    27 KB, an eighth of the 8-bit mask OpenCV works with, and the area is counted
+ *    a word at a time. The runs of set pixels can be exported row by row, which is
+ *    how the mask is unpacked for the contour finder.
+ */
+
+class BitMask
+{
+
+public:
+
+    //! A horizontal run of set pixels
+    struct Run
+    {
+        int         y;                  ///< row of the run
+        int         start;              ///< first pixel of the run
+        int         end;                ///< pixel past the last one of the run
+    };
+
+    //! Constructor
+    BitMask();
+
+    //! Destructor
+    ~BitMask();
+
+    //! Allocates a cleared mask of the given size, or keeps the pixels if it already has that size
+    void allocate(int width, int height);
+
+    //! Returns whether the mask has been allocated
+    bool isAllocated() const {return !m_words.empty();}
+
+    //! Returns the width in pixels
+    int getWidth() const {return m_width;}
+
+    //! Returns the height in pixels
+    int getHeight() const {return m_height;}
+
+    //! Returns the number of words of a row
+    int getWordsPerRow() const {return m_wordsPerRow;}
+
+    //! Returns the words of a row
+    uint64_t* getRow(int y) {return &m_words[y*m_wordsPerRow];}
+
+    //! Returns the words of a row
+    const uint64_t* getRow(int y) const {return &m_words[y*m_wordsPerRow];}
+
+    //! Returns the mask of the bits of the last word of a row that are within the width
+    uint64_t getLastWordMask() const {return m_lastWordMask;}
+
+    //! Clears every pixel
+    void clear();
+
+    //! Sets the pixels whose first channel is at least the given value, clearing the others
+    void threshold(const ofPixels& pixels, int minValue);
+
+    //! Unpacks the mask into single channel pixels, 255 for the set pixels and 0 for the others
+    void unpack(ofPixels& pixels) const;
+
+    //! Returns the number of set pixels
+    int count() const;
+
+    //! Replaces the runs with the runs of set pixels, row by row from the top
+    void getRuns(vector<Run>& runs) const;
+
+private:
+
+    //! Returns the first pixel from x on that is set, or the width if there is none
+    int findSet(const uint64_t* row, int x) const;
+
+    //! Returns the first pixel from x on that is clear, or the width if there is none
+    int findClear(const uint64_t* row, int x) const;
+
+private:
+
+    int                 m_width;            ///< width in pixels
+    int                 m_height;           ///< height in pixels
+    int                 m_wordsPerRow;      ///< words of a row
+    uint64_t            m_lastWordMask;     ///< bits of the last word of a row within the width
+    vector<uint64_t>    m_words;            ///< rows of bits, one after the other
+};
+
+
+//========================== class BitMaskFilter ==============================
+//============================================================================
+/** \class BitMaskFilter BitMask.h
+ *	\brief Word-parallel morphology of a BitMask
+ *	\details An element is applied as a horizontal pass, then a vertical one. The
+ *    horizontal pass combines every row with shifted copies of itself, a whole word
+ *    of pixels per operation, doubling the span each time, so a run of 2*w + 1
+ *    pixels takes about log2(2*w + 1) shifts; it is done once for every half width
+ *    of the element. The vertical pass combines, for every row, the rows above and
+ *    below it passed with the half width of their row of the element. Like OpenCV,
+ *    the pixels out of the mask neither erode nor dilate it. The scratch masks stay
+ *    allocated from one frame to the next.
+ */
+
+class BitMaskFilter
+{
+
+public:
+
+    //! Constructor
+    BitMaskFilter();
+
+    //! Destructor
+    ~BitMaskFilter();
+
+    //! Clears the pixels the element doesn't fit in
+    void erode(BitMask& mask, const StructuringElement& element);
+
+    //! Sets the pixels the element touches
+    void dilate(BitMask& mask, const StructuringElement& element);
+
+    //! Erodes then dilates the mask, removing the specks smaller than the element
+    void open(BitMask& mask, const StructuringElement& element);
+
+    //! Dilates then erodes the mask, filling the gaps smaller than the element
+    void close(BitMask& mask, const StructuringElement& element);
+
+private:
+
+    //! Applies the element, ANDing the pixels it covers when eroding and ORing them when dilating
+    void apply(BitMask& mask, const StructuringElement& element, bool erode);
+
+    //! Combines every row of the mask with the pixels within the half width of each pixel, into the result
+    void passRows(const BitMask& mask, int halfWidth, bool erode, BitMask& result);
+
+    //! Combines the span with a copy of itself shifted by the given number of pixels
+    void combine(int shift, uint64_t fill, bool erode);
+
+    //! Shifts a row so that pixel x takes the value of pixel x + shift, filling with the given word past the ends
+    void shiftRow(const uint64_t* row, int shift, uint64_t fill, uint64_t* result) const;
+
+private:
+
+    int                 m_numWords;         ///< words of the span of a row
+    vector<BitMask>     m_passes;           ///< rows passed with every half width of the element
+    vector<char>        m_used;             ///< whether every half width is used by the element
+    vector<uint64_t>    m_span;             ///< row being combined with itself, from half a width before it
+    vector<uint64_t>    m_shifted;          ///< shifted copy of the row being combined
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,131 @@
+/*
+ *  ContourBudget.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourBudget.h"
+
+
+const int ContourBudget::SIMPLIFY_LEVELS = 4;
+const int ContourBudget::MAX_LEVEL = 7;
+const float ContourBudget::TOLERANCE_STEP = 0.5;
+const int ContourBudget::MIN_AGE = 5;
+const float ContourBudget::RECOVERY_RATIO = 0.7;
+const int ContourBudget::RECOVERY_FRAMES = 30;
+
+
+ContourBudget::ContourBudget(): m_maxContours(16), m_maxVertices(4096), m_level(0), m_numFramesUnder(0)
+{
+    //Intentionally left empty
+}
+
+
+ContourBudget::~ContourBudget()
+{
+    //Intentionally left empty
+}
+
+
+void ContourBudget::reset()
+{
+    m_level = 0;
+    m_numFramesUnder = 0;
+}
+
+void ContourBudget::rank(ContourSet& contours, const vector<int>& ages)
+{
+    // the contours come sorted by size, so a stable partition keeps the area order within each group
+    m_ranking.clear();
+    for(int i = 0; i < contours.size(); i++) {
+        if(ages[i] >= MIN_AGE){
+            m_ranking.push_back(i);
+        }
+    }
+    for(int i = 0; i < contours.size(); i++) {
+        if(ages[i] < MIN_AGE){
+            m_ranking.push_back(i);
+        }
+    }
+    
+    // every level past the simplification ones keeps a quarter fewer blobs
+    int maxContours = m_maxContours;
+    if(m_level > SIMPLIFY_LEVELS){
+        maxContours = max(1, m_maxContours*(4 - (m_level - SIMPLIFY_LEVELS))/4);
+    }
+    
+    if(m_ranking.size() > maxContours){
+        m_ranking.resize(maxContours);
+    }
+    
+    this->keepContours(contours, m_ranking);
+}
+
+float ContourBudget::getTolerance(float tolerance) const
+{
+    return tolerance + TOLERANCE_STEP*min(m_level, SIMPLIFY_LEVELS);
+}
+
+void ContourBudget::update(ContourSet& contours)
+{
+    int numVertices = contours.getNumVertices();
+    
+    if(numVertices > m_maxVertices){
+        m_level = min(m_level + 1, MAX_LEVEL);
+        m_numFramesUnder = 0;
+    }
+    else if(numVertices < RECOVERY_RATIO*m_maxVertices){
+        if(++m_numFramesUnder >= RECOVERY_FRAMES && m_level > 0){
+            m_level--;
+            m_numFramesUnder = 0;
+        }
+    }
+    else{
+        m_numFramesUnder = 0;
+    }
+    
+    if(numVertices <= m_maxVertices){
+        return;
+    }
+    
+    // the level only catches up from the next frame, so this one is cut to the budget right away
+    m_ranking.clear();
+    numVertices = 0;
+    for(int i = 0; i < contours.size(); i++)
+    {
+        numVertices += contours.getNumVertices(i);
+        if(numVertices > m_maxVertices){
+            break;
+        }
+        m_ranking.push_back(i);
+    }
+    
+    this->keepContours(contours, m_ranking);
+}
+
+void ContourBudget::keepContours(ContourSet& contours, const vector<int>& indices)
+{
+    if(indices.size() == contours.size()){
+        bool sorted = true;
+        for(int i = 0; i < indices.size() && sorted; i++) {
+            sorted = (indices[i] == i);
+        }
+        if(sorted){
+            return;
+        }
+    }
+    
+    m_ranked.clear();
+    m_ranked.setTimestamp(contours.getTimestamp());
+    for(int i = 0; i < indices.size(); i++)
+    {
+        int index = indices[i];
+        m_ranked.addContour(contours.getVertices(index), contours.getNumVertices(index), contours.getLabel(index),
+                            contours.getBoundingBox(index), contours.getArea(index));
+    }
+    
+    contours.copyFrom(m_ranked);
+}
+
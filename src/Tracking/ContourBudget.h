@@ -0,0 +1,84 @@
+/*
+ *  ContourBudget.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxCv.h"
+#include "ContourSet.h"
+
+
+//========================== class ContourBudget ==============================
+//============================================================================
+/** \class ContourBudget ContourBudget.h
+ *	\brief Keeps the contours of every frame within a vertex and contour budget
+ *	\details The contours are ranked by area, with the blobs the tracker has just
+ *    found behind the established ones. When the frames don't fit in the budget the
+ *    degradation level goes up: the first levels raise the simplification tolerance,
+ *    the next ones drop the lowest ranked blobs. The level goes back down once the
+ *    frames have been well within the budget for a while.
+ */
+
+class ContourBudget
+{
+
+public:
+
+    static const int SIMPLIFY_LEVELS;       ///< levels that only raise the simplification tolerance
+    static const int MAX_LEVEL;             ///< highest degradation level
+    static const float TOLERANCE_STEP;      ///< tolerance added by each simplification level, in pixels
+    static const int MIN_AGE;               ///< frames a blob has to be tracked to rank as established
+    static const float RECOVERY_RATIO;      ///< fraction of the budget a frame has to stay under to recover
+    static const int RECOVERY_FRAMES;       ///< frames under the recovery ratio needed to lower the level
+
+    //! Constructor
+    ContourBudget();
+
+    //! Destructor
+    ~ContourBudget();
+
+    //! Set the maximum number of contours of a frame
+    void setMaxContours(int maxContours) {m_maxContours = max(maxContours, 1);}
+
+    //! Set the maximum number of vertices of all the contours of a frame
+    void setMaxVertices(int maxVertices) {m_maxVertices = max(maxVertices, 0);}
+
+    //! Ranks the contours by their tracker ages and keeps the ones the current level allows, expects them sorted by size
+    void rank(ContourSet& contours, const vector<int>& ages);
+
+    //! Returns the simplification tolerance to use at the current level
+    float getTolerance(float tolerance) const;
+
+    //! Updates the level from the simplified contours and drops the lowest ranked ones still over the budget
+    void update(ContourSet& contours);
+
+    //! Returns the current degradation level, 0 when nothing is degraded
+    int getLevel() const {return m_level;}
+
+    //! Resets the level, used when the budget is switched on
+    void reset();
+
+private:
+
+    //! Keeps the given contours, in the given order
+    void keepContours(ContourSet& contours, const vector<int>& indices);
+
+private:
+
+    int             m_maxContours;      ///< maximum number of contours of a frame
+    int             m_maxVertices;      ///< maximum number of vertices of a frame
+    int             m_level;            ///< current degradation level
+    int             m_numFramesUnder;   ///< consecutive frames under the recovery ratio of the budget
+
+    vector<int>     m_ranking;          ///< indices of the contours, highest ranked first
+    ContourSet      m_ranked;           ///< contours kept, in ranking order
+};
+
+//==========================================================================
+
+
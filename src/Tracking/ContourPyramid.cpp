@@ -0,0 +1,148 @@
+/*
+ *  ContourPyramid.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourPyramid.h"
+
+
+const int ContourPyramid::MARGIN = 2;
+const float ContourPyramid::MIN_OVERLAP = 0.5;
+
+
+ContourPyramid::ContourPyramid(): m_scale(1), m_backgroundThreshold(10), m_threshold(80)
+{
+    //Intentionally left empty
+}
+
+
+ContourPyramid::~ContourPyramid()
+{
+    //Intentionally left empty
+}
+
+
+void ContourPyramid::decimate(const ofPixels& pixels, ofPixels& decimated, int scale)
+{
+    scale = max(scale, 1);
+    int width = pixels.getWidth()/scale;
+    int height = pixels.getHeight()/scale;
+    int numChannels = pixels.getNumChannels();
+    if(decimated.getWidth() != width || decimated.getHeight() != height || decimated.getNumChannels() != numChannels){
+        decimated.allocate(width, height, numChannels);
+    }
+
+    // both wrap the pixels, so the decimation is written straight into them
+    cv::Mat source(pixels.getHeight(), pixels.getWidth(), CV_8UC(numChannels), (void*) pixels.getPixels());
+    cv::Mat destination(height, width, CV_8UC(numChannels), decimated.getPixels());
+    cv::resize(source, destination, destination.size(), 0, 0, cv::INTER_AREA);
+}
+
+void ContourPyramid::upscale(const ofxCv::ContourFinder& contourFinder, ContourSet& contours)
+{
+    contours.clear();
+
+    const vector<vector<cv::Point> >& coarse = contourFinder.getContours();
+    for(int i = 0; i < coarse.size(); i++) {
+        this->addUpscaled(coarse[i], contourFinder.getLabel(i), contourFinder.getBoundingRect(i), contours);
+    }
+}
+
+void ContourPyramid::addUpscaled(const vector<cv::Point>& contour, unsigned int label, const cv::Rect& boundingBox, ContourSet& contours)
+{
+    // a coarse pixel stands for a block of scale x scale pixels, its vertex goes to the centre of the block
+    float offset = 0.5f*(m_scale - 1);
+    m_vertices.resize(contour.size());
+    for(int i = 0; i < contour.size(); i++) {
+        m_vertices[i].set(contour[i].x*m_scale + offset, contour[i].y*m_scale + offset);
+    }
+
+    ofRectangle box(boundingBox.x*m_scale, boundingBox.y*m_scale, boundingBox.width*m_scale, boundingBox.height*m_scale);
+    contours.addContour(m_vertices.empty() ? NULL : &m_vertices[0], m_vertices.size(), label, box, cv::contourArea(contour)*m_scale*m_scale);
+}
+
+void ContourPyramid::refine(const ofxCv::ContourFinder& contourFinder, const ofPixels& depth, const ofPixels& background, ContourSet& contours)
+{
+    contours.clear();
+
+    int width = depth.getWidth();
+    int height = depth.getHeight();
+    if(m_mask.cols != width || m_mask.rows != height){
+        m_mask.create(height, width, CV_8UC1);
+    }
+
+    cv::Rect frame(0, 0, width, height);
+    const vector<vector<cv::Point> >& coarse = contourFinder.getContours();
+    for(int i = 0; i < coarse.size(); i++)
+    {
+        cv::Rect box = contourFinder.getBoundingRect(i);
+        cv::Rect expected(box.x*m_scale, box.y*m_scale, box.width*m_scale, box.height*m_scale);
+        cv::Rect region = cv::Rect((box.x - MARGIN)*m_scale, (box.y - MARGIN)*m_scale, (box.width + 2*MARGIN)*m_scale, (box.height + 2*MARGIN)*m_scale) & frame;
+
+        // the contours of the region include the neighbours and the holes, the blob is the one in its place
+        this->threshold(depth, background, region);
+        cv::Mat mask = m_mask(region);
+        cv::findContours(mask, m_contours, CV_RETR_LIST, CV_CHAIN_APPROX_SIMPLE, region.tl());
+
+        int best = -1;
+        float bestOverlap = MIN_OVERLAP;
+        for(int j = 0; j < m_contours.size(); j++)
+        {
+            cv::Rect candidate = cv::boundingRect(m_contours[j]);
+            float intersection = (candidate & expected).area();
+            float overlap = intersection/(candidate.area() + expected.area() - intersection);
+            if(overlap > bestOverlap){
+                best = j;
+                bestOverlap = overlap;
+            }
+        }
+
+        if(best < 0){
+            this->addUpscaled(coarse[i], contourFinder.getLabel(i), box, contours);
+        }
+        else{
+            contours.addContour(m_contours[best], contourFinder.getLabel(i), cv::boundingRect(m_contours[best]));
+        }
+    }
+}
+
+void ContourPyramid::threshold(const ofPixels& depth, const ofPixels& background, const cv::Rect& region)
+{
+    int numChannels = depth.getNumChannels();
+    const unsigned char* pixels = depth.getPixels();
+
+    if(!background.isAllocated())
+    {
+        // the contour finder keeps what is within the threshold of white
+        int minValue = 255 - m_threshold;
+        for(int y = region.y; y < region.y + region.height; y++) {
+            const unsigned char* row = pixels + y*depth.getWidth()*numChannels;
+            unsigned char* mask = m_mask.ptr<unsigned char>(y);
+            for(int x = region.x; x < region.x + region.width; x++) {
+                mask[x] = row[x*numChannels] >= minValue ? 255 : 0;
+            }
+        }
+        return;
+    }
+
+    // the background is smooth, so the coarse pixel covering a pixel stands for it
+    int backgroundWidth = background.getWidth();
+    int backgroundHeight = background.getHeight();
+    int backgroundChannels = background.getNumChannels();
+    const unsigned char* backgroundPixels = background.getPixels();
+
+    for(int y = region.y; y < region.y + region.height; y++)
+    {
+        const unsigned char* row = pixels + y*depth.getWidth()*numChannels;
+        const unsigned char* backgroundRow = backgroundPixels + min(y/m_scale, backgroundHeight - 1)*backgroundWidth*backgroundChannels;
+        unsigned char* mask = m_mask.ptr<unsigned char>(y);
+        for(int x = region.x; x < region.x + region.width; x++) {
+            int difference = abs(int(row[x*numChannels]) - int(backgroundRow[min(x/m_scale, backgroundWidth - 1)*backgroundChannels]));
+            mask[x] = difference > m_backgroundThreshold ? 255 : 0;
+        }
+    }
+}
+
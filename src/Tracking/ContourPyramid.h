@@ -0,0 +1,81 @@
+/*
+ *  ContourPyramid.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxCv.h"
+#include "ContourSet.h"
+
+
+//========================== class ContourPyramid ==============================
+//============================================================================
+/** \class ContourPyramid ContourPyramid.h
+ *	\brief Brings the contours found on a decimated frame back to full resolution
+ *	\details The background subtraction and the contour finder can run on a frame
+ *    decimated by the scale, a few times smaller. The contours found there are either
+ *    upscaled, with the outline as blocky as the decimation, or refined: around every
+ *    blob, within its bounding box dilated by MARGIN coarse pixels, the full resolution
+ *    depth is thresholded against the decimated background, nearest neighbour, and
+ *    traced again. The traced contour whose bounding box overlaps the blob's the most
+ *    takes its place, keeping its tracker label; the upscaled one stays when none
+ *    overlaps by MIN_OVERLAP.
+ */
+
+class ContourPyramid
+{
+
+public:
+
+    static const int MARGIN;
+    static const float MIN_OVERLAP;
+
+    //! Constructor
+    ContourPyramid();
+
+    //! Destructor
+    ~ContourPyramid();
+
+    //! Set how many times smaller the decimated frame is on each side
+    void setScale(int scale) {m_scale = max(scale, 1);}
+
+    //! Set the thresholds of the background subtraction and of the contour finder, used when refining
+    void setThresholds(int backgroundThreshold, int threshold) {m_backgroundThreshold = backgroundThreshold; m_threshold = threshold;}
+
+    //! Decimates the pixels by the given scale, averaging every block. Takes the scale instead of
+    //! the one set, so the segment stage can decimate while the contour stage changes it
+    static void decimate(const ofPixels& pixels, ofPixels& decimated, int scale);
+
+    //! Replaces the contours with the ones of the contour finder, upscaled to full resolution
+    void upscale(const ofxCv::ContourFinder& contourFinder, ContourSet& contours);
+
+    //! Replaces the contours with the ones of the contour finder, traced again at the resolution of the depth.
+    //! Without a background the depth is thresholded like the contour finder does
+    void refine(const ofxCv::ContourFinder& contourFinder, const ofPixels& depth, const ofPixels& background, ContourSet& contours);
+
+private:
+
+    //! Adds a contour of the contour finder upscaled to full resolution
+    void addUpscaled(const vector<cv::Point>& contour, unsigned int label, const cv::Rect& boundingBox, ContourSet& contours);
+
+    //! Thresholds the depth within the region into the mask
+    void threshold(const ofPixels& depth, const ofPixels& background, const cv::Rect& region);
+
+private:
+
+    int                         m_scale;                ///< decimation of the frame the contour finder works on
+    int                         m_backgroundThreshold;  ///< threshold of the background subtraction
+    int                         m_threshold;            ///< threshold of the contour finder
+    cv::Mat                     m_mask;                 ///< full resolution mask, only the regions around the blobs are written
+    vector<vector<cv::Point> >  m_contours;             ///< contours traced in the region of a blob
+    vector<ofVec2f>             m_vertices;             ///< vertices of the contour being upscaled
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,319 @@
+/*
+ *  ContourSet.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourSet.h"
+
+
+ContourSet::ContourSet(): m_timestamp(0)
+{
+    m_offsets.push_back(0);
+}
+
+
+ContourSet::~ContourSet()
+{
+    //Intentionally left empty
+}
+
+
+void ContourSet::clear()
+{
+    m_vertices.clear();
+    m_offsets.resize(1);
+    m_labels.clear();
+    m_boundingBoxes.clear();
+    m_areas.clear();
+}
+
+void ContourSet::reserve(int numContours, int numVertices)
+{
+    m_vertices.reserve(numVertices);
+    m_offsets.reserve(numContours + 1);
+    m_labels.reserve(numContours);
+    m_boundingBoxes.reserve(numContours);
+    m_areas.reserve(numContours);
+}
+
+void ContourSet::copyFrom(const ContourSet& other)
+{
+    m_vertices.assign(other.m_vertices.begin(), other.m_vertices.end());
+    m_offsets.assign(other.m_offsets.begin(), other.m_offsets.end());
+    m_labels.assign(other.m_labels.begin(), other.m_labels.end());
+    m_boundingBoxes.assign(other.m_boundingBoxes.begin(), other.m_boundingBoxes.end());
+    m_areas.assign(other.m_areas.begin(), other.m_areas.end());
+    m_timestamp = other.m_timestamp;
+}
+
+void ContourSet::setFromContourFinder(const ofxCv::ContourFinder& contourFinder)
+{
+    this->clear();
+
+    const vector<vector<cv::Point> >& contours = contourFinder.getContours();
+    for(int i = 0; i < contours.size(); i++) {
+        this->addContour(contours[i], contourFinder.getLabel(i), contourFinder.getBoundingRect(i));
+    }
+}
+
+void ContourSet::addContour(const vector<cv::Point>& contour, unsigned int label, const cv::Rect& boundingBox)
+{
+    for(int i = 0; i < contour.size(); i++) {
+        m_vertices.push_back(ofVec2f(contour[i].x, contour[i].y));
+    }
+
+    m_offsets.push_back(m_vertices.size());
+    m_labels.push_back(label);
+    m_boundingBoxes.push_back(ofRectangle(boundingBox.x, boundingBox.y, boundingBox.width, boundingBox.height));
+    m_areas.push_back(cv::contourArea(contour));
+}
+
+void ContourSet::addContour(const ofVec2f* vertices, int numVertices, unsigned int label, const ofRectangle& boundingBox, float area)
+{
+    m_vertices.insert(m_vertices.end(), vertices, vertices + numVertices);
+    m_offsets.push_back(m_vertices.size());
+    m_labels.push_back(label);
+    m_boundingBoxes.push_back(boundingBox);
+    m_areas.push_back(area);
+}
+
+void ContourSet::keepLargest()
+{
+    if(this->empty()){
+        this->addContour(NULL, 0, 0, ofRectangle(), 0);
+        return;
+    }
+
+    if(this->size() == 1){
+        return;
+    }
+
+    int largest = 0;
+    for(int i = 1; i < this->size(); i++) {
+        if(m_areas[i] > m_areas[largest]){
+            largest = i;
+        }
+    }
+
+    int begin = m_offsets[largest];
+    int end = m_offsets[largest+1];
+    m_vertices.erase(m_vertices.begin() + end, m_vertices.end());
+    m_vertices.erase(m_vertices.begin(), m_vertices.begin() + begin);
+
+    m_offsets.resize(2);
+    m_offsets[1] = m_vertices.size();
+    m_labels[0] = m_labels[largest];
+    m_labels.resize(1);
+    m_boundingBoxes[0] = m_boundingBoxes[largest];
+    m_boundingBoxes.resize(1);
+    m_areas[0] = m_areas[largest];
+    m_areas.resize(1);
+}
+
+void ContourSet::keepLargest(int numContours)
+{
+    numContours = max(numContours, 0);
+    while(this->size() > numContours)
+    {
+        // the last of the smallest goes first, so of contours as large the first ones stay
+        int smallest = 0;
+        for(int i = 1; i < this->size(); i++) {
+            if(m_areas[i] <= m_areas[smallest]){
+                smallest = i;
+            }
+        }
+
+        int begin = m_offsets[smallest];
+        int end = m_offsets[smallest+1];
+        m_vertices.erase(m_vertices.begin() + begin, m_vertices.begin() + end);
+        for(int i = smallest + 1; i < m_offsets.size(); i++) {
+            m_offsets[i-1] = m_offsets[i] - (end - begin);
+        }
+        m_offsets.pop_back();
+        m_labels.erase(m_labels.begin() + smallest);
+        m_boundingBoxes.erase(m_boundingBoxes.begin() + smallest);
+        m_areas.erase(m_areas.begin() + smallest);
+    }
+}
+
+void ContourSet::smooth(int smoothingSize, float smoothingShape)
+{
+    if(smoothingSize <= 1){
+        return;
+    }
+
+    m_smoother.size = smoothingSize;
+    m_smoother.shape = ofClamp(smoothingShape, 0, 1);
+    this->process(m_smoother);
+}
+
+void ContourSet::simplify(float tolerance)
+{
+    m_simplifier.tolerance = tolerance;
+    this->process(m_simplifier);
+}
+
+void ContourSet::draw() const
+{
+    ofPushStyle();
+    ofNoFill();
+    for(int i = 0; i < this->size(); i++)
+    {
+        const ofVec2f* vertices = this->getVertices(i);
+        ofBeginShape();
+        for(int j = 0; j < this->getNumVertices(i); j++) {
+            ofVertex(vertices[j].x, vertices[j].y);
+        }
+        ofEndShape(true);
+    }
+    ofPopStyle();
+}
+
+float ContourSet::getPerimeter(int i) const
+{
+    int n = this->getNumVertices(i);
+    const ofVec2f* vertices = this->getVertices(i);
+
+    float perimeter = 0;
+    for(int j = 0; j < n; j++) {
+        perimeter += vertices[j].distance(vertices[(j + 1) % n]);
+    }
+
+    return perimeter;
+}
+
+size_t ContourSet::getMemorySize() const
+{
+    return m_vertices.size()*sizeof(ofVec2f) + m_offsets.size()*sizeof(int) + m_labels.size()*sizeof(unsigned int)
+        + m_boundingBoxes.size()*sizeof(ofRectangle) + m_areas.size()*sizeof(float);
+}
+
+
+//--------------------------------------------------------------
+
+bool ContourMarks::raise(const ContourSet& contours)
+{
+    int contourVertices = 0;
+    for(int i = 0; i < contours.size(); i++) {
+        contourVertices = max(contourVertices, contours.getNumVertices(i));
+    }
+
+    bool larger = (contours.size() > numContours || contours.getNumVertices() > numVertices || contourVertices > numContourVertices);
+    numContours = max(numContours, contours.size());
+    numVertices = max(numVertices, contours.getNumVertices());
+    numContourVertices = max(numContourVertices, contourVertices);
+
+    return larger;
+}
+
+
+//--------------------------------------------------------------
+
+void ContourSet::Smoother::operator()(int i, vector<ofVec2f>& vertices)
+{
+    int n = vertices.size();
+    int smoothingSize = min(size, n);
+
+    weights.resize(smoothingSize);
+    for(int j = 1; j < smoothingSize; j++) {
+        weights[j] = ofMap(j, 0, smoothingSize, 1, shape);
+    }
+
+    source = vertices;
+    for(int j = 0; j < n; j++)
+    {
+        float sum = 1; // center weight
+        for(int k = 1; k < smoothingSize; k++)
+        {
+            // the contour is closed, so the window wraps around
+            ofVec2f current = source[(j - k + n) % n] + source[(j + k) % n];
+            sum += 2*weights[k];
+            vertices[j] += current * weights[k];
+        }
+        vertices[j] /= sum;
+    }
+}
+
+void ContourSet::Simplifier::operator()(int i, vector<ofVec2f>& vertices)
+{
+    int n = vertices.size();
+    if(n < 2){
+        return;
+    }
+
+    float tolerance2 = tolerance*tolerance;
+
+    // vertex reduction within the tolerance of the previous kept vertex
+    reduced.resize(n);
+    reduced[0] = vertices[0];
+    int k = 1, previous = 0;
+    for(int j = 1; j < n; j++) {
+        if(vertices[j].squareDistance(vertices[previous]) < tolerance2){
+            continue;
+        }
+        reduced[k++] = vertices[j];
+        previous = j;
+    }
+    if(previous < n - 1){
+        reduced[k++] = vertices[n-1];
+    }
+
+    // Douglas-Peucker on the reduced vertices, with an explicit stack of segments
+    marked.assign(k, 0);
+    marked[0] = marked[k-1] = 1;
+    stack.clear();
+    stack.push_back(0);
+    stack.push_back(k-1);
+    while(!stack.empty())
+    {
+        int last = stack.back(); stack.pop_back();
+        int first = stack.back(); stack.pop_back();
+        if(last <= first + 1){
+            continue;
+        }
+
+        ofVec2f u = reduced[last] - reduced[first];
+        float cu = u.dot(u);
+        int maxIndex = first;
+        float maxDistance2 = 0;
+        for(int j = first + 1; j < last; j++)
+        {
+            ofVec2f w = reduced[j] - reduced[first];
+            float cw = w.dot(u);
+            float distance2;
+            if(cw <= 0){
+                distance2 = reduced[j].squareDistance(reduced[first]);
+            }
+            else if(cu <= cw){
+                distance2 = reduced[j].squareDistance(reduced[last]);
+            }
+            else{
+                distance2 = reduced[j].squareDistance(reduced[first] + u*(cw/cu));
+            }
+
+            if(distance2 > maxDistance2){
+                maxIndex = j;
+                maxDistance2 = distance2;
+            }
+        }
+
+        if(maxDistance2 > tolerance2){
+            marked[maxIndex] = 1;
+            stack.push_back(first);
+            stack.push_back(maxIndex);
+            stack.push_back(maxIndex);
+            stack.push_back(last);
+        }
+    }
+
+    vertices.clear();
+    for(int j = 0; j < k; j++) {
+        if(marked[j]){
+            vertices.push_back(reduced[j]);
+        }
+    }
+}
+
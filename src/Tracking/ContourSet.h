@@ -0,0 +1,200 @@
+/*
+ *  ContourSet.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxCv.h"
+
+
+//========================== class ContourSet ==============================
+//============================================================================
+/** \class ContourSet ContourSet.h
+ *	\brief Flat storage of all the contours of a frame
+ *	\details The vertices of every contour live in a single contiguous array, indexed
+ *    by per-contour offsets, next to the tracker labels, bounding boxes and areas.
+ *    Post-processing transforms the set in place and the buffers keep their capacity
+ *    from frame to frame.
+ */
+
+class ContourSet
+{
+
+public:
+
+    //! Constructor
+    ContourSet();
+
+    //! Destructor
+    ~ContourSet();
+
+    //! Removes all the contours, keeping the allocated memory
+    void clear();
+
+    //! Reserves memory for the given number of contours and vertices
+    void reserve(int numContours, int numVertices);
+
+    //! Copies the contours and the timestamp of another set, reusing the allocated memory
+    void copyFrom(const ContourSet& other);
+
+    //! Copies the contours, labels and bounding boxes found by the contour finder
+    void setFromContourFinder(const ofxCv::ContourFinder& contourFinder);
+
+    //! Adds a contour at the end of the set
+    void addContour(const vector<cv::Point>& contour, unsigned int label, const cv::Rect& boundingBox);
+
+    //! Adds a contour at the end of the set
+    void addContour(const ofVec2f* vertices, int numVertices, unsigned int label, const ofRectangle& boundingBox, float area);
+
+    //! Keeps only the contour with the largest area. An empty set gets an empty contour, so a frame without anybody is
+    //! still sent as one contour without vertices, the way the renderers have always received it
+    void keepLargest();
+
+    //! Keeps the given number of contours with the largest areas, in their order, removing the smallest ones in place
+    void keepLargest(int numContours);
+
+    //! Smooths every contour in place, like ofPolyline::getSmoothed on a closed polyline
+    void smooth(int smoothingSize, float smoothingShape);
+
+    //! Simplifies every contour in place, like ofPolyline::simplify
+    void simplify(float tolerance);
+
+    //! Replaces the vertices of every contour, in order, with the ones produced by the processor
+    template <class Processor>
+    void process(Processor& processor);
+
+    //! Draws all the contours as closed outlines
+    void draw() const;
+
+    //! Returns the number of contours
+    int size() const {return m_labels.size();}
+
+    //! Returns whether there are no contours
+    bool empty() const {return m_labels.empty();}
+
+    //! Returns the number of vertices of all the contours
+    int getNumVertices() const {return m_vertices.size();}
+
+    //! Returns the number of vertices of the given contour
+    int getNumVertices(int i) const {return m_offsets[i+1] - m_offsets[i];}
+
+    //! Returns the vertices of the given contour
+    const ofVec2f* getVertices(int i) const {return m_vertices.empty() ? NULL : &m_vertices[m_offsets[i]];}
+
+    //! Returns the vertices of the given contour
+    ofVec2f* getVertices(int i) {return m_vertices.empty() ? NULL : &m_vertices[m_offsets[i]];}
+
+    //! Returns the tracker label of the given contour
+    unsigned int getLabel(int i) const {return m_labels[i];}
+
+    //! Returns the bounding box of the given contour in sensor pixels
+    const ofRectangle& getBoundingBox(int i) const {return m_boundingBoxes[i];}
+
+    //! Returns the area of the given contour in sensor pixels
+    float getArea(int i) const {return m_areas[i];}
+
+    //! Returns the perimeter of the given contour
+    float getPerimeter(int i) const;
+
+    //! Returns the number of bytes used by the set
+    size_t getMemorySize() const;
+
+    //! Sets the time the frame was captured, in microseconds since the epoch
+    void setTimestamp(unsigned long long timestamp) {m_timestamp = timestamp;}
+
+    //! Returns the time the frame was captured, in microseconds since the epoch
+    unsigned long long getTimestamp() const {return m_timestamp;}
+
+private:
+
+    //! Smooths one closed contour
+    struct Smoother
+    {
+        int             size;
+        float           shape;
+        vector<float>   weights;
+        vector<ofVec2f> source;
+
+        void operator()(int i, vector<ofVec2f>& vertices);
+    };
+
+    //! Simplifies one contour with vertex reduction followed by Douglas-Peucker
+    struct Simplifier
+    {
+        float           tolerance;
+        vector<ofVec2f> reduced;
+        vector<char>    marked;
+        vector<int>     stack;
+
+        void operator()(int i, vector<ofVec2f>& vertices);
+    };
+
+private:
+
+    vector<ofVec2f>         m_vertices;         ///< vertices of all the contours, one after the other
+    vector<int>             m_offsets;          ///< index of the first vertex of every contour, plus the total at the end
+    vector<unsigned int>    m_labels;           ///< tracker label of every contour
+    vector<ofRectangle>     m_boundingBoxes;    ///< bounding box of every contour
+    vector<float>           m_areas;            ///< area of every contour
+    vector<ofVec2f>         m_scratch;          ///< vertices of the contour being processed
+    unsigned long long      m_timestamp;        ///< capture time of the frame, in microseconds since the epoch
+
+    Smoother                m_smoother;         ///< reusable smoothing state
+    Simplifier              m_simplifier;       ///< reusable simplification state
+};
+
+
+template <class Processor>
+void ContourSet::process(Processor& processor)
+{
+    // contours never grow, so they can be written back in place behind the read position
+    int writePosition = 0;
+    for(int i = 0; i < this->size(); i++)
+    {
+        int begin = m_offsets[i];
+        int end = m_offsets[i+1];
+        m_scratch.assign(m_vertices.begin() + begin, m_vertices.begin() + end);
+
+        processor(i, m_scratch);
+
+        int n = min(m_scratch.size(), size_t(end - begin));
+        std::copy(m_scratch.begin(), m_scratch.begin() + n, m_vertices.begin() + writePosition);
+        m_offsets[i] = writePosition;
+        writePosition += n;
+    }
+
+    m_offsets[this->size()] = writePosition;
+    m_vertices.resize(writePosition);
+}
+
+
+//========================== struct ContourMarks ==============================
+//============================================================================
+/** \struct ContourMarks ContourSet.h
+ *	\brief The largest contours a buffer has held
+ *	\details A buffer keeping its capacity only allocates for contours larger than
+ *    any it held before. Every queue slot grows on its own, so each keeps its own
+ *    marks, and so does every thread for its scratch buffers.
+ */
+
+struct ContourMarks
+{
+    //! Constructor
+    ContourMarks(): numContours(0), numVertices(0), numContourVertices(0) {}
+
+    //! Raises the marks to the given contours, returns whether any was passed
+    bool raise(const ContourSet& contours);
+
+    int     numContours;            ///< most contours of a frame
+    int     numVertices;            ///< most vertices of a frame
+    int     numContourVertices;     ///< most vertices of a single contour
+};
+
+//==========================================================================
+
+
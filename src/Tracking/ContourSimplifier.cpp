@@ -0,0 +1,126 @@
+/*
+ *  ContourSimplifier.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "ContourSimplifier.h"
+
+
+const int ContourSimplifier::MIN_VERTICES = 3;
+
+
+ContourSimplifier::ContourSimplifier(): m_maxVerticesPerContour(256), m_maxVerticesPerFrame(2048)
+{
+    //Intentionally left empty
+}
+
+
+ContourSimplifier::~ContourSimplifier()
+{
+    //Intentionally left empty
+}
+
+
+void ContourSimplifier::simplify(ContourSet& contours)
+{
+    if(contours.empty()){
+        return;
+    }
+
+    float totalPerimeter = 0;
+    m_budgets.resize(contours.size());
+    for(int i = 0; i < contours.size(); i++) {
+        totalPerimeter += contours.getPerimeter(i);
+    }
+
+    // every contour keeps its minimum, the rest is shared out, so the budgets never add up to more than the frame's
+    int shared = max(m_maxVerticesPerFrame - int(contours.size())*MIN_VERTICES, 0);
+    for(int i = 0; i < contours.size(); i++) {
+
+        int budget = MIN_VERTICES + shared;
+        if(totalPerimeter > 0){
+            budget = MIN_VERTICES + int(shared * contours.getPerimeter(i) / totalPerimeter);
+        }
+
+        m_budgets[i] = max(min(budget, m_maxVerticesPerContour), MIN_VERTICES);
+    }
+
+    contours.process(*this);
+}
+
+void ContourSimplifier::operator()(int index, vector<ofVec2f>& contour)
+{
+    int n = contour.size();
+    int maxVertices = m_budgets[index];
+
+    if(n <= maxVertices){
+        return;
+    }
+
+    m_vertices.swap(contour);
+    const vector<ofVec2f>& vertices = m_vertices;
+
+    m_prev.resize(n);
+    m_next.resize(n);
+    m_areas.resize(n);
+    m_heap.clear();
+
+    for(int i = 0; i < n; i++) {
+        m_prev[i] = (i + n - 1) % n;
+        m_next[i] = (i + 1) % n;
+        m_areas[i] = this->getTriangleArea(vertices[m_prev[i]], vertices[i], vertices[m_next[i]]);
+        m_heap.push_back(HeapEntry(m_areas[i], i));
+    }
+
+    // min-heap on the effective area; entries whose area changed are stale and skipped when popped
+    std::greater<HeapEntry> compare;
+    std::make_heap(m_heap.begin(), m_heap.end(), compare);
+
+    int remaining = n;
+    float lastArea = 0;
+    while(remaining > maxVertices && !m_heap.empty())
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end(), compare);
+        HeapEntry entry = m_heap.back();
+        m_heap.pop_back();
+
+        int i = entry.second;
+        if(m_areas[i] < 0 || entry.first != m_areas[i]){
+            continue;
+        }
+
+        // never let a neighbour be cheaper than what was already removed, so the order stays monotonic
+        lastArea = max(lastArea, entry.first);
+        m_areas[i] = -1;
+        remaining--;
+
+        int prev = m_prev[i];
+        int next = m_next[i];
+        m_next[prev] = next;
+        m_prev[next] = prev;
+
+        m_areas[prev] = max(lastArea, this->getTriangleArea(vertices[m_prev[prev]], vertices[prev], vertices[next]));
+        m_heap.push_back(HeapEntry(m_areas[prev], prev));
+        std::push_heap(m_heap.begin(), m_heap.end(), compare);
+
+        m_areas[next] = max(lastArea, this->getTriangleArea(vertices[prev], vertices[next], vertices[m_next[next]]));
+        m_heap.push_back(HeapEntry(m_areas[next], next));
+        std::push_heap(m_heap.begin(), m_heap.end(), compare);
+    }
+
+    contour.clear();
+    for(int i = 0; i < n; i++) {
+        if(m_areas[i] >= 0){
+            contour.push_back(vertices[i]);
+        }
+    }
+}
+
+float ContourSimplifier::getTriangleArea(const ofVec2f& prev, const ofVec2f& current, const ofVec2f& next) const
+{
+    return 0.5*fabs((current.x - prev.x)*(next.y - prev.y) - (next.x - prev.x)*(current.y - prev.y));
+}
+
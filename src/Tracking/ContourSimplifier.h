@@ -0,0 +1,73 @@
+/*
+ *  ContourSimplifier.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ContourSet.h"
+
+
+//========================== class ContourSimplifier ==============================
+//============================================================================
+/** \class ContourSimplifier ContourSimplifier.h
+ *	\brief Simplifies contours to a fixed vertex budget
+ *	\details It uses the Visvalingam-Whyatt algorithm, removing the vertex with the
+ *    smallest effective triangle area until the budget is met. Every contour keeps
+ *    MIN_VERTICES, the rest of the frame budget is shared between the contours in
+ *    proportion to their perimeter. A frame budget below MIN_VERTICES a contour can't
+ *    be met, the contours past it have to be dropped before.
+ */
+
+class ContourSimplifier
+{
+
+public:
+
+    static const int MIN_VERTICES;
+
+    //! Constructor
+    ContourSimplifier();
+
+    //! Destructor
+    ~ContourSimplifier();
+
+    //! Set the maximum number of vertices of a single contour
+    void setMaxVerticesPerContour(int maxVertices) {m_maxVerticesPerContour = maxVertices;}
+
+    //! Set the maximum number of vertices of all the contours of a frame
+    void setMaxVerticesPerFrame(int maxVertices) {m_maxVerticesPerFrame = maxVertices;}
+
+    //! Simplify all the contours of a frame in place so that they fit in the vertex budget
+    void simplify(ContourSet& contours);
+
+    //! Simplify a closed contour down to its budget in O(n log n), called by ContourSet::process
+    void operator()(int index, vector<ofVec2f>& vertices);
+
+private:
+
+    //! Area of the triangle formed by the vertex and its two neighbours
+    float getTriangleArea(const ofVec2f& prev, const ofVec2f& current, const ofVec2f& next) const;
+
+private:
+
+    typedef pair<float, int>    HeapEntry;      ///< effective area attached to the vertex index
+
+    int             m_maxVerticesPerContour;    ///< maximum number of vertices of a single contour
+    int             m_maxVerticesPerFrame;      ///< maximum number of vertices of all the contours of a frame
+
+    vector<int>         m_prev;                 ///< index of the previous vertex still alive
+    vector<int>         m_next;                 ///< index of the next vertex still alive
+    vector<float>       m_areas;                ///< current effective area of every vertex
+    vector<HeapEntry>   m_heap;                 ///< min-heap of vertices to remove
+    vector<int>         m_budgets;              ///< vertex budget of every contour of the current frame
+    vector<ofVec2f>     m_vertices;             ///< vertices before the simplification
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,383 @@
+/*
+ *  DepthPlayer.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DepthPlayer.h"
+
+
+DepthDecoderThread::DepthDecoderThread(): m_player(NULL)
+{
+    //Intentionally left empty
+}
+
+
+DepthDecoderThread::~DepthDecoderThread()
+{
+    this->stop();
+}
+
+
+void DepthDecoderThread::start(DepthPlayer* player)
+{
+    m_player = player;
+    startThread();
+}
+
+void DepthDecoderThread::stop()
+{
+    if(isThreadRunning()){
+        stopThread();
+        m_player->notifyDecode();
+        waitForThread(false);
+    }
+}
+
+void DepthDecoderThread::threadedFunction()
+{
+    while(isThreadRunning())
+    {
+        if(!m_player->decodeNext()){
+            m_player->waitForDecode();
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+
+const int DepthPlayer::NUM_SLOTS = 8;
+const int DepthPlayer::NUM_DECODERS = 3;
+
+
+DepthPlayer::DepthPlayer(): m_data(NULL), m_size(0), m_width(0), m_height(0), m_playFrame(0), m_nextDecode(0),
+    m_numBusy(0), m_seeking(false), m_currentFrame(-1), m_frameNew(false), m_startTime(0)
+{
+    //Intentionally left empty
+}
+
+
+DepthPlayer::~DepthPlayer()
+{
+    this->close();
+}
+
+
+bool DepthPlayer::open(const string& path)
+{
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        ofLogError() <<"DepthPlayer::open -> unable to open " << path;
+        return false;
+    }
+
+    struct stat status;
+    void* memory = MAP_FAILED;
+    if(fstat(fd, &status) == 0 && status.st_size >= sizeof(DepthRecording::FileHeader)){
+        memory = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+
+    if(memory == MAP_FAILED){
+        ofLogError() <<"DepthPlayer::open -> unable to map " << path;
+        return false;
+    }
+
+    DepthRecording::FileHeader header;
+    memcpy(&header, memory, sizeof(header));
+    if(header.magic != DepthRecording::MAGIC || header.version != DepthRecording::VERSION){
+        ofLogError() <<"DepthPlayer::open -> " << path << " is not a depth recording";
+        munmap(memory, status.st_size);
+        return false;
+    }
+
+    m_data = (const unsigned char*) memory;
+    m_size = status.st_size;
+    m_width = header.width;
+    m_height = header.height;
+    madvise(memory, m_size, MADV_SEQUENTIAL);
+
+    this->readIndex();
+    if(m_index.empty()){
+        ofLogError() <<"DepthPlayer::open -> " << path << " has no frames";
+        this->close();
+        return false;
+    }
+
+    // the slots hold atomics, which can't be moved, so the vector is built at its size
+    vector<Slot>(NUM_SLOTS).swap(m_slots);
+    for(int i = 0; i < m_slots.size(); i++) {
+        m_slots[i].frame.store(-1, std::memory_order_relaxed);
+        m_slots[i].busy.store(false, std::memory_order_relaxed);
+        m_slots[i].depth.resize(m_width*m_height);
+        m_slots[i].pixels.allocate(m_width, m_height, 1);
+    }
+
+    this->seek(0);
+
+    m_decoders.resize(NUM_DECODERS);
+    for(int i = 0; i < m_decoders.size(); i++) {
+        m_decoders[i] = ofPtr<DepthDecoderThread>(new DepthDecoderThread());
+        m_decoders[i]->start(this);
+    }
+
+    ofLogNotice() <<"DepthPlayer::open -> playing " << m_index.size() << " frames of " << m_width << "x" << m_height << " depth from " << path;
+    return true;
+}
+
+void DepthPlayer::close()
+{
+    if(!m_data){
+        return;
+    }
+
+    for(int i = 0; i < m_decoders.size(); i++) {
+        m_decoders[i]->stop();
+    }
+    m_decoders.clear();
+
+    munmap((void*) m_data, m_size);
+    m_data = NULL;
+    m_size = 0;
+    m_index.clear();
+    m_currentFrame = -1;
+    m_frameNew = false;
+
+    ofLogNotice() <<"DepthPlayer::close";
+}
+
+void DepthPlayer::readIndex()
+{
+    m_index.clear();
+
+    const size_t headerSize = sizeof(DepthRecording::FileHeader);
+    const size_t chunkSize = sizeof(DepthRecording::ChunkHeader);
+    const size_t trailerSize = sizeof(DepthRecording::Trailer);
+    const size_t entrySize = sizeof(DepthRecording::IndexEntry);
+
+    if(m_size >= headerSize + chunkSize + trailerSize)
+    {
+        DepthRecording::Trailer trailer;
+        memcpy(&trailer, m_data + m_size - trailerSize, trailerSize);
+
+        DepthRecording::ChunkHeader chunk;
+        bool valid = (trailer.magic == DepthRecording::TRAILER_MAGIC && trailer.indexOffset >= headerSize &&
+                      trailer.indexOffset + chunkSize + trailer.numFrames*entrySize + trailerSize == m_size);
+        if(valid){
+            memcpy(&chunk, m_data + trailer.indexOffset, chunkSize);
+            valid = (chunk.type == DepthRecording::CHUNK_INDEX && chunk.size == trailer.numFrames*entrySize);
+        }
+
+        if(valid){
+            m_index.resize(trailer.numFrames);
+            if(!m_index.empty()){
+                memcpy(&m_index[0], m_data + trailer.indexOffset + chunkSize, chunk.size);
+            }
+            return;
+        }
+    }
+
+    this->rebuildIndex();
+}
+
+void DepthPlayer::rebuildIndex()
+{
+    // the recording wasn't closed, so the frames are read up to the first incomplete one
+    size_t offset = sizeof(DepthRecording::FileHeader);
+    while(offset + sizeof(DepthRecording::FrameHeader) <= m_size)
+    {
+        DepthRecording::FrameHeader header;
+        memcpy(&header, m_data + offset, sizeof(header));
+
+        size_t end = offset + sizeof(header.chunk) + header.chunk.size;
+        if(header.chunk.type != DepthRecording::CHUNK_FRAME || end > m_size){
+            break;
+        }
+
+        DepthRecording::IndexEntry entry;
+        entry.offset = offset;
+        entry.timestamp = header.timestamp;
+        m_index.push_back(entry);
+
+        offset = end;
+    }
+
+    ofLogWarning() <<"DepthPlayer::rebuildIndex -> the recording has no index, found " << m_index.size() << " frames";
+}
+
+void DepthPlayer::update()
+{
+    m_frameNew = false;
+    if(!m_data){
+        return;
+    }
+
+    unsigned long long elapsed = ofGetElapsedTimeMicros() - m_startTime;
+    int numFrames = m_index.size();
+
+    // loop once the last frame has been shown for as long as the one before it
+    if(m_currentFrame == numFrames - 1)
+    {
+        unsigned long long duration = getTime(numFrames - 1) + (numFrames > 1 ? getTime(numFrames - 1) - getTime(numFrames - 2) : 0);
+        if(elapsed >= duration){
+            this->seek(0);
+            elapsed = 0;
+        }
+    }
+
+    int frame = m_playFrame.load(std::memory_order_relaxed);
+    while(frame + 1 < numFrames && getTime(frame + 1) <= elapsed){
+        frame++;
+    }
+
+    // moving on frees the slots of the skipped frames for the decoders
+    m_playFrame.store(frame, std::memory_order_relaxed);
+    if(frame != m_currentFrame){
+        m_decodeSignal.notify();
+        this->takeFrame(frame);
+    }
+}
+
+bool DepthPlayer::nextFrame()
+{
+    m_frameNew = false;
+    if(!m_data || m_currentFrame + 1 >= m_index.size()){
+        return false;
+    }
+
+    int frame = m_currentFrame + 1;
+    m_playFrame.store(frame, std::memory_order_relaxed);
+    m_decodeSignal.notify();
+    while(!this->takeFrame(frame)){
+        m_decodedSignal.wait();
+    }
+
+    return true;
+}
+
+void DepthPlayer::seek(int frame)
+{
+    if(!m_data){
+        return;
+    }
+
+    frame = ofClamp(frame, 0, m_index.size() - 1);
+
+    // wait for the decoders to put down the frames they are working on
+    // the flag and the count are sequentially consistent, so either a decoder sees the flag or seek sees it busy
+    m_seeking.store(true);
+    while(m_numBusy.load() > 0){
+        ofSleepMillis(1);
+    }
+
+    for(int i = 0; i < m_slots.size(); i++) {
+        m_slots[i].frame.store(-1, std::memory_order_relaxed);
+    }
+
+    m_playFrame.store(frame, std::memory_order_relaxed);
+    m_nextDecode.store(frame, std::memory_order_relaxed);
+    m_currentFrame = frame - 1;
+    m_startTime = ofGetElapsedTimeMicros() - getTime(frame);
+    m_seeking.store(false, std::memory_order_release);
+    m_decodeSignal.notify();
+}
+
+bool DepthPlayer::takeFrame(int frame)
+{
+    // pairs with the release of the decoder, so the pixels of the slot are complete
+    if(m_slots[frame % NUM_SLOTS].frame.load(std::memory_order_acquire) != frame){
+        return false;
+    }
+
+    m_currentFrame = frame;
+    m_frameNew = true;
+    return true;
+}
+
+bool DepthPlayer::decodeNext()
+{
+    if(m_seeking.load(std::memory_order_acquire)){
+        return false;
+    }
+
+    m_numBusy.fetch_add(1);
+
+    // claim the next frame within NUM_SLOTS of the one being played, skipping the ones already passed
+    int frame = -1;
+    while(!m_seeking.load())
+    {
+        int next = m_nextDecode.load(std::memory_order_relaxed);
+        int play = m_playFrame.load(std::memory_order_relaxed);
+        int candidate = max(next, play);
+        if(candidate >= play + NUM_SLOTS || candidate >= m_index.size()){
+            break;
+        }
+        if(m_nextDecode.compare_exchange_weak(next, candidate + 1, std::memory_order_relaxed)){
+            frame = candidate;
+            break;
+        }
+    }
+
+    if(frame < 0){
+        m_numBusy.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    // a signal wakes a single decoder, which passes it on to the next one
+    m_decodeSignal.notify();
+
+    // a decoder that claimed a frame before playback moved on may still be writing the slot
+    Slot& slot = m_slots[frame % NUM_SLOTS];
+    while(slot.busy.exchange(true, std::memory_order_acquire)){
+        ofSleepMillis(0);
+    }
+
+    // the slot is marked empty while it is overwritten, and published once it is complete
+    if(slot.frame.load(std::memory_order_relaxed) < frame && frame >= m_playFrame.load(std::memory_order_relaxed)){
+        slot.frame.store(-1, std::memory_order_relaxed);
+        this->decodeFrame(frame, slot);
+        slot.frame.store(frame, std::memory_order_release);
+        m_decodedSignal.notify();
+    }
+
+    slot.busy.store(false, std::memory_order_release);
+    m_numBusy.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void DepthPlayer::decodeFrame(int frame, Slot& slot)
+{
+    size_t offset = m_index[frame].offset;
+
+    // the index read from the file may point anywhere, the header is only read if it is within the mapping
+    bool valid = (offset <= m_size && sizeof(DepthRecording::FrameHeader) <= m_size - offset);
+
+    DepthRecording::FrameHeader header;
+    if(valid){
+        memcpy(&header, m_data + offset, sizeof(header));
+        const unsigned char* data = m_data + offset + sizeof(header);
+        valid = (header.chunk.type == DepthRecording::CHUNK_FRAME && header.encodedSize <= m_size - offset - sizeof(header) &&
+                 DepthRecording::decode(data, header.encodedSize, m_width, m_height, &slot.depth[0]));
+    }
+
+    if(!valid){
+        ofLogWarning() <<"DepthPlayer::decodeFrame -> frame " << frame << " is corrupt";
+        std::fill(slot.depth.begin(), slot.depth.end(), 0);
+    }
+
+    float* pixels = slot.pixels.getPixels();
+    for(int i = 0; i < slot.depth.size(); i++) {
+        pixels[i] = slot.depth[i];
+    }
+}
+
@@ -0,0 +1,178 @@
+/*
+ *  DepthPlayer.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+#include "DepthRecording.h"
+#include "DepthSource.h"
+#include "ThreadSignal.h"
+
+class DepthPlayer;
+
+//========================== class DepthDecoderThread ==============================
+//============================================================================
+/** \class DepthDecoderThread DepthPlayer.h
+ *	\brief One of the threads decoding the frames of a DepthPlayer ahead of playback
+ */
+
+class DepthDecoderThread: public ofThread
+{
+
+public:
+
+    //! Constructor
+    DepthDecoderThread();
+
+    //! Destructor
+    ~DepthDecoderThread();
+
+    //! Starts decoding the frames of the given player
+    void start(DepthPlayer* player);
+
+    //! Stops the thread once the frame being decoded is done
+    void stop();
+
+private:
+
+    void threadedFunction();
+
+private:
+
+    DepthPlayer*            m_player;           ///< player whose frames are decoded
+};
+
+
+//========================== class DepthPlayer ==============================
+//============================================================================
+/** \class DepthPlayer DepthPlayer.h
+ *	\brief Plays a DepthRecording file back as depth frames in millimetres
+ *	\details The file is memory mapped and seeking goes straight to the frame through
+ *    the index. A pool of decoder threads claims the frames following the one being
+ *    played and decodes them into NUM_SLOTS slots, frame n into slot n % NUM_SLOTS, so
+ *    the next frames are usually ready by the time they are needed. update() follows
+ *    the recorded timestamps and loops; nextFrame() steps through every frame in order,
+ *    as fast as they are decoded.
+ */
+
+class DepthPlayer: public DepthSource
+{
+
+public:
+
+    static const int NUM_SLOTS;
+    static const int NUM_DECODERS;
+
+    //! Constructor
+    DepthPlayer();
+
+    //! Destructor
+    ~DepthPlayer();
+
+    //! Maps a recording and starts decoding it from the first frame
+    bool open(const string& path);
+
+    //! Stops decoding and unmaps the recording
+    void close();
+
+    //! Returns whether a recording is open
+    bool isOpen() const {return m_data != NULL;}
+
+    //! Moves to the frame the recorded timestamps say is due, looping at the end
+    void update();
+
+    //! Moves to the next frame, waiting for it to be decoded. Returns false at the end of the recording
+    bool nextFrame();
+
+    //! Moves to the given frame, the next update or nextFrame() shows it
+    void seek(int frame);
+
+    //! Returns whether the last update or nextFrame() moved to a new frame
+    bool isFrameNew() const {return m_frameNew;}
+
+    //! Returns the depth of the current frame in millimetres, valid until the next update
+    const ofFloatPixels& getPixels() const {return m_slots[m_currentFrame % NUM_SLOTS].pixels;}
+
+    //! Returns the capture time of the current frame, in microseconds since the epoch
+    unsigned long long getTimestamp() const {return m_index[m_currentFrame].timestamp;}
+
+    //! Returns the number of the current frame
+    int getCurrentFrame() const {return m_currentFrame;}
+
+    //! Returns the number of frames of the recording
+    int getNumFrames() const {return m_index.size();}
+
+    //! Returns the width of the frames in pixels
+    int getWidth() const {return m_width;}
+
+    //! Returns the height of the frames in pixels
+    int getHeight() const {return m_height;}
+
+    int getType() const {return RECORDING;}
+
+    //! Decodes the next frame nobody has claimed, called from the decoder threads. Returns false if there was none
+    bool decodeNext();
+
+    //! Waits until there may be a frame to claim, called from the decoder threads
+    void waitForDecode() {m_decodeSignal.wait();}
+
+    //! Wakes a decoder waiting for a frame to claim
+    void notifyDecode() {m_decodeSignal.notify();}
+
+private:
+
+    //! A decoded frame
+    struct Slot
+    {
+        std::atomic<int>    frame;              ///< frame decoded in the slot, -1 if none, released once the slot is written
+        std::atomic<bool>   busy;               ///< set while a decoder writes the slot
+        vector<uint16_t>    depth;              ///< decoded depth
+        ofFloatPixels       pixels;             ///< decoded depth as floats, like the sensor gives it
+    };
+
+    //! Reads the index at the end of the file, or rebuilds it if the recording wasn't closed
+    void readIndex();
+
+    //! Walks the frame chunks to build the index
+    void rebuildIndex();
+
+    //! Decodes a frame into its slot
+    void decodeFrame(int frame, Slot& slot);
+
+    //! Makes the given frame the current one if it is decoded
+    bool takeFrame(int frame);
+
+    //! Returns the time of a frame since the start of the recording, in microseconds
+    unsigned long long getTime(int frame) const {return m_index[frame].timestamp - m_index[0].timestamp;}
+
+private:
+
+    const unsigned char*                    m_data;             ///< mapped recording, NULL while closed
+    size_t                                  m_size;             ///< bytes mapped
+    int                                     m_width;            ///< width of the frames in pixels
+    int                                     m_height;           ///< height of the frames in pixels
+    vector<DepthRecording::IndexEntry>      m_index;            ///< offset and timestamp of every frame
+
+    vector<Slot>                            m_slots;            ///< decoded frames
+    vector<ofPtr<DepthDecoderThread> >      m_decoders;         ///< decoder pool
+    std::atomic<int>                        m_playFrame;        ///< frame being played, the decoders stay within NUM_SLOTS of it
+    std::atomic<int>                        m_nextDecode;       ///< next frame to be claimed by a decoder
+    std::atomic<int>                        m_numBusy;          ///< number of decoders claiming or decoding a frame
+    std::atomic<bool>                       m_seeking;          ///< keeps the decoders from claiming frames while seeking
+    ThreadSignal                            m_decodeSignal;     ///< wakes a decoder when playback moves on or a frame was claimed
+    ThreadSignal                            m_decodedSignal;    ///< wakes nextFrame() when a frame was decoded
+
+    int                                     m_currentFrame;     ///< frame shown, -1 before the first one
+    bool                                    m_frameNew;         ///< whether the last update moved to a new frame
+    unsigned long long                      m_startTime;        ///< elapsed time at which the first frame is due, in microseconds
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,192 @@
+/*
+ *  DepthRecorder.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "DepthRecorder.h"
+
+
+const int DepthRecorder::QUEUE_CAPACITY = 90;
+const int DepthRecorder::WRITE_BUFFER_SIZE = 4*1024*1024;
+
+
+DepthRecorder::DepthRecorder(): m_queue(QUEUE_CAPACITY), m_file(NULL), m_width(0), m_height(0), m_offset(0), m_writeError(false), m_numStalls(0)
+{
+    m_queue.setPushSignal(&m_signal);
+    m_queue.setPopSignal(&m_popSignal);
+}
+
+
+DepthRecorder::~DepthRecorder()
+{
+    this->stop();
+}
+
+
+bool DepthRecorder::start(const string& path, int width, int height)
+{
+    if(m_file){
+        return true;
+    }
+
+    m_file = fopen(path.c_str(), "wb");
+    if(!m_file){
+        ofLogError() <<"DepthRecorder::start -> unable to create " << path;
+        return false;
+    }
+
+    m_writeBuffer.resize(WRITE_BUFFER_SIZE);
+    setvbuf(m_file, &m_writeBuffer[0], _IOFBF, m_writeBuffer.size());
+
+    m_path = path;
+    m_width = width;
+    m_height = height;
+    m_encoded.resize(DepthRecording::getMaxEncodedSize(width, height));
+    m_index.clear();
+    m_index.reserve(30*60*10);
+    m_writeError = false;
+    m_numStalls = 0;
+
+    DepthRecording::FileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = DepthRecording::MAGIC;
+    header.version = DepthRecording::VERSION;
+    header.width = width;
+    header.height = height;
+    header.startTime = ofGetSystemTimeMicros();
+    fwrite(&header, sizeof(header), 1, m_file);
+    m_offset = sizeof(header);
+
+    startThread();
+
+    ofLogNotice() <<"DepthRecorder::start -> recording " << width << "x" << height << " depth to " << path;
+    return true;
+}
+
+void DepthRecorder::stop()
+{
+    if(!m_file){
+        return;
+    }
+
+    // the thread writes whatever is still queued before it finishes
+    if(isThreadRunning()){
+        stopThread();
+        m_signal.notify();
+        waitForThread(false);
+    }
+
+    this->writeIndex();
+    fclose(m_file);
+    m_file = NULL;
+
+    ofLogNotice() <<"DepthRecorder::stop -> " << m_index.size() << " frames, " << m_offset/(1024*1024) << " MB written to " << m_path;
+    if(m_numStalls > 0){
+        ofLogWarning() <<"DepthRecorder::stop -> " << m_numStalls << " frames waited for the disk to catch up";
+    }
+}
+
+void DepthRecorder::addFrame(const ofFloatPixels& depth, unsigned long long timestamp)
+{
+    if(!m_file || depth.getWidth() != m_width || depth.getHeight() != m_height){
+        return;
+    }
+
+    // dropping the oldest frame would leave a gap in the recording, so the render thread waits for the disk instead
+    if(m_queue.isFull()){
+        unsigned long long start = ofGetElapsedTimeMicros();
+        while(m_queue.isFull()) {
+            m_popSignal.wait();
+        }
+
+        m_numStalls++;
+        ofLogWarning() <<"DepthRecorder::addFrame -> the disk fell behind, a frame waited " << (ofGetElapsedTimeMicros() - start)/1000 << " ms";
+    }
+
+    DepthRecorderFrame& frame = m_queue.getWriteFrame();
+    frame.timestamp = timestamp;
+    frame.depth.resize(m_width*m_height);
+
+    const float* pixels = depth.getPixels();
+    int numChannels = depth.getNumChannels();
+    for(int i = 0; i < m_width*m_height; i++) {
+        float value = pixels[i*numChannels];
+        frame.depth[i] = value <= 0 ? 0 : uint16_t(min(value + 0.5f, 65535.0f));
+    }
+
+    m_queue.push();
+}
+
+void DepthRecorder::threadedFunction()
+{
+    while(isThreadRunning())
+    {
+        DepthRecorderFrame* frame = m_queue.pop();
+        if(frame){
+            this->writeFrame(*frame);
+        }
+        else{
+            m_signal.wait();
+        }
+    }
+
+    while(DepthRecorderFrame* frame = m_queue.pop()) {
+        this->writeFrame(*frame);
+    }
+}
+
+void DepthRecorder::writeFrame(const DepthRecorderFrame& frame)
+{
+    // the offsets of the index would be wrong after a partial write
+    if(m_writeError){
+        return;
+    }
+
+    size_t encodedSize = DepthRecording::encode(&frame.depth[0], m_width, m_height, &m_encoded[0]);
+
+    DepthRecording::FrameHeader header;
+    header.chunk.type = DepthRecording::CHUNK_FRAME;
+    header.chunk.size = sizeof(header) - sizeof(header.chunk) + encodedSize;
+    header.timestamp = frame.timestamp;
+    header.frameNumber = m_index.size();
+    header.encodedSize = encodedSize;
+
+    if(fwrite(&header, sizeof(header), 1, m_file) != 1 || fwrite(&m_encoded[0], 1, encodedSize, m_file) != encodedSize){
+        if(!m_writeError){
+            ofLogError() <<"DepthRecorder::writeFrame -> unable to write frame " << m_index.size() << " to " << m_path;
+            m_writeError = true;
+        }
+        return;
+    }
+
+    DepthRecording::IndexEntry entry;
+    entry.offset = m_offset;
+    entry.timestamp = frame.timestamp;
+    m_index.push_back(entry);
+
+    m_offset += sizeof(header) + encodedSize;
+}
+
+void DepthRecorder::writeIndex()
+{
+    DepthRecording::ChunkHeader chunk;
+    chunk.type = DepthRecording::CHUNK_INDEX;
+    chunk.size = m_index.size()*sizeof(DepthRecording::IndexEntry);
+
+    DepthRecording::Trailer trailer;
+    trailer.indexOffset = m_offset;
+    trailer.numFrames = m_index.size();
+    trailer.magic = DepthRecording::TRAILER_MAGIC;
+
+    fwrite(&chunk, sizeof(chunk), 1, m_file);
+    if(!m_index.empty()){
+        fwrite(&m_index[0], sizeof(DepthRecording::IndexEntry), m_index.size(), m_file);
+    }
+    fwrite(&trailer, sizeof(trailer), 1, m_file);
+
+    m_offset += sizeof(chunk) + chunk.size + sizeof(trailer);
+}
+
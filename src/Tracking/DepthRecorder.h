@@ -0,0 +1,98 @@
+/*
+ *  DepthRecorder.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "FrameQueue.h"
+#include "DepthRecording.h"
+
+//========================== struct DepthRecorderFrame ==============================
+//============================================================================
+/** \struct DepthRecorderFrame DepthRecorder.h
+ *	\brief A depth frame waiting to be encoded and written
+ */
+
+struct DepthRecorderFrame
+{
+    vector<uint16_t>        depth;              ///< depth in millimetres
+    unsigned long long      timestamp;          ///< capture time, in microseconds since the epoch
+};
+
+
+//========================== class DepthRecorder ==============================
+//============================================================================
+/** \class DepthRecorder DepthRecorder.h
+ *	\brief Records the depth frames of the sensor to a DepthRecording file
+ *	\details The render thread only converts the depth to millimetres and queues it;
+ *    this thread encodes the frames and writes them through a large buffer, so the
+ *    disk sees long sequential writes. The queue holds a few seconds of frames, which
+ *    covers the stalls of a spinning disk. A recording never drops a frame: when the
+ *    disk falls further behind, addFrame() waits for room and warns as it happens.
+ *    Stopping drains the queue and closes the file with its index.
+ */
+
+class DepthRecorder: public ofThread
+{
+
+public:
+
+    static const int QUEUE_CAPACITY;
+    static const int WRITE_BUFFER_SIZE;
+
+    //! Constructor
+    DepthRecorder();
+
+    //! Destructor
+    ~DepthRecorder();
+
+    //! Starts recording frames of the given size to a new file
+    bool start(const string& path, int width, int height);
+
+    //! Writes the queued frames and closes the file with its index
+    void stop();
+
+    //! Queues a depth frame in millimetres to be recorded, waiting for room if the disk fell behind
+    void addFrame(const ofFloatPixels& depth, unsigned long long timestamp);
+
+    //! Returns whether it is recording
+    bool isRecording() const {return m_file != NULL;}
+
+    //! Returns the number of frames of the recording that had to wait for the disk to catch up
+    unsigned int getNumStalls() const {return m_numStalls;}
+
+private:
+
+    void threadedFunction();
+
+    //! Encodes and writes a frame chunk
+    void writeFrame(const DepthRecorderFrame& frame);
+
+    //! Writes the index chunk and the trailer
+    void writeIndex();
+
+private:
+
+    FrameQueue<DepthRecorderFrame>          m_queue;            ///< frames waiting to be written
+    FILE*                                   m_file;             ///< recording being written, NULL while stopped
+    vector<char>                            m_writeBuffer;      ///< buffer of the file writes
+    string                                  m_path;             ///< path of the recording
+    int                                     m_width;            ///< width of the frames in pixels
+    int                                     m_height;           ///< height of the frames in pixels
+    uint64_t                                m_offset;           ///< bytes written so far
+    vector<unsigned char>                   m_encoded;          ///< preallocated encoded frame
+    vector<DepthRecording::IndexEntry>      m_index;            ///< offset and timestamp of every frame written
+    bool                                    m_writeError;       ///< whether a write failed, reported once
+    unsigned int                            m_numStalls;        ///< frames of this recording that waited for room in the queue
+    ThreadSignal                            m_signal;           ///< notified on every push, wakes the thread
+    ThreadSignal                            m_popSignal;        ///< notified on every pop, wakes addFrame() waiting for room
+};
+
+//==========================================================================
+
+
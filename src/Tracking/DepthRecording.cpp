@@ -0,0 +1,116 @@
+/*
+ *  DepthRecording.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "DepthRecording.h"
+
+
+const uint32_t DepthRecording::MAGIC = 0x5045444D;           // "MDEP"
+const uint32_t DepthRecording::VERSION = 1;
+const uint32_t DepthRecording::CHUNK_FRAME = 0x4D415246;     // "FRAM"
+const uint32_t DepthRecording::CHUNK_INDEX = 0x58444E49;     // "INDX"
+const uint32_t DepthRecording::TRAILER_MAGIC = 0x5844494D;   // "MIDX"
+const char* DepthRecording::FILE_EXTENSION = "mdep";
+
+
+//! Returns the prediction of a pixel from the ones already coded
+static inline int predict(const uint16_t* depth, size_t i, int width)
+{
+    if(i % width){
+        return depth[i - 1];
+    }
+
+    return (i >= size_t(width)) ? depth[i - width] : 0;
+}
+
+
+size_t DepthRecording::encode(const uint16_t* depth, int width, int height, unsigned char* output)
+{
+    size_t numPixels = size_t(width)*height;
+    unsigned char* out = output;
+
+    size_t i = 0;
+    while(i < numPixels)
+    {
+        int residual = int(depth[i]) - predict(depth, i, width);
+
+        if(residual == 0){
+            size_t end = i + 1;
+            while(end < numPixels && end - i < 64 && depth[end] == predict(depth, end, width)){
+                end++;
+            }
+            *out++ = 0x80 | (end - i - 1);
+            i = end;
+            continue;
+        }
+
+        uint32_t zigzag = (uint32_t(residual) << 1) ^ uint32_t(residual >> 31);
+        if(zigzag < 0x80){
+            *out++ = zigzag;
+        }
+        else if(zigzag < 0x80 + 63*256){
+            zigzag -= 0x80;
+            *out++ = 0xC0 | (zigzag >> 8);
+            *out++ = zigzag & 0xFF;
+        }
+        else{
+            *out++ = 0xFF;
+            *out++ = depth[i] & 0xFF;
+            *out++ = depth[i] >> 8;
+        }
+        i++;
+    }
+
+    return out - output;
+}
+
+bool DepthRecording::decode(const unsigned char* data, size_t size, int width, int height, uint16_t* depth)
+{
+    size_t numPixels = size_t(width)*height;
+    const unsigned char* end = data + size;
+
+    size_t i = 0;
+    while(i < numPixels && data < end)
+    {
+        unsigned char token = *data++;
+
+        if(token < 0x80){
+            int residual = (token >> 1) ^ -int(token & 1);
+            depth[i] = predict(depth, i, width) + residual;
+            i++;
+        }
+        else if(token < 0xC0){
+            size_t run = (token & 0x3F) + 1;
+            if(i + run > numPixels){
+                return false;
+            }
+            for(size_t last = i + run; i < last; i++) {
+                depth[i] = predict(depth, i, width);
+            }
+        }
+        else if(token < 0xFF){
+            if(data == end){
+                return false;
+            }
+            uint32_t zigzag = 0x80 + (uint32_t(token & 0x3F) << 8 | *data++);
+            int residual = (zigzag >> 1) ^ -int(zigzag & 1);
+            depth[i] = predict(depth, i, width) + residual;
+            i++;
+        }
+        else{
+            if(end - data < 2){
+                return false;
+            }
+            depth[i] = data[0] | (data[1] << 8);
+            data += 2;
+            i++;
+        }
+    }
+
+    return i == numPixels && data == end;
+}
+
@@ -0,0 +1,104 @@
+/*
+ *  DepthRecording.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+//========================== class DepthRecording ==============================
+//============================================================================
+/** \class DepthRecording DepthRecording.h
+ *	\brief Layout of the depth recording files and the codec of their frames
+ *	\details A recording starts with a FileHeader followed by one chunk per frame: a
+ *    FrameHeader and the encoded depth. Closing the recording appends an index chunk,
+ *    with the offset and the timestamp of every frame, and a Trailer pointing at it,
+ *    so a player seeks to any frame in constant time. A recording that was never
+ *    closed has no trailer, and its index is rebuilt by walking the chunks.
+ *
+ *    The depth is stored as millimetres in 16 bits. Every pixel is predicted from
+ *    the previous one in the row, and the first one of a row from the one above.
+ *    The residuals are zigzag coded and written as bytes:
+ *
+ *      0x00 - 0x7F     residual 0 to 127
+ *      0x80 - 0xBF     run of 1 to 64 zero residuals
+ *      0xC0 - 0xFE     residual 128 to 16255, with the low 8 bits in the next byte
+ *      0xFF            raw depth in the next 2 bytes, little endian
+ *
+ *    The invalid pixels and the flat floor turn into runs, and a frame of a scene
+ *    takes a fraction of its raw size. The codec is lossless.
+ */
+
+class DepthRecording
+{
+
+public:
+
+    static const uint32_t   MAGIC;
+    static const uint32_t   VERSION;
+    static const uint32_t   CHUNK_FRAME;
+    static const uint32_t   CHUNK_INDEX;
+    static const uint32_t   TRAILER_MAGIC;
+    static const char*      FILE_EXTENSION;
+
+    //! Beginning of the file
+    struct FileHeader
+    {
+        uint32_t            magic;          ///< MAGIC
+        uint32_t            version;        ///< VERSION of the layout
+        uint32_t            width;          ///< width of the frames in pixels
+        uint32_t            height;         ///< height of the frames in pixels
+        uint64_t            startTime;      ///< time the recording started, in microseconds since the epoch
+        uint32_t            reserved[2];
+    };
+
+    //! Beginning of every chunk
+    struct ChunkHeader
+    {
+        uint32_t            type;           ///< CHUNK_FRAME or CHUNK_INDEX
+        uint32_t            size;           ///< bytes of the chunk after this header
+    };
+
+    //! Frame chunk, followed by the encoded depth
+    struct FrameHeader
+    {
+        ChunkHeader         chunk;          ///< CHUNK_FRAME and the bytes after it
+        uint64_t            timestamp;      ///< capture time in microseconds since the epoch
+        uint32_t            frameNumber;    ///< number of the frame, increasing from 0
+        uint32_t            encodedSize;    ///< bytes of the encoded depth
+    };
+
+    //! Entry of the index chunk
+    struct IndexEntry
+    {
+        uint64_t            offset;         ///< position of the frame chunk in the file
+        uint64_t            timestamp;      ///< capture time in microseconds since the epoch
+    };
+
+    //! End of a closed recording
+    struct Trailer
+    {
+        uint64_t            indexOffset;    ///< position of the index chunk in the file
+        uint32_t            numFrames;      ///< number of index entries
+        uint32_t            magic;          ///< TRAILER_MAGIC
+    };
+
+    //! Returns the most bytes a frame of the given size can be encoded to
+    static size_t getMaxEncodedSize(int width, int height) {return 3*size_t(width)*height;}
+
+    //! Encodes a frame of depth in millimetres into a buffer of getMaxEncodedSize() bytes, returns the bytes written
+    static size_t encode(const uint16_t* depth, int width, int height, unsigned char* output);
+
+    //! Decodes a frame, returns false if the data is corrupt or doesn't fill the frame
+    static bool decode(const unsigned char* data, size_t size, int width, int height, uint16_t* depth);
+};
+
+//==========================================================================
+
+
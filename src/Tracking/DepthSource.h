@@ -0,0 +1,76 @@
+/*
+ *  DepthSource.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+
+
+//========================== class DepthSource ==============================
+//============================================================================
+/** \class DepthSource DepthSource.h
+ *	\brief Interface of everything the tracking can take its depth frames from
+ *	\details A source is opened by its own class and then only updated from the
+ *    render thread, which takes its frames as depth in millimetres with their
+ *    capture time. The tracking switches between sources at runtime.
+ */
+
+class DepthSource
+{
+
+public:
+
+    enum Type {
+        KINECT,             ///< Microsoft Kinect v2
+        WEB_CAMERA,         ///< laptop camera, the brightness standing in for the depth
+        SYNTHETIC,          ///< generated crowd
+        RECORDING,          ///< depth recording played back
+        NUM_TYPES
+    };
+
+    //! Destructor
+    virtual ~DepthSource() {}
+
+    //! Stops capturing
+    virtual void close() = 0;
+
+    //! Moves to the latest frame
+    virtual void update() = 0;
+
+    //! Moves to the next frame in order, waiting for it if the source can. Returns whether there was a new frame
+    virtual bool nextFrame() {this->update(); return this->isFrameNew();}
+
+    //! Returns whether the last update moved to a new frame
+    virtual bool isFrameNew() const = 0;
+
+    //! Returns the depth of the current frame in millimetres, valid until the next update
+    virtual const ofFloatPixels& getPixels() const = 0;
+
+    //! Returns the capture time of the current frame, in microseconds since the epoch
+    virtual unsigned long long getTimestamp() const = 0;
+
+    //! Returns the width of the frames in pixels
+    virtual int getWidth() const = 0;
+
+    //! Returns the height of the frames in pixels
+    virtual int getHeight() const = 0;
+
+    //! Returns the type of the source
+    virtual int getType() const = 0;
+
+    //! Returns the name of a type of source
+    static const char* getTypeName(int type)
+    {
+        static const char* names[NUM_TYPES] = {"Kinect", "web camera", "synthetic", "recording"};
+        return (type >= 0 && type < NUM_TYPES) ? names[type] : "unknown";
+    }
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,181 @@
+/*
+ *  FourierDescriptors.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "FourierDescriptors.h"
+#include "TrackingManager.h"
+#include "fft.h"
+
+
+const int FourierDescriptors::MIN_RING_SIZE = 64;
+const int FourierDescriptors::MAX_COEFFICIENTS = 64;
+
+
+FourierDescriptors::FourierDescriptors(): m_fft(NULL), m_ringSize(0), m_numCoefficients(16)
+{
+    m_fft = new fft(getRingSize(MAX_COEFFICIENTS));
+    m_ringSize = getRingSize(m_numCoefficients);
+}
+
+
+FourierDescriptors::FourierDescriptors(const FourierDescriptors& other): m_fft(NULL), m_ringSize(0), m_numCoefficients(other.m_numCoefficients)
+{
+    m_fft = new fft(getRingSize(MAX_COEFFICIENTS));
+    m_ringSize = getRingSize(m_numCoefficients);
+    this->copyFrom(other);
+}
+
+
+FourierDescriptors::~FourierDescriptors()
+{
+    if(m_fft){
+        delete m_fft;
+        m_fft = NULL;
+    }
+}
+
+
+FourierDescriptors& FourierDescriptors::operator=(const FourierDescriptors& other)
+{
+    if(this != &other){
+        this->copyFrom(other);
+    }
+    return *this;
+}
+
+void FourierDescriptors::copyFrom(const FourierDescriptors& other)
+{
+    this->setNumCoefficients(other.m_numCoefficients);
+    m_coefficients.assign(other.m_coefficients.begin(), other.m_coefficients.end());
+    m_labels.assign(other.m_labels.begin(), other.m_labels.end());
+}
+
+void FourierDescriptors::setNumCoefficients(int numCoefficients)
+{
+    // the fft holds the largest ring, so changing the ring size never reallocates it
+    m_numCoefficients = ofClamp(numCoefficients, 2, MAX_COEFFICIENTS);
+    m_ringSize = getRingSize(m_numCoefficients);
+}
+
+int FourierDescriptors::getRingSize(int numCoefficients)
+{
+    // enough points that the highest kept frequency is well below the Nyquist limit
+    int ringSize = MIN_RING_SIZE;
+    while(ringSize < 4*numCoefficients){
+        ringSize *= 2;
+    }
+
+    return ringSize;
+}
+
+void FourierDescriptors::compute(const ContourSet& contours)
+{
+    int n = m_ringSize;
+    int numContours = contours.size();
+
+    m_labels.resize(numContours);
+    m_rings.resize(2*n*numContours);
+    m_coefficients.resize(2*m_numCoefficients*numContours);
+
+    // resample every contour first so the transforms run back to back on the same buffers
+    for(int i = 0; i < numContours; i++) {
+        m_labels[i] = contours.getLabel(i);
+        this->resample(contours.getVertices(i), contours.getNumVertices(i), &m_rings[2*n*i], &m_rings[2*n*i + n]);
+    }
+
+    for(int i = 0; i < numContours; i++)
+    {
+        FFT(n, false, &m_rings[2*n*i], &m_rings[2*n*i + n], m_fft->out_real, m_fft->out_img);
+
+        float* coefficients = &m_coefficients[2*m_numCoefficients*i];
+        for(int j = 0; j < m_numCoefficients; j++) {
+            int k = (getFrequency(j) + n) % n;
+            coefficients[2*j] = m_fft->out_real[k]/n;
+            coefficients[2*j+1] = m_fft->out_img[k]/n;
+        }
+    }
+}
+
+void FourierDescriptors::resample(const ofVec2f* vertices, int numVertices, float* real, float* imag)
+{
+    int n = m_ringSize;
+    if(numVertices == 0){
+        std::fill(real, real + n, 0.0f);
+        std::fill(imag, imag + n, 0.0f);
+        return;
+    }
+
+    m_lengths.resize(numVertices + 1);
+    m_lengths[0] = 0;
+    for(int j = 0; j < numVertices; j++) {
+        m_lengths[j+1] = m_lengths[j] + vertices[j].distance(vertices[(j + 1) % numVertices]);
+    }
+
+    float length = m_lengths[numVertices];
+    int segment = 0;
+    for(int j = 0; j < n; j++)
+    {
+        float target = length*j/n;
+        while(segment < numVertices - 1 && m_lengths[segment + 1] < target){
+            segment++;
+        }
+
+        const ofVec2f& a = vertices[segment];
+        const ofVec2f& b = vertices[(segment + 1) % numVertices];
+        float segmentLength = m_lengths[segment + 1] - m_lengths[segment];
+        float t = segmentLength > 0 ? (target - m_lengths[segment])/segmentLength : 0;
+
+        real[j] = (a.x + (b.x - a.x)*t)/TrackingManager::DEPTH_CAMERA_WIDTH;
+        imag[j] = (a.y + (b.y - a.y)*t)/TrackingManager::DEPTH_CAMERA_HEIGHT;
+    }
+}
+
+void FourierDescriptors::draw()
+{
+    int n = m_ringSize;
+
+    ofPushStyle();
+    ofNoFill();
+    for(int i = 0; i < this->size(); i++)
+    {
+        std::fill(m_fft->in_real, m_fft->in_real + n, 0.0f);
+        std::fill(m_fft->in_img, m_fft->in_img + n, 0.0f);
+
+        // the inverse transform divides by the ring size
+        const float* coefficients = this->getCoefficients(i);
+        for(int j = 0; j < m_numCoefficients; j++) {
+            int k = (getFrequency(j) + n) % n;
+            m_fft->in_real[k] = coefficients[2*j]*n;
+            m_fft->in_img[k] = coefficients[2*j+1]*n;
+        }
+
+        FFT(n, true, m_fft->in_real, m_fft->in_img, m_fft->out_real, m_fft->out_img);
+
+        ofBeginShape();
+        for(int j = 0; j < n; j++) {
+            ofVertex(m_fft->out_real[j]*TrackingManager::DEPTH_CAMERA_WIDTH, m_fft->out_img[j]*TrackingManager::DEPTH_CAMERA_HEIGHT);
+        }
+        ofEndShape(true);
+    }
+    ofPopStyle();
+}
+
+void FourierDescriptors::reconstruct(const float* coefficients, int numCoefficients, int numPoints, vector<ofVec2f>& points)
+{
+    points.assign(numPoints, ofVec2f(0,0));
+    for(int i = 0; i < numPoints; i++)
+    {
+        for(int j = 0; j < numCoefficients; j++)
+        {
+            float angle = TWO_PI*getFrequency(j)*i/numPoints;
+            float c = cos(angle), s = sin(angle);
+            points[i].x += coefficients[2*j]*c - coefficients[2*j+1]*s;
+            points[i].y += coefficients[2*j]*s + coefficients[2*j+1]*c;
+        }
+    }
+}
+
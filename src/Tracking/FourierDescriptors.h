@@ -0,0 +1,99 @@
+/*
+ *  FourierDescriptors.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ContourSet.h"
+
+class fft;
+
+//========================== class FourierDescriptors ==============================
+//============================================================================
+/** \class FourierDescriptors FourierDescriptors.h
+ *	\brief Describes closed contours by their low order Fourier coefficients
+ *	\details Every contour is resampled to a power of two ring of points evenly spaced
+ *    along its arc length, and the ring, read as x + iy, is transformed with the ofxFft
+ *    fft. Only the lowest frequencies are kept, so truncating them smooths the outline
+ *    and the payload has the same size for every contour. The coefficients are in
+ *    normalized sensor coordinates, ordered by frequency 0, 1, -1, 2, -2...
+ */
+
+class FourierDescriptors
+{
+
+public:
+
+    static const int MIN_RING_SIZE;
+    static const int MAX_COEFFICIENTS;
+
+    //! Constructor
+    FourierDescriptors();
+
+    //! Copy constructor, the copy has its own fft
+    FourierDescriptors(const FourierDescriptors& other);
+
+    //! Destructor
+    ~FourierDescriptors();
+
+    //! Assignment, keeps the own fft
+    FourierDescriptors& operator=(const FourierDescriptors& other);
+
+    //! Copies the coefficients and labels of other descriptors, reusing the allocated memory
+    void copyFrom(const FourierDescriptors& other);
+
+    //! Set the number of complex coefficients kept for every contour
+    void setNumCoefficients(int numCoefficients);
+
+    //! Returns the number of complex coefficients kept for every contour
+    int getNumCoefficients() const {return m_numCoefficients;}
+
+    //! Computes the descriptors of all the contours of a frame
+    void compute(const ContourSet& contours);
+
+    //! Draws the contours rebuilt from their descriptors, in sensor pixels
+    void draw();
+
+    //! Returns the number of described contours
+    int size() const {return m_labels.size();}
+
+    //! Returns the tracker label of the given contour
+    unsigned int getLabel(int i) const {return m_labels[i];}
+
+    //! Returns the real and imaginary parts of the coefficients of the given contour
+    const float* getCoefficients(int i) const {return &m_coefficients[2*m_numCoefficients*i];}
+
+    //! Returns the frequency of the coefficient at the given position
+    static int getFrequency(int j) {return (j % 2) ? (j + 1)/2 : -j/2;}
+
+    //! Evaluates the outline described by the coefficients at any number of points
+    static void reconstruct(const float* coefficients, int numCoefficients, int numPoints, vector<ofVec2f>& points);
+
+private:
+
+    //! Returns the ring size needed to keep the given number of coefficients
+    static int getRingSize(int numCoefficients);
+
+    //! Resamples a closed contour to the ring, evenly spaced along its arc length
+    void resample(const ofVec2f* vertices, int numVertices, float* real, float* imag);
+
+private:
+
+    fft*                    m_fft;              ///< transform of one ring, allocated once for the largest ring
+    int                     m_ringSize;         ///< number of points every contour is resampled to
+    int                     m_numCoefficients;  ///< number of complex coefficients kept for every contour
+
+    vector<float>           m_rings;            ///< resampled rings of all the contours, real parts then imaginary parts
+    vector<float>           m_lengths;          ///< cumulative arc lengths of the contour being resampled
+    vector<float>           m_coefficients;     ///< coefficients of all the contours, real and imaginary interleaved
+    vector<unsigned int>    m_labels;           ///< tracker label of every contour
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,304 @@
+/*
+ *  IncrementalContourFinder.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "IncrementalContourFinder.h"
+
+
+const int IncrementalContourFinder::TILE_SIZE = 32;
+
+
+//! Orders the contours the last found first, like listing them does
+struct CompareContourStart
+{
+    CompareContourStart(const vector<int>& starts): m_starts(starts) {}
+
+    bool operator()(int a, int b) const
+    {
+        return m_starts[a] > m_starts[b];
+    }
+
+    const vector<int>& m_starts;
+};
+
+
+//! Orders the contours by decreasing area, the same way the contour finder of ofxCv does
+struct CompareContourArea
+{
+    CompareContourArea(const vector<double>& areas): m_areas(areas) {}
+
+    bool operator()(size_t a, size_t b) const
+    {
+        return m_areas[a] > m_areas[b];
+    }
+
+    const vector<double>& m_areas;
+};
+
+
+IncrementalContourFinder::IncrementalContourFinder(): m_incremental(false), m_maxDirtyTiles(0.25), m_numTilesX(0), m_numDirtyTiles(0), m_fullScan(true), m_valid(false)
+{
+    //Intentionally left empty
+}
+
+
+IncrementalContourFinder::~IncrementalContourFinder()
+{
+    //Intentionally left empty
+}
+
+
+void IncrementalContourFinder::findContours(cv::Mat img)
+{
+    bool targetRgb = !useTargetColor || trackingColorMode == ofxCv::TRACK_COLOR_RGB;
+    if(!m_incremental || contourFindingMode != CV_RETR_LIST || !targetRgb)
+    {
+        m_valid = false;
+        m_fullScan = true;
+        m_numDirtyTiles = 0;
+        ofxCv::ContourFinder::findContours(img);
+        return;
+    }
+
+    this->threshold(img);
+    m_numDirtyTiles = this->hashTiles();
+    m_fullScan = !m_valid || m_numDirtyTiles > m_maxDirtyTiles*m_hashes.size();
+
+    if(m_fullScan){
+        this->trace(cv::Rect(0, 0, thresh.cols, thresh.rows), true);
+    }
+    else if(m_numDirtyTiles > 0)
+    {
+        // every component that may have changed lies within the dirty tiles and the old components touching them
+        int left = thresh.cols, top = thresh.rows, right = 0, bottom = 0;
+        for(int i = 0; i < m_dirty.size(); i++) {
+            if(m_dirty[i]){
+                int x = (i % m_numTilesX)*TILE_SIZE;
+                int y = (i / m_numTilesX)*TILE_SIZE;
+                left = min(left, x);
+                top = min(top, y);
+                right = max(right, x + TILE_SIZE);
+                bottom = max(bottom, y + TILE_SIZE);
+            }
+        }
+
+        for(int i = 0; i < m_components.size(); i++) {
+            const cv::Rect& component = m_components[i];
+            if(this->isDirty(component)){
+                left = min(left, component.x);
+                top = min(top, component.y);
+                right = max(right, component.x + component.width);
+                bottom = max(bottom, component.y + component.height);
+            }
+        }
+
+        // a pixel of margin keeps the components off the border of the region
+        left = max(left - 1, 0);
+        top = max(top - 1, 0);
+        right = min(right + 1, thresh.cols);
+        bottom = min(bottom + 1, thresh.rows);
+        this->trace(cv::Rect(left, top, right - left, bottom - top), false);
+    }
+
+    m_valid = true;
+    this->select(img.rows*img.cols);
+}
+
+void IncrementalContourFinder::threshold(cv::Mat img)
+{
+    if(useTargetColor) {
+        cv::Scalar offset(thresholdValue, thresholdValue, thresholdValue);
+        cv::Scalar base = ofxCv::toCv(targetColor);
+        cv::inRange(img, base - offset, base + offset, thresh);
+    }
+    else{
+        ofxCv::copyGray(img, thresh);
+    }
+
+    if(autoThreshold){
+        ofxCv::threshold(thresh, thresholdValue, invert);
+    }
+}
+
+int IncrementalContourFinder::hashTiles()
+{
+    int width = thresh.cols;
+    int height = thresh.rows;
+    int numTilesX = (width + TILE_SIZE - 1)/TILE_SIZE;
+    int numTilesY = (height + TILE_SIZE - 1)/TILE_SIZE;
+
+    if(numTilesX != m_numTilesX || numTilesX*numTilesY != m_hashes.size())
+    {
+        // the last frame had another size, nothing of it can be kept
+        m_numTilesX = numTilesX;
+        m_hashes.assign(numTilesX*numTilesY, 0);
+        m_dirty.assign(numTilesX*numTilesY, 1);
+        m_valid = false;
+    }
+
+    int numDirty = 0;
+    for(int tileY = 0; tileY < numTilesY; tileY++)
+    {
+        int y0 = tileY*TILE_SIZE;
+        int y1 = min(y0 + TILE_SIZE, height);
+        for(int tileX = 0; tileX < numTilesX; tileX++)
+        {
+            int x0 = tileX*TILE_SIZE;
+            int tileWidth = min(TILE_SIZE, width - x0);
+            int numWords = tileWidth/sizeof(uint64_t);
+
+            uint64_t hash = 0x9E3779B97F4A7C15ULL;
+            for(int y = y0; y < y1; y++)
+            {
+                const unsigned char* row = thresh.ptr<unsigned char>(y) + x0;
+                for(int i = 0; i < numWords; i++) {
+                    uint64_t word;
+                    memcpy(&word, row + i*sizeof(uint64_t), sizeof(uint64_t));
+                    hash = (hash ^ word)*0xFF51AFD7ED558CCDULL;
+                    hash ^= hash >> 29;
+                }
+                for(int x = numWords*sizeof(uint64_t); x < tileWidth; x++) {
+                    hash = (hash ^ row[x])*0xFF51AFD7ED558CCDULL;
+                    hash ^= hash >> 29;
+                }
+            }
+
+            int tile = tileY*numTilesX + tileX;
+            bool dirty = !m_valid || hash != m_hashes[tile];
+            m_hashes[tile] = hash;
+            m_dirty[tile] = dirty;
+            numDirty += dirty;
+        }
+    }
+
+    return numDirty;
+}
+
+bool IncrementalContourFinder::isDirty(const cv::Rect& box) const
+{
+    int tileX0 = max(box.x - 1, 0)/TILE_SIZE;
+    int tileY0 = max(box.y - 1, 0)/TILE_SIZE;
+    int tileX1 = min(box.x + box.width, thresh.cols - 1)/TILE_SIZE;
+    int tileY1 = min(box.y + box.height, thresh.rows - 1)/TILE_SIZE;
+
+    for(int tileY = tileY0; tileY <= tileY1; tileY++) {
+        for(int tileX = tileX0; tileX <= tileX1; tileX++) {
+            if(m_dirty[tileY*m_numTilesX + tileX]){
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void IncrementalContourFinder::trace(const cv::Rect& region, bool full)
+{
+    // the two level hierarchy gives the outer contour of every hole, the contours are the same as listing them
+    cv::Mat mask = thresh(region);
+    int simplifyMode = simplify ? CV_CHAIN_APPROX_SIMPLE : CV_CHAIN_APPROX_NONE;
+    cv::findContours(mask, m_found, m_hierarchy, CV_RETR_CCOMP, simplifyMode, region.tl());
+
+    m_foundComponents.resize(m_found.size());
+    for(int i = 0; i < m_found.size(); i++) {
+        m_foundComponents[i] = cv::boundingRect(m_found[i]);
+    }
+
+    int numKept = 0;
+    if(!full){
+        for(int i = 0; i < m_traced.size(); i++) {
+            if(!this->isDirty(m_components[i])){
+                numKept++;
+            }
+        }
+    }
+
+    m_merged.resize(numKept + m_found.size());
+    m_mergedStarts.clear();
+    m_mergedComponents.clear();
+
+    // the contours are swapped around, their points are never copied
+    int n = 0;
+    if(!full){
+        for(int i = 0; i < m_traced.size(); i++) {
+            if(!this->isDirty(m_components[i])){
+                m_merged[n++].swap(m_traced[i]);
+                m_mergedStarts.push_back(m_starts[i]);
+                m_mergedComponents.push_back(m_components[i]);
+            }
+        }
+    }
+
+    for(int i = 0; i < m_found.size(); i++)
+    {
+        int parent = m_hierarchy[i][3];
+        const cv::Rect& component = m_foundComponents[parent < 0 ? i : parent];
+        if(!full && !this->isDirty(component)){
+            continue;
+        }
+
+        // at the same pixel the outer border is found before the hole
+        cv::Point start = m_found[i][0];
+        m_merged[n++].swap(m_found[i]);
+        m_mergedStarts.push_back(2*(start.y*thresh.cols + start.x) + (parent >= 0));
+        m_mergedComponents.push_back(component);
+    }
+
+    // OpenCV starts every contour at the pixel of its border it finds first in raster order, and lists the last one found first,
+    // so a partial scan is ordered like a full one
+    m_order.resize(n);
+    for(int i = 0; i < n; i++) {
+        m_order[i] = i;
+    }
+    std::sort(m_order.begin(), m_order.end(), CompareContourStart(m_mergedStarts));
+
+    m_traced.resize(n);
+    m_starts.resize(n);
+    m_components.resize(n);
+    for(int i = 0; i < n; i++) {
+        int index = m_order[i];
+        m_traced[i].swap(m_merged[index]);
+        m_starts[i] = m_mergedStarts[index];
+        m_components[i] = m_mergedComponents[index];
+    }
+}
+
+void IncrementalContourFinder::select(int imageArea)
+{
+    bool needMinFilter = (minArea > 0);
+    bool needMaxFilter = maxAreaNorm ? (maxArea < 1) : (maxArea < numeric_limits<float>::infinity());
+    double imageMinArea = minAreaNorm ? (minArea*imageArea) : minArea;
+    double imageMaxArea = maxAreaNorm ? (maxArea*imageArea) : maxArea;
+
+    m_areas.resize(m_traced.size());
+    m_indices.clear();
+    for(int i = 0; i < m_traced.size(); i++)
+    {
+        m_areas[i] = (needMinFilter || needMaxFilter || sortBySize) ? cv::contourArea(m_traced[i]) : 0;
+        if((!needMinFilter || m_areas[i] >= imageMinArea) && (!needMaxFilter || m_areas[i] <= imageMaxArea)){
+            m_indices.push_back(i);
+        }
+    }
+
+    // sorted like the contour finder of ofxCv, so the contours of equal areas end up in the same order
+    if(m_indices.size() > 1 && sortBySize){
+        std::sort(m_indices.begin(), m_indices.end(), CompareContourArea(m_areas));
+    }
+
+    // the traced contours are kept for the next frame, the selected ones are copies
+    contours.resize(m_indices.size());
+    boundingRects.resize(m_indices.size());
+    for(int i = 0; i < m_indices.size(); i++)
+    {
+        contours[i] = m_traced[m_indices[i]];
+        boundingRects[i] = cv::boundingRect(contours[i]);
+    }
+
+    this->resetPolylines();
+    tracker.track(boundingRects);
+}
+
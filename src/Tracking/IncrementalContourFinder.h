@@ -0,0 +1,112 @@
+/*
+ *  IncrementalContourFinder.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxCv.h"
+
+
+//========================== class IncrementalContourFinder ==============================
+//============================================================================
+/** \class IncrementalContourFinder IncrementalContourFinder.h
+ *	\brief Contour finder retracing only the parts of the mask that changed
+ *	\details The thresholded mask is split in tiles of TILE_SIZE pixels and every tile
+ *    is hashed; the tiles whose hash changed since the last frame are dirty. A
+ *    connected component is traced from its own pixels and their neighbours only, so
+ *    the contours of a component whose bounding box, grown by a pixel, touches no
+ *    dirty tile are the same as in the last frame and are kept. The rest is traced
+ *    again within the bounding box of the dirty tiles and of the old components that
+ *    touch them, which holds every component that may have changed. Above a fraction
+ *    of dirty tiles the whole mask is traced. Either way the contours are ordered like
+ *    OpenCV lists them, the last found first, by the pixel their tracing starts at and
+ *    the outer border before the hole at the same pixel, so the output is the same as
+ *    the contour finder of ofxCv tracing the whole mask every frame.
+ *    Holes have to be found, since a component inside a hole only becomes external
+ *    when its parent changes, and a target colour has to be compared in RGB;
+ *    otherwise it works like the contour finder of ofxCv.
+ */
+
+class IncrementalContourFinder: public ofxCv::ContourFinder
+{
+
+public:
+
+    static const int TILE_SIZE;
+
+    //! Constructor
+    IncrementalContourFinder();
+
+    //! Destructor
+    ~IncrementalContourFinder();
+
+    //! Set whether to retrace only the dirty tiles
+    void setIncremental(bool incremental) {m_incremental = incremental;}
+
+    //! Set the fraction of dirty tiles above which the whole mask is traced
+    void setMaxDirtyTiles(float fraction) {m_maxDirtyTiles = fraction;}
+
+    template <class T>
+    void findContours(T& img) {this->findContours(ofxCv::toCv(img));}
+
+    //! Finds and tracks the contours of the image, retracing only what changed when it can
+    void findContours(cv::Mat img);
+
+    //! Returns the number of tiles that changed in the last frame
+    int getNumDirtyTiles() const {return m_numDirtyTiles;}
+
+    //! Returns whether the whole mask was traced in the last frame
+    bool isFullScan() const {return m_fullScan;}
+
+private:
+
+    //! Thresholds the image into the mask like the contour finder of ofxCv does
+    void threshold(cv::Mat img);
+
+    //! Hashes every tile of the mask, marking the ones that changed. Returns the number of dirty tiles
+    int hashTiles();
+
+    //! Returns whether the bounding box of a component, grown by a pixel, touches a dirty tile
+    bool isDirty(const cv::Rect& box) const;
+
+    //! Traces the components within the region. Outside a full scan, only the dirty ones are added to the kept ones
+    void trace(const cv::Rect& region, bool full);
+
+    //! Keeps the contours within the area limits, then tracks their bounding boxes
+    void select(int imageArea);
+
+private:
+
+    bool                        m_incremental;      ///< whether to retrace only the dirty tiles
+    float                       m_maxDirtyTiles;    ///< fraction of dirty tiles above which the whole mask is traced
+
+    int                         m_numTilesX;        ///< tiles on a row
+    vector<uint64_t>            m_hashes;           ///< hash of every tile of the last frame
+    vector<char>                m_dirty;            ///< whether every tile changed
+    int                         m_numDirtyTiles;    ///< tiles that changed in the last frame
+    bool                        m_fullScan;         ///< whether the whole mask was traced in the last frame
+    bool                        m_valid;            ///< whether the traced contours belong to the last frame
+
+    vector<vector<cv::Point> >  m_traced;           ///< contours of every component, before the area limits
+    vector<int>                 m_starts;           ///< order every contour is found in: twice the pixel index its tracing starts at, plus one for a hole
+    vector<cv::Rect>            m_components;       ///< bounding box of the component of every contour
+
+    vector<vector<cv::Point> >  m_found;            ///< contours found in the region traced
+    vector<cv::Vec4i>           m_hierarchy;        ///< parent of the holes found in the region traced
+    vector<cv::Rect>            m_foundComponents;  ///< bounding box of every contour found in the region traced
+    vector<vector<cv::Point> >  m_merged;           ///< contours kept and found, before they are ordered
+    vector<int>                 m_mergedStarts;     ///< order the contours kept and found are found in
+    vector<cv::Rect>            m_mergedComponents; ///< components of the contours kept and found
+    vector<int>                 m_order;            ///< indices of the contours kept and found, in order
+    vector<double>              m_areas;            ///< area of every traced contour, when it is needed
+    vector<size_t>              m_indices;          ///< indices of the contours within the area limits, in order
+};
+
+//==========================================================================
+
+
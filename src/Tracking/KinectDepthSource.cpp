@@ -0,0 +1,71 @@
+/*
+ *  KinectDepthSource.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "KinectDepthSource.h"
+
+
+const int KinectDepthSource::WIDTH = 512;
+const int KinectDepthSource::HEIGHT = 424;
+
+
+KinectDepthSource::KinectDepthSource(): m_open(false), m_frameNew(false), m_timestamp(0)
+{
+    //Intentionally left empty
+}
+
+
+KinectDepthSource::~KinectDepthSource()
+{
+    this->close();
+}
+
+
+bool KinectDepthSource::open()
+{
+    m_kinect.open(true, true, 0, 2);
+    m_kinect.start();
+    
+    // Note :
+    // Default OpenCL device might not be optimal.
+    // e.g. Intel HD Graphics will be chosen instead of GeForce.
+    // To avoid it, specify OpenCL device index manually like following.
+    // m_kinect.open(true, true, 0, 1); // GeForce on MacBookPro Retina
+    
+    // the addon only starts its capture thread once the device is open, a missing Kinect leaves it stopped
+    if(!m_kinect.isThreadRunning()){
+        ofLogError() <<"KinectDepthSource::open -> no Kinect found";
+        return false;
+    }
+    
+    m_open = true;
+    ofLogNotice() <<"KinectDepthSource::open";
+    return true;
+}
+
+void KinectDepthSource::close()
+{
+    if(!m_open){
+        return;
+    }
+    
+    m_kinect.close();
+    m_open = false;
+    m_frameNew = false;
+    
+    ofLogNotice() <<"KinectDepthSource::close";
+}
+
+void KinectDepthSource::update()
+{
+    m_kinect.update();
+    m_frameNew = m_kinect.isFrameNew();
+    if(m_frameNew){
+        m_timestamp = ofGetSystemTimeMicros();
+    }
+}
+
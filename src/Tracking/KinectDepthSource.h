@@ -0,0 +1,65 @@
+/*
+ *  KinectDepthSource.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxMultiKinectV2.h"
+#include "DepthSource.h"
+
+
+//========================== class KinectDepthSource ==============================
+//============================================================================
+/** \class KinectDepthSource KinectDepthSource.h
+ *	\brief Takes the depth frames of a Microsoft Kinect v2
+ */
+
+class KinectDepthSource: public DepthSource
+{
+
+public:
+
+    static const int WIDTH;
+    static const int HEIGHT;
+
+    //! Constructor
+    KinectDepthSource();
+
+    //! Destructor
+    ~KinectDepthSource();
+
+    //! Opens the first Kinect and starts capturing
+    bool open();
+
+    void close();
+
+    void update();
+
+    bool isFrameNew() const {return m_frameNew;}
+
+    const ofFloatPixels& getPixels() const {return m_kinect.getDepthPixelsRef();}
+
+    unsigned long long getTimestamp() const {return m_timestamp;}
+
+    int getWidth() const {return WIDTH;}
+
+    int getHeight() const {return HEIGHT;}
+
+    int getType() const {return KINECT;}
+
+private:
+
+    mutable ofxMultiKinectV2    m_kinect;           ///< Mircrosoft Kinect v2 class
+    bool                        m_open;             ///< whether the Kinect is capturing
+    bool                        m_frameNew;         ///< whether the last update got a new frame
+    unsigned long long          m_timestamp;        ///< time the current frame was taken, in microseconds since the epoch
+};
+
+//==========================================================================
+
+
@@ -0,0 +1,230 @@
+/*
+ *  SyntheticDepthSource.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "SyntheticDepthSource.h"
+
+
+const float SyntheticDepthSource::FLOOR_DEPTH = 4000;
+const float SyntheticDepthSource::PERSON_RADIUS = 20;
+const float SyntheticDepthSource::WALKING_SPEED = 120;
+const int SyntheticDepthSource::QUEUE_CAPACITY = 2;
+
+
+SyntheticDepthSource::SyntheticDepthSource(): m_queue(QUEUE_CAPACITY), m_frame(&m_emptyFrame), m_frameNew(false), m_width(0), m_height(0),
+    m_scale(1), m_numPeople(20), m_frameRate(30), m_noise(8), m_dropout(0.01), m_random(2463534242u)
+{
+    m_emptyFrame.timestamp = 0;
+}
+
+
+SyntheticDepthSource::~SyntheticDepthSource()
+{
+    this->close();
+}
+
+
+bool SyntheticDepthSource::open(int width, int height)
+{
+    this->close();
+    
+    m_width = width;
+    m_height = height;
+    m_scale = width/512.0f;
+    m_emptyFrame.pixels.allocate(width, height, 1);
+    m_emptyFrame.pixels.set(0);
+    m_frame = &m_emptyFrame;
+    m_people.clear();
+    
+    startThread();
+    
+    ofLogNotice() <<"SyntheticDepthSource::open -> " << m_numPeople.load(std::memory_order_relaxed) << " people in " << width << "x" << height << " at " << m_frameRate.load(std::memory_order_relaxed) << " fps";
+    return true;
+}
+
+void SyntheticDepthSource::close()
+{
+    if(!isThreadRunning()){
+        return;
+    }
+    
+    stopThread();
+    m_signal.notify();
+    waitForThread(false);
+    m_frameNew = false;
+    
+    ofLogNotice() <<"SyntheticDepthSource::close";
+}
+
+void SyntheticDepthSource::update()
+{
+    // taking a frame gives the previous one back, so there is nothing to show until the next one
+    SyntheticDepthFrame* frame = m_queue.pop();
+    m_frameNew = (frame != NULL);
+    m_frame = m_frameNew ? frame : &m_emptyFrame;
+}
+
+void SyntheticDepthSource::threadedFunction()
+{
+    unsigned long long nextTime = ofGetElapsedTimeMicros();
+    
+    while(isThreadRunning())
+    {
+        unsigned long long time = ofGetElapsedTimeMicros();
+        if(time < nextTime){
+            m_signal.waitUntil(std::chrono::steady_clock::now() + std::chrono::microseconds(nextTime - time));
+            continue;
+        }
+        
+        // the crowd moves on by a frame period whatever the time generating it took, without catching up in bursts
+        float period = 1.0f/m_frameRate.load(std::memory_order_relaxed);
+        nextTime = max(nextTime + (unsigned long long)(period*1000000), time);
+        
+        this->updateCrowd();
+        this->walk(period);
+        
+        SyntheticDepthFrame& frame = m_queue.getWriteFrame();
+        this->render(frame.pixels);
+        frame.timestamp = ofGetSystemTimeMicros();
+        m_queue.push();
+    }
+}
+
+void SyntheticDepthSource::updateCrowd()
+{
+    int numPeople = m_numPeople.load(std::memory_order_relaxed);
+    if(m_people.size() > numPeople){
+        m_people.resize(numPeople);
+    }
+    
+    while(m_people.size() < numPeople)
+    {
+        Person person;
+        person.position.set(this->random()*m_width, this->random()*m_height);
+        person.radius = PERSON_RADIUS*m_scale*(0.8 + 0.4*this->random());
+        person.height = 1500 + 400*this->random();
+        person.speed = WALKING_SPEED*m_scale*(0.7 + 0.6*this->random());
+        m_people.push_back(person);
+        this->chooseTarget(m_people.size() - 1);
+    }
+}
+
+void SyntheticDepthSource::chooseTarget(int i)
+{
+    Person& person = m_people[i];
+    
+    // now and then somebody walks with somebody else for a while, their blobs merge until they part
+    if(m_people.size() > 1 && this->random() < 0.3){
+        int other = this->random()*(m_people.size() - 1);
+        person.following = (other >= i) ? other + 1 : other;
+        person.time = 3 + 5*this->random();
+    }
+    else{
+        person.following = -1;
+        person.target.set(this->random()*m_width, this->random()*m_height);
+        person.time = 5 + 10*this->random();
+    }
+}
+
+void SyntheticDepthSource::walk(float elapsedTime)
+{
+    for(int i = 0; i < m_people.size(); i++)
+    {
+        Person& person = m_people[i];
+        person.time -= elapsedTime;
+        if(person.time <= 0 || person.following >= (int) m_people.size()){
+            this->chooseTarget(i);
+        }
+        
+        // somebody walking with somebody else stops at their side, close enough to touch
+        ofVec2f target = (person.following >= 0) ? m_people[person.following].position : person.target;
+        float stop = (person.following >= 0) ? person.radius : 0;
+        ofVec2f direction = target - person.position;
+        float distance = direction.length();
+        
+        if(distance > stop){
+            float step = min(person.speed*elapsedTime, distance - stop);
+            person.position += direction*(step/distance);
+        }
+        else if(person.following < 0){
+            this->chooseTarget(i);
+        }
+    }
+}
+
+void SyntheticDepthSource::render(ofFloatPixels& pixels)
+{
+    if(pixels.getWidth() != m_width || pixels.getHeight() != m_height){
+        pixels.allocate(m_width, m_height, 1);
+    }
+    
+    float* depth = pixels.getPixels();
+    
+    // the floor slopes away from the sensor
+    for(int y = 0; y < m_height; y++) {
+        float floor = FLOOR_DEPTH + 400*(float(y)/m_height - 0.5f);
+        std::fill(depth + y*m_width, depth + (y + 1)*m_width, floor);
+    }
+    
+    // the closest surface wins where people touch, the edges drop out more often
+    float dropout = m_dropout.load(std::memory_order_relaxed);
+    float edgeDropout = min(3*dropout, 1.0f);
+    for(int i = 0; i < m_people.size(); i++)
+    {
+        const Person& person = m_people[i];
+        float r2 = person.radius*person.radius;
+        int left = max(int(person.position.x - person.radius), 0);
+        int right = min(int(person.position.x + person.radius) + 1, m_width);
+        int top = max(int(person.position.y - person.radius), 0);
+        int bottom = min(int(person.position.y + person.radius) + 1, m_height);
+        
+        for(int y = top; y < bottom; y++) {
+            float floor = FLOOR_DEPTH + 400*(float(y)/m_height - 0.5f);
+            float dy = y - person.position.y;
+            for(int x = left; x < right; x++) {
+                float dx = x - person.position.x;
+                float d2 = dx*dx + dy*dy;
+                if(d2 >= r2){
+                    continue;
+                }
+                
+                float& value = depth[y*m_width + x];
+                if(d2 > 0.8f*r2 && this->random() < edgeDropout){
+                    value = 0;
+                    continue;
+                }
+                
+                float z = floor - person.height*sqrt(1 - d2/r2);
+                if(z < value){
+                    value = z;
+                }
+            }
+        }
+    }
+    
+    // triangular noise of the asked standard deviation, zeros stay dropped out
+    float noise = m_noise.load(std::memory_order_relaxed)*2.449f;
+    for(int i = 0; i < m_width*m_height; i++) {
+        if(depth[i] == 0){
+            continue;
+        }
+        if(this->random() < dropout){
+            depth[i] = 0;
+            continue;
+        }
+        depth[i] += (this->random() + this->random() - 1)*noise;
+    }
+}
+
+float SyntheticDepthSource::random()
+{
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return (m_random >> 8)*(1.0f/16777216);
+}
+
@@ -0,0 +1,143 @@
+/*
+ *  SyntheticDepthSource.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+#include "FrameQueue.h"
+#include "DepthSource.h"
+#include "ThreadSignal.h"
+
+
+//========================== struct SyntheticDepthFrame ==============================
+//============================================================================
+/** \struct SyntheticDepthFrame SyntheticDepthSource.h
+ *	\brief A generated depth frame waiting to be taken
+ */
+
+struct SyntheticDepthFrame
+{
+    ofFloatPixels           pixels;             ///< depth in millimetres
+    unsigned long long      timestamp;          ///< time it was generated, in microseconds since the epoch
+};
+
+
+//========================== class SyntheticDepthSource ==============================
+//============================================================================
+/** \class SyntheticDepthSource SyntheticDepthSource.h
+ *	\brief Generates the depth of a crowd walking over the floor, to load test the tracking
+ *	\details A thread simulates the people seen from above and renders them at the
+ *    configured rate. Everyone walks towards a target: a random point, or for a while
+ *    somebody else, so people meet, walk together as one blob and split again. A person
+ *    is a dome rising from the floor; every pixel gets sensor noise, and some pixels
+ *    drop out to zero like the invalid pixels of the sensor, more of them around the
+ *    edges of the people. The number of people and the noise can change while it runs.
+ */
+
+class SyntheticDepthSource: public ofThread, public DepthSource
+{
+
+public:
+
+    static const float FLOOR_DEPTH;         ///< distance from the sensor to the floor, in millimetres
+    static const float PERSON_RADIUS;       ///< mean radius of a person at scale 1, in pixels
+    static const float WALKING_SPEED;       ///< mean walking speed at scale 1, in pixels per second
+    static const int QUEUE_CAPACITY;
+
+    //! Constructor
+    SyntheticDepthSource();
+
+    //! Destructor
+    ~SyntheticDepthSource();
+
+    //! Starts generating frames of the given size
+    bool open(int width, int height);
+
+    void close();
+
+    void update();
+
+    bool isFrameNew() const {return m_frameNew;}
+
+    const ofFloatPixels& getPixels() const {return m_frame->pixels;}
+
+    unsigned long long getTimestamp() const {return m_frame->timestamp;}
+
+    int getWidth() const {return m_width;}
+
+    int getHeight() const {return m_height;}
+
+    int getType() const {return SYNTHETIC;}
+
+    //! Sets the number of people walking around
+    void setNumPeople(int value) {m_numPeople.store(max(value, 0), std::memory_order_relaxed);}
+
+    //! Sets the frames generated per second
+    void setFrameRate(float value) {m_frameRate.store(max(value, 1.0f), std::memory_order_relaxed); m_signal.notify();}
+
+    //! Sets the standard deviation of the sensor noise, in millimetres
+    void setNoise(float value) {m_noise.store(max(value, 0.0f), std::memory_order_relaxed);}
+
+    //! Sets the fraction of the pixels that drop out
+    void setDropout(float value) {m_dropout.store(ofClamp(value, 0.0, 1.0), std::memory_order_relaxed);}
+
+private:
+
+    //! Someone walking around
+    struct Person
+    {
+        ofVec2f     position;       ///< centre, in pixels
+        ofVec2f     target;         ///< point walked to
+        int         following;      ///< person walked with, -1 if none
+        float       radius;         ///< radius, in pixels
+        float       height;         ///< height, in millimetres
+        float       speed;          ///< walking speed, in pixels per second
+        float       time;           ///< seconds left until the next target is chosen
+    };
+
+    void threadedFunction();
+
+    //! Adds or removes people to match the number asked for
+    void updateCrowd();
+
+    //! Moves everybody on by the given time
+    void walk(float elapsedTime);
+
+    //! Chooses where somebody walks next
+    void chooseTarget(int i);
+
+    //! Renders the floor, the people, the noise and the dropout
+    void render(ofFloatPixels& pixels);
+
+    //! Returns a random number in [0, 1) from the generator of the thread
+    float random();
+
+private:
+
+    FrameQueue<SyntheticDepthFrame>     m_queue;            ///< generated frames waiting to be taken
+    SyntheticDepthFrame*                m_frame;            ///< current frame
+    SyntheticDepthFrame                 m_emptyFrame;       ///< frame shown before the first one is generated
+    bool                                m_frameNew;         ///< whether the last update took a new frame
+    int                                 m_width;            ///< width of the frames in pixels
+    int                                 m_height;           ///< height of the frames in pixels
+    float                               m_scale;            ///< size of the frames relative to the sensor's
+
+    std::atomic<int>                    m_numPeople;        ///< number of people asked for
+    std::atomic<float>                  m_frameRate;        ///< frames generated per second
+    std::atomic<float>                  m_noise;            ///< standard deviation of the noise, in millimetres
+    std::atomic<float>                  m_dropout;          ///< fraction of the pixels dropping out
+
+    vector<Person>                      m_people;           ///< crowd, only touched by the thread
+    unsigned int                        m_random;           ///< state of the xorshift generator of the thread
+    ThreadSignal                        m_signal;           ///< wakes the thread before the next frame is due, to stop or change the rate
+};
+
+//==========================================================================
+
+
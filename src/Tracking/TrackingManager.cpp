@@ -6,9 +6,14 @@
  *
  */
 
+#include <cassert>
+
 #include "AppManager.h"
 
 #include "TrackingManager.h"
+#include "KinectDepthSource.h"
+#include "WebCameraDepthSource.h"
+#include "AllocationCounter.h"
 
 using namespace ofxCv;
 using namespace cv;
@@ -41,12 +46,29 @@ const int TrackingManager::DEPTH_CAMERA_WIDTH = 512;
 const int TrackingManager::DEPTH_CAMERA_HEIGHT = 424;
 const float TrackingManager::SCALE = 1.35;
 const int TrackingManager::TRACKING_PERSISTANCY = 5*30;
+const int TrackingManager::TRACKING_DISTANCE = 64;
 const int TrackingManager::LEARNING_TIME = 10*30;
+const int TrackingManager::QUEUE_CAPACITY = 2;
+const int TrackingManager::STEADY_STATE_FRAMES = 30;
+const int TrackingManager::IDLE_FRAMES = 30;
+const int TrackingManager::PRESENCE_STEP = 4;
+const string TrackingManager::RECORDINGS_FOLDER = "recordings/";
 
 
 TrackingManager::TrackingManager(): Manager(), m_threshold(80), m_contourMinArea(50), m_contourMaxArea(1000), m_thresholdBackground(10), m_substractBackground(true),
 m_depthNearClipping(0.0), m_depthFarClipping(5000.0), m_blurScale(0.0), m_blurRotation(0.0), m_simplifyTolerance(0.0), m_smoothingShape(0.0),m_smoothingSize(0.0),
-m_sendAllContours(false),m_cropLeft(0), m_cropRight(0), m_cropTop(0), m_cropBottom(0)
+m_sendAllContours(false),m_cropLeft(0), m_cropRight(0), m_cropTop(0), m_cropBottom(0), m_useVertexBudget(false),
+m_packetBytes(OscManager::MAX_PACKET_SIZE), m_frameBytes(16384), m_useSendBudget(false), m_maxVertices(4096), m_maxContours(16),
+m_captureTime(0), m_drawFourierDescriptors(false), m_useFourierDescriptors(false), m_fourierCoefficients(16),
+m_depthQueue(QUEUE_CAPACITY), m_maskQueue(QUEUE_CAPACITY), m_contourQueue(QUEUE_CAPACITY), m_emitQueue(QUEUE_CAPACITY), m_drawQueue(1),
+m_segmentThread(TrackingStageThread::SEGMENT), m_contourThread(TrackingStageThread::CONTOURS),
+m_postProcessThread(TrackingStageThread::POST_PROCESS), m_emitThread(TrackingStageThread::EMIT),
+m_resetBackground(false), m_resetBudget(false), m_lossless(false), m_sourceType(DepthSource::KINECT), m_syntheticPeople(20),
+m_syntheticFrameRate(30), m_syntheticNoise(8), m_syntheticDropout(0.01), m_numSteadyFrames(0),
+m_resetSteadyState(false), m_useIdleMode(true), m_idleFrameRate(0),
+m_numAbsentFrames(0), m_numSkippedFrames(0), m_lastFrameTime(0), m_emittedIdle(false), m_pyramidLevels(0),
+m_pyramidRefine(true), m_segmentScale(1), m_contourScale(1), m_incrementalContours(false), m_incrementalMaxDirty(25),
+m_useBitMask(false), m_maskOpen(1), m_maskClose(1), m_maskShape(StructuringElement::ELLIPSE)
 {
     //Intentionally left empty
 }
@@ -54,6 +76,7 @@ m_sendAllContours(false),m_cropLeft(0), m_cropRight(0), m_cropTop(0), m_cropBott
 
 TrackingManager::~TrackingManager()
 {
+    this->stop();
     ofLogNotice() <<"TrackingManager::Destructor";
 }
 
@@ -70,30 +93,117 @@ void TrackingManager::setup()
     this->setupCamera();
     this->setupFbos();
     this->setupContourTracking();
+    this->setupPipeline();
 }
 
 void TrackingManager::setupContourTracking()
 {
-    m_contourFinder.setMinAreaRadius(m_contourMinArea);
-    m_contourFinder.setMaxAreaRadius(m_contourMaxArea);
     m_contourFinder.setTargetColor(ofColor::white, TRACK_COLOR_RGB);
-    m_contourFinder.setThreshold(m_threshold);
+    m_contourFinder.setThreshold(m_threshold.load(std::memory_order_relaxed));
     m_contourFinder.getTracker().setPersistence(TRACKING_PERSISTANCY);
     m_contourFinder.setFindHoles(true);
-    //m_contourFinder.getTracker().setMaximumDistance(32);
+    m_contourFinder.setBuildPolylines(false);
+    this->setContourScale(m_contourScale);
+    m_contourPyramid.setThresholds(m_thresholdBackground.load(std::memory_order_relaxed), m_threshold.load(std::memory_order_relaxed));
     
     m_background.setLearningTime(LEARNING_TIME);
-    m_background.setThresholdValue(m_threshold);
+    m_background.setThresholdValue(m_threshold.load(std::memory_order_relaxed));
     m_background.reset();
 }
 
+void TrackingManager::setupPipeline()
+{
+    // a stage sleeps until the queue before it has a frame or, when lossless, the queue after it has room
+    m_depthQueue.setPushSignal(m_segmentThread.getSignal());
+    m_maskQueue.setPushSignal(m_contourThread.getSignal());
+    m_maskQueue.setPopSignal(m_segmentThread.getSignal());
+    m_contourQueue.setPushSignal(m_postProcessThread.getSignal());
+    m_contourQueue.setPopSignal(m_contourThread.getSignal());
+    m_emitQueue.setPushSignal(m_emitThread.getSignal());
+    m_emitQueue.setPopSignal(m_postProcessThread.getSignal());
+    
+    m_segmentThread.start(this);
+    m_contourThread.start(this);
+    m_postProcessThread.start(this);
+    m_emitThread.start(this);
+}
+
+void TrackingManager::stop()
+{
+    m_segmentThread.stop();
+    m_contourThread.stop();
+    m_postProcessThread.stop();
+    m_emitThread.stop();
+}
+
 void TrackingManager::setupCamera()
 {
-    #ifdef KINECT_CAMERA
-        this->setupKinectCamera();
-    #else
-        this->setupWebCamera();
-    #endif
+    m_depthShader.setupShaderFromSource(GL_FRAGMENT_SHADER, m_depthFragmentShader);
+    m_depthShader.linkProgram();
+    
+    // a benchmark replays a recording, the build box has no Kinect
+    if(AppManager::getInstance().getBenchmarkManager().isEnabled()){
+        return;
+    }
+    
+    this->setSource(m_sourceType);
+}
+
+bool TrackingManager::setSource(int type)
+{
+    if(m_source){
+        m_source->close();
+    }
+    
+    m_source.reset();
+    m_depthPlayer.reset();
+    m_syntheticSource.reset();
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+    
+    switch(type)
+    {
+        case DepthSource::KINECT:
+        {
+            ofPtr<KinectDepthSource> kinect(new KinectDepthSource());
+            if(kinect->open()){
+                m_source = kinect;
+            }
+            break;
+        }
+            
+        case DepthSource::WEB_CAMERA:
+        {
+            ofPtr<WebCameraDepthSource> camera(new WebCameraDepthSource());
+            if(camera->open(DEPTH_CAMERA_WIDTH, DEPTH_CAMERA_HEIGHT)){
+                m_source = camera;
+            }
+            break;
+        }
+            
+        case DepthSource::SYNTHETIC:
+        {
+            m_syntheticSource = ofPtr<SyntheticDepthSource>(new SyntheticDepthSource());
+            m_syntheticSource->setNumPeople(m_syntheticPeople);
+            m_syntheticSource->setFrameRate(m_syntheticFrameRate);
+            m_syntheticSource->setNoise(m_syntheticNoise);
+            m_syntheticSource->setDropout(m_syntheticDropout);
+            m_syntheticSource->open(DEPTH_CAMERA_WIDTH, DEPTH_CAMERA_HEIGHT);
+            m_source = m_syntheticSource;
+            break;
+        }
+            
+        default:
+            ofLogWarning() <<"TrackingManager::setSource -> the " << DepthSource::getTypeName(type) << " can't be chosen as a source";
+            return false;
+    }
+    
+    if(!m_source){
+        ofLogError() <<"TrackingManager::setSource -> unable to open the " << DepthSource::getTypeName(type);
+        return false;
+    }
+    
+    ofLogNotice() <<"TrackingManager::setSource -> taking the depth from the " << DepthSource::getTypeName(type);
+    return true;
 }
 
 void TrackingManager::setupFbos()
@@ -113,178 +223,555 @@ void TrackingManager::setupFbos()
 
 }
 
-void TrackingManager::setupKinectCamera()
+void TrackingManager::update()
 {
-    m_depthShader.setupShaderFromSource(GL_FRAGMENT_SHADER, m_depthFragmentShader);
-    m_depthShader.linkProgram();
+    this->updateCamera();
+    this->updateContours();
+}
+
+void TrackingManager::updateCamera()
+{
+    if(!m_source){
+        return;
+    }
     
-    m_kinect.open(true, true, 0, 2);
-    m_kinect.start();
+    ProfilerManager& profiler = AppManager::getInstance().getProfilerManager();
+    bool frameNew = false;
     
-    // Note :
-    // Default OpenCL device might not be optimal.
-    // e.g. Intel HD Graphics will be chosen instead of GeForce.
-    // To avoid it, specify OpenCL device index manually like following.
-    // m_kinect.open(true, true, 0, 1); // GeForce on MacBookPro Retina
+    {
+        ProfileScope scope(profiler, ProfilerManager::STAGE_CAPTURE);
+        if(this->isLossless()){
+            frameNew = !m_depthQueue.isFull() && m_source->nextFrame();
+        }
+        else{
+            m_source->update();
+            frameNew = m_source->isFrameNew();
+        }
+    }
+    
+    if (frameNew) {
+        const ofFloatPixels& depth = m_source->getPixels();
+        m_captureTime = m_source->getTimestamp();
+        
+        if(m_source->getType() != DepthSource::RECORDING){
+            m_depthRecorder.addFrame(depth, m_captureTime);
+        }
+        
+        {
+            ProfileScope scope(profiler, ProfilerManager::STAGE_UPLOAD);
+            
+            // the sources don't all give frames of the same size, the clipping scales them to the fbo
+            if(m_depthTexture.isAllocated() && (m_depthTexture.getWidth() != depth.getWidth() || m_depthTexture.getHeight() != depth.getHeight())){
+                m_depthTexture.clear();
+            }
+            m_depthTexture.loadData(depth);
+        }
+    
+        if (m_depthTexture.isAllocated()) {
+            {
+                ProfileScope scope(profiler, ProfilerManager::STAGE_CLIP);
+                m_depthFbo.begin();
+                m_depthShader.begin();
+                m_depthShader.setUniform1f("nearClipping", m_depthNearClipping);
+                m_depthShader.setUniform1f("farClipping", m_depthFarClipping);
+                m_depthTexture.draw(0, 0, DEPTH_CAMERA_WIDTH, DEPTH_CAMERA_HEIGHT);
+                m_depthShader.end();
+                this->drawCrop();
+                m_depthFbo.end();
+            }
+            
+            // the morphology of the bit-packed mask removes the noise the blur would
+            if(this->getBitMask()){
+                this->readDepth(m_depthFbo);
+            }
+            else{
+                this->blurDepth();
+                this->readDepth(m_blurredFbo);
+            }
+        }
+    }
 }
 
-void TrackingManager::setupWebCamera()
+void TrackingManager::drawCrop()
 {
-    m_vidGrabber.setDeviceID(0);
-    //m_vidGrabber.setDesiredFrameRate(60);
-    m_vidGrabber.initGrabber(DEPTH_CAMERA_WIDTH, DEPTH_CAMERA_HEIGHT);
+    ofPushStyle();
+    ofSetColor(0);
+    ofFill();
+    ofRect(0,0,m_cropLeft,DEPTH_CAMERA_HEIGHT);
+    ofRect(0,0,DEPTH_CAMERA_WIDTH,m_cropTop);
+    ofRect(DEPTH_CAMERA_WIDTH-m_cropRight,0, m_cropRight, DEPTH_CAMERA_HEIGHT);
+    ofRect(0,DEPTH_CAMERA_HEIGHT-m_cropBottom,DEPTH_CAMERA_WIDTH,m_cropBottom);
+    ofPopStyle();
 }
 
-
-void TrackingManager::update()
+void TrackingManager::blurDepth()
 {
-    this->updateCamera();
-    this->updateContourTracking();
+    ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_BLUR);
+    
+    m_blur.begin();
+        m_depthFbo.draw(0,0);
+    m_blur.end();
+    
+    m_blurredFbo.begin();
+        m_blur.draw();
+    m_blurredFbo.end();
 }
 
-void TrackingManager::updateCamera()
+void TrackingManager::readDepth(ofFbo& fbo)
 {
-    #ifdef KINECT_CAMERA
-        this->updateKinectCamera();
-    #else
-        this->updateWebCamera();
-    #endif
+    ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_READ_PIXELS);
+    
+    AllocationScope allocations;
+    
+    TrackingImage& depth = m_depthQueue.getWriteFrame();
+    fbo.readToPixels(depth.pixels);
+    depth.timestamp = m_captureTime;
+    depth.numFrames = 1;
+    depth.numAllocations = allocations.getNumAllocations();
+    depth.numBytes = allocations.getNumBytes();
+    m_depthQueue.push();
 }
 
-void TrackingManager::updateKinectCamera()
+void TrackingManager::updateContours()
 {
-    m_kinect.update();
-    if (m_kinect.isFrameNew()) {
-        m_depthTexture.loadData(m_kinect.getDepthPixelsRef());
+    TrackingContours* frame = m_drawQueue.pop();
+    if(!frame){
+        return;
+    }
     
-        if (m_depthTexture.isAllocated()) {
-            m_depthFbo.begin();
-            m_depthShader.begin();
-            m_depthShader.setUniform1f("nearClipping", m_depthNearClipping);
-            m_depthShader.setUniform1f("farClipping", m_depthFarClipping);
-            m_depthTexture.draw(0, 0, DEPTH_CAMERA_WIDTH, DEPTH_CAMERA_HEIGHT);
-            m_depthShader.end();
-            
-            ofPushStyle();
-            ofSetColor(0);
-            ofFill();
-            ofRect(0,0,m_cropLeft,DEPTH_CAMERA_HEIGHT);
-            ofRect(0,0,DEPTH_CAMERA_WIDTH,m_cropTop);
-            ofRect(DEPTH_CAMERA_WIDTH-m_cropRight,0, m_cropRight, DEPTH_CAMERA_HEIGHT);
-            ofRect(0,DEPTH_CAMERA_HEIGHT-m_cropBottom,DEPTH_CAMERA_WIDTH,m_cropBottom);
-            ofPopStyle();
+    m_contourSet.copyFrom(frame->contours);
+    m_fourierDescriptors.copyFrom(frame->descriptors);
+    m_drawFourierDescriptors = frame->fourier;
+}
 
-            
-            m_depthFbo.end();
-            
-            m_blur.begin();
-                m_depthFbo.draw(0,0);
-            m_blur.end();
-            
-            m_blurredFbo.begin();
-                m_blur.draw();
-            m_blurredFbo.end();
-        }
+bool TrackingManager::processStage(int stage)
+{
+    switch(stage)
+    {
+        case TrackingStageThread::SEGMENT:      return this->segmentFrame();
+        case TrackingStageThread::CONTOURS:     return this->traceFrame();
+        case TrackingStageThread::POST_PROCESS: return this->postProcessFrame();
+        case TrackingStageThread::EMIT:         return this->emitFrame();
+        default:                                return false;
     }
 }
 
+bool TrackingManager::segmentFrame()
+{
+    if(this->isLossless() && m_maskQueue.isFull()){
+        return false;
+    }
+    
+    TrackingImage* depth = m_depthQueue.pop();
+    if(!depth){
+        return false;
+    }
+    
+    AllocationScope allocations;
+    
+    bool substractBackground = m_substractBackground.load(std::memory_order_relaxed);
+    
+    // the background learnt at another decimation doesn't fit the frame anymore
+    int scale = 1 << this->getPyramidLevels();
+    if(m_resetBackground.exchange(false, std::memory_order_relaxed) || scale != m_segmentScale){
+        m_segmentScale = scale;
+        m_background.reset();
+    }
+    
+    TrackingImage& mask = m_maskQueue.getWriteFrame();
+    mask.timestamp = depth->timestamp;
+    mask.scale = scale;
+    mask.refine = scale > 1 && this->getPyramidRefine();
+    mask.packed = this->getBitMask();
+    
+    ofPixels* pixels = &depth->pixels;
+    if(scale > 1){
+        ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_DECIMATE);
+        ContourPyramid::decimate(depth->pixels, m_decimatedDepth, scale);
+        pixels = &m_decimatedDepth;
+    }
+    
+    if(substractBackground){
+        ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_BACKGROUND);
+        m_background.setThresholdValue(m_thresholdBackground.load(std::memory_order_relaxed));
+        m_background.update(*pixels, mask.packed ? m_foreground : mask.pixels);
+    }
+    else if(!mask.packed){
+        mask.pixels = *pixels;
+    }
+    
+    if(mask.packed){
+        this->filterMask(substractBackground ? m_foreground : *pixels, mask.bits, scale);
+    }
+    
+    if(mask.refine){
+        mask.depth = depth->pixels;
+        if(substractBackground){
+            const cv::Mat& background = m_background.getBackground();
+            if(mask.background.getWidth() != background.cols || mask.background.getHeight() != background.rows){
+                mask.background.allocate(background.cols, background.rows, background.channels());
+            }
+            cv::Mat copy = toCv(mask.background);
+            background.copyTo(copy);
+        }
+        else{
+            mask.background.clear();
+        }
+    }
+    
+    // idle after a while without anything as large as the smallest contour, awake as soon as there is
+    bool present = mask.packed ? this->isPresent(mask.bits, scale) : this->isPresent(mask.pixels, scale);
+    if(present){
+        m_numAbsentFrames = 0;
+    }
+    else{
+        m_numAbsentFrames = min(m_numAbsentFrames + 1, IDLE_FRAMES);
+    }
+    
+    mask.idle = m_useIdleMode.load(std::memory_order_relaxed) && m_numAbsentFrames >= IDLE_FRAMES;
+    
+    // every frame is checked for presence and learnt by the background, only the later stages slow down while idle
+    if(mask.idle && this->skipIdleFrame()){
+        m_numSkippedFrames++;
+        return true;
+    }
+    
+    mask.numFrames = m_numSkippedFrames + 1;
+    m_numSkippedFrames = 0;
+    
+    mask.numAllocations = depth->numAllocations + allocations.getNumAllocations();
+    mask.numBytes = depth->numBytes + allocations.getNumBytes();
+    m_maskQueue.push();
+    return true;
+}
 
-void TrackingManager::updateWebCamera()
+bool TrackingManager::traceFrame()
 {
+    if(this->isLossless() && m_contourQueue.isFull()){
+        return false;
+    }
     
-    m_vidGrabber.update();
-    if (m_vidGrabber.isFrameNew()) {
-        m_depthTexture.loadData(m_vidGrabber.getPixelsRef());
+    TrackingImage* mask = m_maskQueue.pop();
+    if(!mask){
+        return false;
+    }
+    
+    RectTracker& tracker = m_contourFinder.getTracker();
+    
+    // the frames skipped while idle had nobody in them, so the lost objects are forgotten after the same time
+    for(int i = 1; i < mask->numFrames; i++) {
+        tracker.track(m_noObjects);
+    }
+    
+    if(mask->scale != m_contourScale){
+        this->setContourScale(mask->scale);
+    }
+    
+    this->applyContourSettings();
+    
+    if(mask->idle){
+        tracker.track(m_noObjects);
+    }
+    else{
+        ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_FIND_CONTOURS);
         
-        if (m_depthTexture.isAllocated()) {
-            m_depthFbo.begin();
-            
-                m_depthTexture.draw(0, 0, DEPTH_CAMERA_WIDTH, DEPTH_CAMERA_HEIGHT);
-                
-                ofPushStyle();
-                ofSetColor(0);
-                ofFill();
-                ofRect(0,0,m_cropLeft,DEPTH_CAMERA_HEIGHT);
-                ofRect(0,0,DEPTH_CAMERA_WIDTH,m_cropTop);
-                ofRect(DEPTH_CAMERA_WIDTH-m_cropRight,0, m_cropRight, DEPTH_CAMERA_HEIGHT);
-                ofRect(0,DEPTH_CAMERA_HEIGHT-m_cropBottom,DEPTH_CAMERA_WIDTH,m_cropBottom);
-                ofPopStyle();
-            
-            m_depthFbo.end();
-            
-            m_blur.begin();
-            m_depthFbo.draw(0,0);
-            m_blur.end();
-            
-            m_blurredFbo.begin();
-            m_blur.draw();
-            m_blurredFbo.end();
+        // OpenCV traces 8-bit masks only, the bits are unpacked a run at a time
+        if(mask->packed){
+            mask->bits.unpack(m_unpackedMask);
+            m_contourFinder.findContours(m_unpackedMask);
         }
+        else{
+            m_contourFinder.findContours(mask->pixels);
+        }
+    }
+    
+    TrackingContours& frame = m_contourQueue.getWriteFrame();
+    frame.idle = mask->idle;
+    
+    // refining traces the contours again with OpenCV, which allocates like the contour finder
+    if(!frame.idle && mask->refine){
+        ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_REFINE);
+        m_contourPyramid.refine(m_contourFinder, mask->depth, mask->background, frame.contours);
     }
+    
+    // the contour finder of ofxCv builds its contours and tracks them in new vectors every frame, so it is left out
+    AllocationScope allocations;
+    
+    if(frame.idle){
+        frame.contours.clear();
+    }
+    else if(mask->scale == 1){
+        frame.contours.setFromContourFinder(m_contourFinder);
+    }
+    else if(!mask->refine){
+        m_contourPyramid.upscale(m_contourFinder, frame.contours);
+    }
+    frame.contours.setTimestamp(mask->timestamp);
+    frame.larger = m_traceMarks.raise(frame.contours) | frame.marks.raise(frame.contours);
+    
+    if(!m_sendAllContours.load(std::memory_order_relaxed)){
+        frame.contours.keepLargest();
+    }
+    
+    // the tracker moves on to the next frame while this one is post-processed, the empty contour of a frame without anybody isn't tracked
+    frame.ages.resize(frame.contours.size());
+    for(int i = 0; i < frame.contours.size(); i++) {
+        frame.ages[i] = frame.contours.getNumVertices(i) > 0 ? tracker.getAge(frame.contours.getLabel(i)) : 0;
+    }
+    
+    frame.numAllocations = mask->numAllocations + allocations.getNumAllocations();
+    frame.numBytes = mask->numBytes + allocations.getNumBytes();
+    m_contourQueue.push();
+    return true;
+}
 
+bool TrackingManager::postProcessFrame()
+{
+    if(this->isLossless() && m_emitQueue.isFull()){
+        return false;
+    }
+    
+    TrackingContours* input = m_contourQueue.pop();
+    if(!input){
+        return false;
+    }
+    
+    ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_CONTOURS);
+    AllocationScope allocations;
+    
+    if(m_resetBudget.exchange(false, std::memory_order_relaxed)){
+        m_contourBudget.reset();
+    }
+    
+    TrackingContours& frame = m_emitQueue.getWriteFrame();
+    frame.contours.copyFrom(input->contours);
+    frame.fourier = m_useFourierDescriptors.load(std::memory_order_relaxed);
+    frame.degradation = -1;
+    frame.larger = input->larger | m_postProcessMarks.raise(frame.contours) | frame.marks.raise(frame.contours);
+    frame.idle = input->idle;
+    
+    bool useSendBudget = m_useSendBudget.load(std::memory_order_relaxed);
+    if(useSendBudget && !frame.idle){
+        m_contourBudget.setMaxContours(m_maxContours.load(std::memory_order_relaxed));
+        m_contourBudget.rank(frame.contours, input->ages);
+    }
+    
+    // truncating the descriptors already smooths and simplifies the outline
+    if(frame.fourier){
+        frame.descriptors.setNumCoefficients(m_fourierCoefficients.load(std::memory_order_relaxed));
+        frame.descriptors.compute(frame.contours);
+    }
+    else if(!frame.idle){
+        this->updateOutputContours(frame.contours, useSendBudget);
+        if(useSendBudget){
+            frame.degradation = m_contourBudget.getLevel();
+        }
+    }
     
+    frame.numAllocations = input->numAllocations + allocations.getNumAllocations();
+    frame.numBytes = input->numBytes + allocations.getNumBytes();
+    m_emitQueue.push();
+    return true;
 }
 
-void TrackingManager::updateContourTracking()
+void TrackingManager::updateOutputContours(ContourSet& contours, bool useSendBudget)
 {
-    if (m_kinect.isFrameNew() || m_vidGrabber.isFrameNew())
-    {
-        ofImage image;
-        ofPixels pixels;
-        m_blurredFbo.readToPixels(pixels);
-        image.setFromPixels(pixels);
+    float simplifyTolerance = m_simplifyTolerance.load(std::memory_order_relaxed);
+    int frameBytes = m_frameBytes.load(std::memory_order_relaxed);
+    
+    contours.smooth(m_smoothingSize.load(std::memory_order_relaxed), m_smoothingShape.load(std::memory_order_relaxed));
+    contours.simplify(useSendBudget ? m_contourBudget.getTolerance(simplifyTolerance) : simplifyTolerance);
+    
+    if(m_useVertexBudget.load(std::memory_order_relaxed)){
+        const OscManager& oscManager = AppManager::getInstance().getOscManager();
         
-        if(m_substractBackground){
-            ofImage thresholded;
-            m_background.update(image, thresholded);
-            thresholded.update();
-            m_contourFinder.findContours(thresholded);
-        }
-        else{
-            m_contourFinder.findContours(image);
+        // the smallest contours are dropped while the others can't even keep their minimum within the frame bytes
+        int numContours = contours.size();
+        int maxVertices = oscManager.getFrameVertexBudget(frameBytes, numContours);
+        while(numContours > 0 && numContours*ContourSimplifier::MIN_VERTICES > maxVertices){
+            numContours--;
+            maxVertices = oscManager.getFrameVertexBudget(frameBytes, numContours);
         }
+        contours.keepLargest(numContours);
         
-        this->updateTrackedContour();
+        m_contourSimplifier.setMaxVerticesPerContour(oscManager.getContourVertexBudget(m_packetBytes.load(std::memory_order_relaxed)));
+        m_contourSimplifier.setMaxVerticesPerFrame(maxVertices);
+        m_contourSimplifier.simplify(contours);
+    }
+    
+    if(useSendBudget){
+        const OscManager& oscManager = AppManager::getInstance().getOscManager();
+        int maxVertices = min(m_maxVertices.load(std::memory_order_relaxed), oscManager.getFrameVertexBudget(frameBytes, contours.size()));
+        m_contourBudget.setMaxVertices(maxVertices);
+        m_contourBudget.update(contours);
+    }
+}
+
+bool TrackingManager::emitFrame()
+{
+    TrackingContours* frame = m_emitQueue.pop();
+    if(!frame){
+        return false;
+    }
+    
+    // logged before the allocations are counted, since the log allocates
+    if(frame->idle != m_emittedIdle){
+        ofLogNotice() <<"TrackingManager::emitFrame -> " << (frame->idle ? "idle, nothing in view" : "awake");
+    }
+    
+    AllocationScope allocations;
+    
+    // the receivers got the empty frame that started the idle time, so nothing more is sent until somebody shows up
+    bool send = !(frame->idle && m_emittedIdle);
+    m_emittedIdle = frame->idle;
+    
+    if(send){
+        AppManager::getInstance().getSharedMemoryManager().writeContours(frame->contours);
         
-        if(m_sendAllContours){
-            this->sendAllContours();
+        // the sender queue slots grow on their own like the slots of the pipeline
+        if(frame->fourier){
+            frame->larger |= AppManager::getInstance().getOscManager().sendFourierDescriptors(frame->descriptors, frame->contours.getTimestamp());
         }
         else{
-            this->sendTrackedContour();
+            frame->larger |= AppManager::getInstance().getOscManager().sendContours(frame->contours, frame->degradation);
         }
     }
+    
+    AppManager::getInstance().getBenchmarkManager().addFrame(frame->contours);
+    
+    TrackingContours& result = m_drawQueue.getWriteFrame();
+    frame->larger |= result.marks.raise(frame->contours);
+    result.contours.copyFrom(frame->contours);
+    result.descriptors.copyFrom(frame->descriptors);
+    result.fourier = frame->fourier;
+    m_drawQueue.push();
+    
+    this->checkAllocations(*frame, frame->numAllocations + allocations.getNumAllocations(), frame->numBytes + allocations.getNumBytes());
+    return true;
 }
 
-void TrackingManager::updateTrackedContour()
+bool TrackingManager::skipIdleFrame()
 {
-    double contourArea = 0;
-    m_trackedContour.clear();
-    for(int i = 0; i < m_contourFinder.size(); i++) {
-        
-        if(contourArea < m_contourFinder.getContourArea(i)){
-            contourArea =  m_contourFinder.getContourArea(i);
-            m_trackedContour =  m_contourFinder.getPolyline(i);
+    int idleFrameRate = m_idleFrameRate.load(std::memory_order_relaxed);
+    if(idleFrameRate <= 0 || this->isLossless()){
+        return false;
+    }
+    
+    // the frames in between are accounted for by the next one passed on
+    unsigned long long time = ofGetElapsedTimeMicros();
+    if(time - m_lastFrameTime < 1000000/idleFrameRate){
+        return true;
+    }
+    
+    m_lastFrameTime = time;
+    return false;
+}
+
+bool TrackingManager::isPresent(const ofPixels& mask, int scale) const
+{
+    // a sparse grid finds anything as large as the smallest contour the finder keeps
+    int width = mask.getWidth();
+    int height = mask.getHeight();
+    int numChannels = mask.getNumChannels();
+    const unsigned char* pixels = mask.getPixels();
+    
+    int step = max(PRESENCE_STEP/scale, 1);
+    float radius = float(m_contourMinArea.load(std::memory_order_relaxed))/scale;
+    int minValue = 255 - m_threshold.load(std::memory_order_relaxed);
+    int minSamples = max(int(PI*radius*radius/(2*step*step)), 1);
+    int numSamples = 0;
+    
+    for(int y = step/2; y < height; y += step) {
+        const unsigned char* row = pixels + y*width*numChannels;
+        for(int x = step/2; x < width; x += step) {
+            if(row[x*numChannels] >= minValue && ++numSamples >= minSamples){
+                return true;
+            }
         }
     }
+    
+    return false;
 }
 
-void TrackingManager::sendTrackedContour()
+bool TrackingManager::isPresent(const BitMask& mask, int scale) const
 {
-    AppManager::getInstance().getOscManager().sendNumberContours(1);
+    // the bits are counted a word at a time, so every pixel is looked at rather than a grid of them
+    float radius = float(m_contourMinArea.load(std::memory_order_relaxed))/scale;
+    int minPixels = max(int(PI*radius*radius/2), 1);
+    return mask.count() >= minPixels;
+}
+
+void TrackingManager::filterMask(const ofPixels& mask, BitMask& bits, int scale)
+{
+    ProfileScope scope(AppManager::getInstance().getProfilerManager(), ProfilerManager::STAGE_MORPHOLOGY);
+    
+    bits.threshold(mask, 255 - m_threshold.load(std::memory_order_relaxed));
+    
+    // the elements shrink with the decimation, and are only built again when they change so that no frame allocates
+    StructuringElement::Shape shape = StructuringElement::Shape(m_maskShape.load(std::memory_order_relaxed));
+    int openRadius = (m_maskOpen.load(std::memory_order_relaxed) + scale - 1)/scale;
+    int closeRadius = (m_maskClose.load(std::memory_order_relaxed) + scale - 1)/scale;
     
-    ofPolyline p = m_trackedContour.getSmoothed(m_smoothingSize, m_smoothingShape);
-    p.simplify(m_simplifyTolerance);
-    AppManager::getInstance().getOscManager().sendContour(p, 0);
+    if(m_openElement.getShape() != shape || m_openElement.getRadius() != openRadius){
+        m_openElement = StructuringElement(shape, openRadius);
+    }
+    
+    if(m_closeElement.getShape() != shape || m_closeElement.getRadius() != closeRadius){
+        m_closeElement = StructuringElement(shape, closeRadius);
+    }
+    
+    if(openRadius > 0){
+        m_maskFilter.open(bits, m_openElement);
+    }
+    
+    if(closeRadius > 0){
+        m_maskFilter.close(bits, m_closeElement);
+    }
+}
+
+void TrackingManager::setContourScale(int scale)
+{
+    m_contourScale = scale;
+    m_contourFinder.setMinAreaRadius(float(m_contourMinArea.load(std::memory_order_relaxed))/scale);
+    m_contourFinder.setMaxAreaRadius(float(m_contourMaxArea.load(std::memory_order_relaxed))/scale);
+    m_contourFinder.getTracker().setMaximumDistance(float(TRACKING_DISTANCE)/scale);
+    m_contourPyramid.setScale(scale);
 }
 
-void TrackingManager::sendAllContours()
+void TrackingManager::applyContourSettings()
 {
-    AppManager::getInstance().getOscManager().sendNumberContours(m_contourFinder.size());
-    for(int i = 0; i < m_contourFinder.size(); i++) {
-        ofPolyline p = m_contourFinder.getPolyline(i).getSmoothed(m_smoothingSize, m_smoothingShape);
-        p.simplify(m_simplifyTolerance);
-        AppManager::getInstance().getOscManager().sendContour(p, i);
+    // the GUI only stores the settings, the contour thread owns the finder and the pyramid
+    int threshold = m_threshold.load(std::memory_order_relaxed);
+    m_contourFinder.setThreshold(threshold);
+    m_contourFinder.setMinAreaRadius(float(m_contourMinArea.load(std::memory_order_relaxed))/m_contourScale);
+    m_contourFinder.setMaxAreaRadius(float(m_contourMaxArea.load(std::memory_order_relaxed))/m_contourScale);
+    m_contourFinder.setSortBySize(m_useSendBudget.load(std::memory_order_relaxed));
+    m_contourFinder.setIncremental(this->getIncrementalContours());
+    m_contourFinder.setMaxDirtyTiles(m_incrementalMaxDirty.load(std::memory_order_relaxed)/100.0f);
+    m_contourPyramid.setThresholds(m_thresholdBackground.load(std::memory_order_relaxed), threshold);
+}
+
+void TrackingManager::checkAllocations(const TrackingContours& frame, unsigned int numAllocations, unsigned int numBytes)
+{
+    AppManager::getInstance().getProfilerManager().recordAllocations(numAllocations, numBytes);
+    
+    // a frame is larger when any queue slot or scratch buffer it went through grew for it, each keeps its own marks
+    if(m_resetSteadyState.exchange(false, std::memory_order_relaxed) || frame.larger){
+        m_numSteadyFrames = 0;
+        return;
+    }
+    
+    if(m_numSteadyFrames < STEADY_STATE_FRAMES){
+        m_numSteadyFrames++;
+        return;
+    }
+    
+#ifdef DEBUG
+    if(numAllocations > 0){
+        ofLogError() <<"TrackingManager::checkAllocations -> " << numAllocations << " allocations of " << numBytes << " bytes in steady state";
     }
+    assert(numAllocations == 0);
+#endif
 }
 
 
@@ -311,7 +798,12 @@ void TrackingManager::drawCamera()
     ofPushStyle();
     ofSetColor(255);
         ofRect(0, 0, DEPTH_CAMERA_WIDTH + LayoutManager::PADDING*2, DEPTH_CAMERA_HEIGHT + LayoutManager::PADDING*2);
-        m_blurredFbo.draw(LayoutManager::PADDING,LayoutManager::PADDING);
+        if(this->getBitMask()){
+            m_depthFbo.draw(LayoutManager::PADDING,LayoutManager::PADDING);
+        }
+        else{
+            m_blurredFbo.draw(LayoutManager::PADDING,LayoutManager::PADDING);
+        }
     ofPopStyle();
 }
 
@@ -320,36 +812,117 @@ void TrackingManager::drawContourTracking()
 {
     ofPushMatrix();
         ofTranslate( LayoutManager::PADDING , LayoutManager::PADDING);
-        if(m_sendAllContours){
-            this->drawAllContours();
-        }
-        else{
-            this->drawTrackedContour();
-        }
+        this->drawContours();
     ofPopMatrix();
 }
 
-void TrackingManager::drawTrackedContour()
+void TrackingManager::drawContours()
 {
-    ofPolyline p = m_trackedContour.getSmoothed(m_smoothingSize, m_smoothingShape);
-    p.simplify(m_simplifyTolerance);
-    p.draw();
+    if(m_drawFourierDescriptors){
+        m_fourierDescriptors.draw();
+        return;
+    }
+    
+    m_contourSet.draw();
+}
+
+//--------------------------------------------------------------
+
+void TrackingManager::onResetBackground(){
+    m_resetBackground.store(true, std::memory_order_relaxed);
 }
 
-void TrackingManager::drawAllContours()
+
+void TrackingManager::onRecordChange(bool & value)
 {
-    for(int i = 0; i < m_contourFinder.size(); i++)
-    {
-        ofPolyline p = m_contourFinder.getPolyline(i).getSmoothed(m_smoothingSize, m_smoothingShape);
-        p.simplify(m_simplifyTolerance);
-        p.draw();
+    if(!value){
+        m_depthRecorder.stop();
+        return;
+    }
+    
+    if(!m_source || m_source->getType() == DepthSource::RECORDING){
+        ofLogWarning() <<"TrackingManager::onRecordChange -> only the depth of a live source can be recorded";
+        return;
     }
+    
+    ofDirectory::createDirectory(RECORDINGS_FOLDER, true, true);
+    string path = ofToDataPath(RECORDINGS_FOLDER + "depth_" + ofGetTimestampString("%Y%m%d_%H%M%S") + "." + DepthRecording::FILE_EXTENSION);
+    m_depthRecorder.start(path, m_source->getWidth(), m_source->getHeight());
 }
 
-//--------------------------------------------------------------
+void TrackingManager::togglePlayback()
+{
+    if(m_depthPlayer){
+        this->setSource(m_sourceType);
+        return;
+    }
+    
+    ofFileDialogResult result = ofSystemLoadDialog("Select a depth recording", false, ofToDataPath(RECORDINGS_FOLDER));
+    if(result.bSuccess){
+        this->playRecording(result.getPath());
+    }
+}
 
-void TrackingManager::onResetBackground(){
-    m_background.reset();
+bool TrackingManager::playRecording(const string& path)
+{
+    ofPtr<DepthPlayer> player(new DepthPlayer());
+    if(!player->open(path)){
+        return false;
+    }
+    
+    if(m_source){
+        m_source->close();
+    }
+    
+    m_syntheticSource.reset();
+    m_depthPlayer = player;
+    m_source = player;
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void TrackingManager::onSourceChange(int & value)
+{
+    // a benchmark keeps playing its recording
+    if(AppManager::getInstance().getBenchmarkManager().isEnabled()){
+        return;
+    }
+    
+    int type = ofClamp(value, 0, DepthSource::RECORDING - 1);
+    if(type == m_sourceType && m_source && !m_depthPlayer){
+        return;
+    }
+    
+    m_sourceType = type;
+    this->setSource(m_sourceType);
+}
+
+void TrackingManager::onSyntheticPeopleChange(int & value){
+    m_syntheticPeople = ofClamp(value,0,500);
+    if(m_syntheticSource){
+        m_syntheticSource->setNumPeople(m_syntheticPeople);
+    }
+}
+
+void TrackingManager::onSyntheticFrameRateChange(float & value){
+    m_syntheticFrameRate = ofClamp(value,1,240);
+    if(m_syntheticSource){
+        m_syntheticSource->setFrameRate(m_syntheticFrameRate);
+    }
+}
+
+void TrackingManager::onSyntheticNoiseChange(float & value){
+    m_syntheticNoise = ofClamp(value,0,100);
+    if(m_syntheticSource){
+        m_syntheticSource->setNoise(m_syntheticNoise);
+    }
+}
+
+void TrackingManager::onSyntheticDropoutChange(float & value){
+    m_syntheticDropout = ofClamp(value,0,1);
+    if(m_syntheticSource){
+        m_syntheticSource->setDropout(m_syntheticDropout);
+    }
 }
 
 
@@ -362,34 +935,31 @@ void TrackingManager::onFarClippingChange(int & value){
 }
 
 void TrackingManager::onThresholdChange(int & value){
-    m_threshold = ofClamp(value,0,255);
-    m_contourFinder.setThreshold(m_threshold);
+    m_threshold.store(ofClamp(value,0,255), std::memory_order_relaxed);
 }
 
 void TrackingManager::onBackgroundThresholdChange(int & value){
-    m_thresholdBackground = ofClamp(value,0,30);
-    m_background.setThresholdValue(m_thresholdBackground);
+    m_thresholdBackground.store(ofClamp(value,0,30), std::memory_order_relaxed);
 }
 
 
 void TrackingManager::onMinAreaChange(int & value){
-    m_contourMinArea = ofClamp(value,0,100);
-    m_contourFinder.setMinAreaRadius(m_contourMinArea);
+    m_contourMinArea.store(ofClamp(value,0,100), std::memory_order_relaxed);
 }
 
 void TrackingManager::onMaxAreaChange(int & value){
-    m_contourMaxArea = ofClamp(value,0,500);
-    m_contourFinder.setMaxAreaRadius(m_contourMaxArea);
+    m_contourMaxArea.store(ofClamp(value,0,500), std::memory_order_relaxed);
 }
 
 void TrackingManager::onBackgroundSubstractionChange(bool & value)
 {
-    m_substractBackground = value;
+    m_substractBackground.store(value, std::memory_order_relaxed);
 }
 
 void TrackingManager::onSendAllContoursChange(bool & value)
 {
-    m_sendAllContours = value;
+    m_sendAllContours.store(value, std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
 }
 
 void TrackingManager::onBlurScaleChange(float & value)
@@ -406,17 +976,119 @@ void TrackingManager::onBlurRotationChange(float & value)
 
 void TrackingManager::onSimplifyChange(float & value)
 {
-    m_simplifyTolerance = ofClamp(value,0.0,2.0);
+    m_simplifyTolerance.store(ofClamp(value,0.0,2.0), std::memory_order_relaxed);
 }
 
 void TrackingManager::onSmoothingSizeChange(float & value)
 {
-    m_smoothingSize = ofClamp(value,0.0,5.0);
+    m_smoothingSize.store(ofClamp(value,0.0,5.0), std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
 }
 
 void TrackingManager::onSmoothingShapeChange(float & value)
 {
-    m_smoothingShape = ofClamp(value,0.0,1.0);
+    m_smoothingShape.store(ofClamp(value,0.0,1.0), std::memory_order_relaxed);
+}
+
+void TrackingManager::onVertexBudgetChange(bool & value)
+{
+    m_useVertexBudget.store(value, std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onPacketBytesChange(int & value)
+{
+    m_packetBytes.store(ofClamp(value,256,OscManager::MAX_PACKET_SIZE), std::memory_order_relaxed);
+}
+
+void TrackingManager::onFrameBytesChange(int & value)
+{
+    m_frameBytes.store(ofClamp(value,1024,65536), std::memory_order_relaxed);
+}
+
+void TrackingManager::onSendBudgetChange(bool & value)
+{
+    m_useSendBudget.store(value, std::memory_order_relaxed);
+    m_resetBudget.store(true, std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onMaxVerticesChange(int & value)
+{
+    m_maxVertices.store(ofClamp(value,256,32768), std::memory_order_relaxed);
+}
+
+void TrackingManager::onMaxContoursChange(int & value)
+{
+    m_maxContours.store(ofClamp(value,1,64), std::memory_order_relaxed);
+}
+
+void TrackingManager::onFourierDescriptorsChange(bool & value)
+{
+    m_useFourierDescriptors.store(value, std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onPyramidLevelsChange(int & value)
+{
+    m_pyramidLevels.store(ofClamp(value,0,2), std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onPyramidRefineChange(bool & value)
+{
+    m_pyramidRefine.store(value, std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onIncrementalContoursChange(bool & value)
+{
+    m_incrementalContours.store(value, std::memory_order_relaxed);
+}
+
+void TrackingManager::onIncrementalMaxDirtyChange(int & value)
+{
+    m_incrementalMaxDirty.store(ofClamp(value,0,100), std::memory_order_relaxed);
+}
+
+void TrackingManager::onBitMaskChange(bool & value)
+{
+    m_useBitMask.store(value, std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onMaskOpenChange(int & value)
+{
+    m_maskOpen.store(ofClamp(value,0,5), std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onMaskCloseChange(int & value)
+{
+    m_maskClose.store(ofClamp(value,0,5), std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onMaskShapeChange(int & value)
+{
+    m_maskShape.store(ofClamp(value,0,StructuringElement::NUM_SHAPES - 1), std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
+}
+
+void TrackingManager::onIdleModeChange(bool & value)
+{
+    m_useIdleMode.store(value, std::memory_order_relaxed);
+}
+
+void TrackingManager::onIdleFrameRateChange(int & value)
+{
+    m_idleFrameRate.store(ofClamp(value,0,30), std::memory_order_relaxed);
+}
+
+void TrackingManager::onFourierCoefficientsChange(int & value)
+{
+    m_fourierCoefficients.store(ofClamp(value,2,FourierDescriptors::MAX_COEFFICIENTS), std::memory_order_relaxed);
+    m_resetSteadyState.store(true, std::memory_order_relaxed);
 }
 
 int TrackingManager::getHeight() const
@@ -8,20 +8,47 @@
 
 #pragma once
 
+#include <atomic>
 #include "Manager.h"
 
-#include "ofxMultiKinectV2.h"
 #include "ofxCv.h"
 #include "ofxBlur.h"
+#include "ContourSet.h"
+#include "ContourSimplifier.h"
+#include "ContourBudget.h"
+#include "ContourPyramid.h"
+#include "IncrementalContourFinder.h"
+#include "BitMask.h"
+#include "FourierDescriptors.h"
+#include "FrameQueue.h"
+#include "TrackingStageThread.h"
+#include "DepthRecorder.h"
+#include "DepthPlayer.h"
+#include "DepthSource.h"
+#include "SyntheticDepthSource.h"
 
-#define KINECT_CAMERA //Comment if you are using the laptop camera
 
 
 //========================== class TrackingManager ==============================
 //============================================================================
 /** \class TrackingManager TrackingManager.cpp
  *	\brief Class managing Murmurs floor tracking
- *	\details It reads the IR sensor of the Kinect camera and sends the blob tracking information
+ *	\details It reads the IR sensor of the Kinect camera and sends the blob tracking information.
+ *    The render thread captures the depth and preprocesses it on the GPU; segmentation,
+ *    contour finding and tracking, post-processing and emission run as a pipeline of
+ *    stage threads connected by bounded queues that drop the oldest frame, so tracking
+ *    keeps up with the sensor whatever the display rate. The render thread only takes
+ *    a copy of the latest emitted contours to draw them. In lossless mode a stage only
+ *    takes a frame once the next queue has room, so a recording replays identically.
+ *    Every frame counts the heap allocations of the stages it goes through; once the
+ *    buffers have grown to the largest frame, a steady frame shouldn't allocate at all.
+ *    When nothing has been in view for a while the pipeline goes idle: the contours
+ *    are neither traced nor sent, and optionally only a few masks a second go past the
+ *    segment stage, until anything shows up again. Every frame is still segmented, so
+ *    anything showing up is noticed on the very next frame.
+ *    The background subtraction and the contour finder can run on a frame decimated
+ *    2 or 4 times, with the contours upscaled or refined at full resolution around the
+ *    blobs by a ContourPyramid.
  */
 
 class TrackingManager: public Manager
@@ -29,7 +56,13 @@ class TrackingManager: public Manager
     
     static const float SCALE;
     static const int TRACKING_PERSISTANCY;
+    static const int TRACKING_DISTANCE;
     static const int LEARNING_TIME;
+    static const int QUEUE_CAPACITY;
+    static const int STEADY_STATE_FRAMES;
+    static const int IDLE_FRAMES;
+    static const int PRESENCE_STEP;
+    static const string RECORDINGS_FOLDER;
     
 public:
     
@@ -48,6 +81,9 @@ public:
     //! Draw kinect camera tracking
     void draw();
     
+    //! Stop the tracking pipeline threads
+    void stop();
+    
     //! Return the tracking visual height
     int getHeight() const;
     
@@ -57,6 +93,9 @@ public:
     //! Return the tracking visual position
     ofVec2f getPosition() const;
     
+    //! Processes the next frame of a pipeline stage, called from the stage threads. Returns false if there was none
+    bool processStage(int stage);
+    
     //! Near clipping change controlled by GUI
     void onNearClippingChange(int & value);
     
@@ -95,10 +134,109 @@ public:
     
     //! Smoothing shape controlled by GUI
     void onSmoothingShapeChange(float & value);
+    
+    //! Vertex budget toggle change controlled by GUI
+    void onVertexBudgetChange(bool & value);
+    
+    //! Maximum bytes of a contour packet controlled by GUI
+    void onPacketBytesChange(int & value);
+    
+    //! Maximum bytes of all the contours of a frame controlled by GUI
+    void onFrameBytesChange(int & value);
+    
+    //! Send budget toggle change controlled by GUI
+    void onSendBudgetChange(bool & value);
+    
+    //! Maximum vertices of all the contours of a frame under the send budget controlled by GUI
+    void onMaxVerticesChange(int & value);
+    
+    //! Maximum number of contours of a frame under the send budget controlled by GUI
+    void onMaxContoursChange(int & value);
+    
+    //! Fourier descriptors toggle change controlled by GUI
+    void onFourierDescriptorsChange(bool & value);
+    
+    //! Number of Fourier coefficients controlled by GUI
+    void onFourierCoefficientsChange(int & value);
 
+    //! Levels of the pyramid the tracking runs on controlled by GUI, 0 for full resolution
+    void onPyramidLevelsChange(int & value);
+    
+    //! Refinement of the coarse contours at full resolution toggle change controlled by GUI
+    void onPyramidRefineChange(bool & value);
+    
+    //! Incremental contour finding toggle change controlled by GUI
+    void onIncrementalContoursChange(bool & value);
+    
+    //! Percentage of changed tiles above which the whole mask is traced controlled by GUI
+    void onIncrementalMaxDirtyChange(int & value);
+    
+    //! Bit-packed mask toggle change controlled by GUI, its morphology replaces the blur
+    void onBitMaskChange(bool & value);
+    
+    //! Radius of the opening removing the specks of the bit-packed mask controlled by GUI, 0 for none
+    void onMaskOpenChange(int & value);
+    
+    //! Radius of the closing filling the gaps of the bit-packed mask controlled by GUI, 0 for none
+    void onMaskCloseChange(int & value);
+    
+    //! Shape of the structuring elements of the bit-packed mask controlled by GUI, one of StructuringElement::Shape
+    void onMaskShapeChange(int & value);
+    
+    //! Idle mode toggle change controlled by GUI
+    void onIdleModeChange(bool & value);
+    
+    //! Masks per second passed on from the segment stage while idle controlled by GUI, 0 for all of them
+    void onIdleFrameRateChange(int & value);
+    
     //! Reset Backround for background substraction
     void onResetBackground();
     
+    //! Depth source controlled by GUI, one of DepthSource::Type
+    void onSourceChange(int & value);
+    
+    //! Number of people of the synthetic crowd controlled by GUI
+    void onSyntheticPeopleChange(int & value);
+    
+    //! Frame rate of the synthetic crowd controlled by GUI
+    void onSyntheticFrameRateChange(float & value);
+    
+    //! Sensor noise of the synthetic crowd, in millimetres, controlled by GUI
+    void onSyntheticNoiseChange(float & value);
+    
+    //! Fraction of the pixels of the synthetic crowd dropping out controlled by GUI
+    void onSyntheticDropoutChange(float & value);
+    
+    //! Depth recording toggle change controlled by GUI
+    void onRecordChange(bool & value);
+    
+    //! Plays a depth recording chosen in a dialog instead of the camera, or goes back to the chosen source
+    void togglePlayback();
+    
+    //! Plays the given depth recording instead of the camera. Returns false if it can't be opened
+    bool playRecording(const string& path);
+    
+    //! Returns the number of frames of the recording being played
+    int getNumPlaybackFrames() const {return m_depthPlayer ? m_depthPlayer->getNumFrames() : 0;}
+    
+    //! Makes the pipeline wait for room in its queues instead of dropping frames, and step through a recording frame by frame
+    void setLossless(bool value) {m_lossless.store(value, std::memory_order_relaxed);}
+    
+    //! Returns whether the pipeline waits for room in its queues instead of dropping frames
+    bool isLossless() const {return m_lossless.load(std::memory_order_relaxed);}
+    
+    //! Returns the times the frame is halved before the segmentation, 0 for full resolution
+    int getPyramidLevels() const {return m_pyramidLevels.load(std::memory_order_relaxed);}
+    
+    //! Returns whether the coarse contours are refined at full resolution
+    bool getPyramidRefine() const {return m_pyramidRefine.load(std::memory_order_relaxed);}
+    
+    //! Returns whether the contour finder retraces only the parts of the mask that changed
+    bool getIncrementalContours() const {return m_incrementalContours.load(std::memory_order_relaxed);}
+    
+    //! Returns whether the mask is segmented into bits and filtered by morphology instead of the blur
+    bool getBitMask() const {return m_useBitMask.load(std::memory_order_relaxed);}
+    
     void onCropLeft( int & pixels) {m_cropLeft = pixels;}
     
     void onCropRight( int & pixels) {m_cropRight = pixels;}
@@ -116,33 +254,59 @@ private:
     
     void setupCamera();
     
-    void setupKinectCamera();
-    
-    void setupWebCamera();
+    //! Closes the current source and opens one of the given DepthSource::Type. Returns false if it can't be opened
+    bool setSource(int type);
     
     void setupFbos();
     
     void setupContourTracking();
     
+    void setupPipeline();
+    
     void updateCamera();
     
-    void updateWebCamera();
+    void drawCrop();
     
-    void updateKinectCamera();
+    void blurDepth();
     
-    void updateContourTracking();
+    void readDepth(ofFbo& fbo);
     
-    void updateTrackedContour();
+    void updateContours();
     
-    void sendTrackedContour();
+    bool segmentFrame();
     
-    void sendAllContours();
+    bool traceFrame();
     
-    void drawTracking();
+    bool postProcessFrame();
+    
+    bool emitFrame();
+    
+    //! Scales the areas and distances of the contour finder to the decimation of the masks. Called from the contour thread
+    void setContourScale(int scale);
+    
+    //! Applies the contour settings the GUI stored to the contour finder and the pyramid. Called from the contour thread
+    void applyContourSettings();
+    
+    //! Returns whether the mask of an idle frame should stop at the segment stage, to lower the rate of the later ones. Called from the segment thread
+    bool skipIdleFrame();
     
-    void drawTrackedContour();
+    //! Returns whether anything as large as the smallest contour is in the mask, decimated by the given scale
+    bool isPresent(const ofPixels& mask, int scale) const;
+    
+    //! Returns whether the bit-packed mask, decimated by the given scale, has as many pixels as the smallest contour
+    bool isPresent(const BitMask& mask, int scale) const;
+    
+    //! Thresholds the mask into bits, then opens and closes them. Called from the segment thread
+    void filterMask(const ofPixels& mask, BitMask& bits, int scale);
+    
+    //! Records the allocations of an emitted frame, a debug build stops if there are any in steady state
+    void checkAllocations(const TrackingContours& frame, unsigned int numAllocations, unsigned int numBytes);
+    
+    void updateOutputContours(ContourSet& contours, bool useSendBudget);
+    
+    void drawTracking();
     
-    void drawAllContours();
+    void drawContours();
     
     void drawCamera();
     
@@ -154,8 +318,15 @@ private:
     ofShader                m_depthShader;                 ///< Shader class handling the depth camera capture
     static const string     m_depthFragmentShader;         ///< Fragment shader handling the depth camera capture
     
-    ofxMultiKinectV2        m_kinect;                      ///< Mircrosoft Kinect v2 class
-    ofVideoGrabber          m_vidGrabber;                  ///< Video Grabber
+    ofPtr<DepthSource>              m_source;              ///< Source the depth frames are taken from, NULL if none could be opened
+    ofPtr<DepthPlayer>              m_depthPlayer;         ///< Source while a depth recording is played back
+    ofPtr<SyntheticDepthSource>     m_syntheticSource;     ///< Source while the synthetic crowd is chosen
+    int                     m_sourceType;                  ///< Source chosen, one of DepthSource::Type
+    int                     m_syntheticPeople;             ///< Number of people of the synthetic crowd
+    float                   m_syntheticFrameRate;          ///< Frames of the synthetic crowd per second
+    float                   m_syntheticNoise;              ///< Sensor noise of the synthetic crowd (in mm)
+    float                   m_syntheticDropout;            ///< Fraction of the pixels of the synthetic crowd dropping out
+    DepthRecorder           m_depthRecorder;               ///< Records the depth of the live source
     ofTexture               m_depthTexture;                ///< The texture holding every new depth captured frame
     ofFbo                   m_depthFbo;                    ///< The fbo holding the depth frame after applying shader
     ofFbo                   m_blurredFbo;                  ///< The fbo holding the depth after being blurred
@@ -166,18 +337,73 @@ private:
     float                   m_blurScale;                   ///< Scale corresponds to how much you "stretch" the blur kernel
     float                   m_blurRotation;                ///< Rotation corresponds to the two directions the blur
     
-    ofxCv::ContourFinder        m_contourFinder;            ///< threshold used for the contour tracking
+    IncrementalContourFinder    m_contourFinder;            ///< threshold used for the contour tracking
     ofxCv::RunningBackground    m_background;               ///< used for background substraction
-    ofPolyline                  m_trackedContour;           ///< single contour to be tracked
-    int                         m_threshold;                ///< threshold used for the contour tracking
-    int                         m_thresholdBackground;      ///< threshold used for the backround substraction
-    float                       m_simplifyTolerance;        ///< tolerance for simplifying the contour, removing un-necessary vertices.
-    float                       m_smoothingSize;            ///< size of the smoothing window
-    float                       m_smoothingShape;           ///< describes whether to use a triangular window (0) or box window (1) or something in between (0.5)
-    int                         m_contourMinArea;           ///< contour minimum area
-    int                         m_contourMaxArea;           ///< blcontourob's maxmimum area
-    bool                        m_substractBackground;      ///< defines whether to extract or not the background
-    bool                        m_sendAllContours;          ///< defines whether to send one or all contours
+    std::atomic<int>            m_threshold;                ///< threshold used for the contour tracking
+    std::atomic<int>            m_thresholdBackground;      ///< threshold used for the backround substraction
+    std::atomic<float>          m_simplifyTolerance;        ///< tolerance for simplifying the contour, removing un-necessary vertices.
+    std::atomic<float>          m_smoothingSize;            ///< size of the smoothing window
+    std::atomic<float>          m_smoothingShape;           ///< describes whether to use a triangular window (0) or box window (1) or something in between (0.5)
+    std::atomic<int>            m_contourMinArea;           ///< contour minimum area
+    std::atomic<int>            m_contourMaxArea;           ///< blcontourob's maxmimum area
+    std::atomic<bool>           m_substractBackground;      ///< defines whether to extract or not the background
+    std::atomic<bool>           m_sendAllContours;          ///< defines whether to send one or all contours
+    
+    ContourSimplifier           m_contourSimplifier;        ///< simplifies the contours to fit in the vertex budget
+    ContourSet                  m_contourSet;               ///< latest emitted contours, drawn by the render thread
+    std::atomic<bool>           m_useVertexBudget;          ///< defines whether to simplify the contours to a vertex budget
+    std::atomic<int>            m_packetBytes;              ///< maximum bytes of a single contour packet
+    std::atomic<int>            m_frameBytes;               ///< maximum bytes of all the contour packets of a frame
+    ContourBudget               m_contourBudget;            ///< degrades the contours gracefully when they don't fit in the send budget
+    ContourPyramid              m_contourPyramid;           ///< upscales or refines the contours found on a decimated mask
+    ofPixels                    m_decimatedDepth;           ///< depth decimated for the segmentation
+    std::atomic<int>            m_pyramidLevels;            ///< times the frame is halved before the segmentation, 0 for full resolution
+    std::atomic<bool>           m_pyramidRefine;            ///< defines whether to refine the coarse contours at full resolution
+    int                         m_segmentScale;             ///< decimation the background has been learning at
+    int                         m_contourScale;             ///< decimation the contour finder is set up for
+    std::atomic<bool>           m_incrementalContours;      ///< defines whether the contour finder retraces only the parts of the mask that changed
+    std::atomic<int>            m_incrementalMaxDirty;      ///< percentage of changed tiles above which the whole mask is traced
+    BitMaskFilter               m_maskFilter;               ///< opens and closes the bit-packed mask
+    StructuringElement          m_openElement;              ///< element of the opening, built by the segment thread when the settings change
+    StructuringElement          m_closeElement;             ///< element of the closing, built by the segment thread when the settings change
+    ofPixels                    m_foreground;               ///< mask left by the background subtraction before it is packed
+    ofPixels                    m_unpackedMask;             ///< bit-packed mask unpacked for the contour finder
+    std::atomic<bool>           m_useBitMask;               ///< defines whether to segment into a bit-packed mask filtered by morphology instead of blurring
+    std::atomic<int>            m_maskOpen;                 ///< radius of the opening of the bit-packed mask, 0 for none
+    std::atomic<int>            m_maskClose;                ///< radius of the closing of the bit-packed mask, 0 for none
+    std::atomic<int>            m_maskShape;                ///< shape of the structuring elements, one of StructuringElement::Shape
+    std::atomic<bool>           m_useSendBudget;            ///< defines whether to keep the contours within the send budget
+    std::atomic<int>            m_maxVertices;              ///< maximum vertices of all the contours of a frame under the send budget
+    std::atomic<int>            m_maxContours;              ///< maximum number of contours of a frame under the send budget
+    unsigned long long          m_captureTime;              ///< time the current frame was captured, in microseconds since the epoch
+    FourierDescriptors          m_fourierDescriptors;       ///< latest emitted Fourier descriptors, drawn by the render thread
+    bool                        m_drawFourierDescriptors;   ///< whether the latest emitted frame was sent as Fourier descriptors
+    std::atomic<bool>           m_useFourierDescriptors;    ///< defines whether to send Fourier descriptors instead of vertices
+    std::atomic<int>            m_fourierCoefficients;      ///< number of complex Fourier coefficients kept for every contour
+    
+    FrameQueue<TrackingImage>       m_depthQueue;           ///< preprocessed depth waiting to be segmented
+    FrameQueue<TrackingImage>       m_maskQueue;            ///< masks waiting for the contour finder
+    FrameQueue<TrackingContours>    m_contourQueue;         ///< tracked contours waiting to be post-processed
+    FrameQueue<TrackingContours>    m_emitQueue;            ///< post-processed contours waiting to be sent
+    FrameQueue<TrackingContours>    m_drawQueue;            ///< emitted contours waiting for the render thread
+    TrackingStageThread             m_segmentThread;        ///< subtracts the background
+    TrackingStageThread             m_contourThread;        ///< finds and tracks the contours
+    TrackingStageThread             m_postProcessThread;    ///< ranks, smooths, simplifies and budgets the contours
+    TrackingStageThread             m_emitThread;           ///< publishes the contours and queues them to be sent
+    std::atomic<bool>               m_resetBackground;      ///< whether the segment thread has to reset the background
+    std::atomic<bool>               m_resetBudget;          ///< whether the post-process thread has to reset the send budget
+    std::atomic<bool>               m_lossless;             ///< whether the stages wait for room in the next queue instead of dropping frames
+    ContourMarks                    m_traceMarks;           ///< largest contours the contour thread has traced, its scratch buffers only grow past them
+    ContourMarks                    m_postProcessMarks;     ///< largest contours the post-process thread has processed, its scratch buffers only grow past them
+    int                             m_numSteadyFrames;      ///< frames emitted since the buffers last grew
+    std::atomic<bool>               m_resetSteadyState;     ///< whether a change of source or settings makes the buffers grow again
+    std::atomic<bool>               m_useIdleMode;          ///< defines whether to go idle when nothing is in view
+    std::atomic<int>                m_idleFrameRate;        ///< frames per second passed on from the segment stage while idle, 0 for all of them
+    int                             m_numAbsentFrames;      ///< frames without anything in view, up to IDLE_FRAMES
+    int                             m_numSkippedFrames;     ///< masks the segment stage kept back since the last one passed on
+    unsigned long long              m_lastFrameTime;        ///< time the segment stage last passed on a mask while idle, in microseconds
+    vector<cv::Rect>                m_noObjects;            ///< empty list that ages the tracker while idle
+    bool                            m_emittedIdle;          ///< whether the last emitted frame was idle
     
     int                         m_cropLeft, m_cropRight, m_cropTop, m_cropBottom;
     
@@ -0,0 +1,50 @@
+/*
+ *  TrackingStageThread.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "TrackingStageThread.h"
+#include "TrackingManager.h"
+
+
+TrackingStageThread::TrackingStageThread(Stage stage): m_stage(stage), m_trackingManager(NULL)
+{
+    //Intentionally left empty
+}
+
+
+TrackingStageThread::~TrackingStageThread()
+{
+    this->stop();
+}
+
+
+void TrackingStageThread::start(TrackingManager* trackingManager)
+{
+    m_trackingManager = trackingManager;
+    startThread();
+}
+
+void TrackingStageThread::stop()
+{
+    if(isThreadRunning()){
+        stopThread();
+        m_signal.notify();
+        waitForThread(false);
+    }
+}
+
+void TrackingStageThread::threadedFunction()
+{
+    while(isThreadRunning())
+    {
+        // the queues around the stage notify it when a frame or room arrives
+        if(!m_trackingManager->processStage(m_stage)){
+            m_signal.wait();
+        }
+    }
+}
+
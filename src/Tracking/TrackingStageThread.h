@@ -0,0 +1,120 @@
+/*
+ *  TrackingStageThread.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ContourSet.h"
+#include "FourierDescriptors.h"
+#include "BitMask.h"
+#include "ThreadSignal.h"
+
+class TrackingManager;
+
+//========================== struct TrackingImage ==============================
+//============================================================================
+/** \struct TrackingImage TrackingStageThread.h
+ *	\brief An image passed between the tracking stages
+ *	\details Either the preprocessed depth read back from the GPU or the mask left
+ *    by the background subtraction, with the time it was captured. A mask found on a
+ *    decimated frame to be refined carries the full resolution depth along with it.
+ *    A mask segmented into bits is packed, its pixels are left as they were.
+ */
+
+struct TrackingImage
+{
+    ofPixels                pixels;             ///< depth or mask pixels
+    BitMask                 bits;               ///< mask packed a bit per pixel, when it is packed
+    bool                    packed;             ///< whether the mask is in the bits instead of the pixels
+    ofPixels                depth;              ///< full resolution depth the contours of the mask are refined on
+    ofPixels                background;         ///< decimated background model the depth is compared with, empty without background subtraction
+    int                     scale;              ///< decimation of the mask, 1 at full resolution
+    bool                    refine;             ///< whether the contours of the decimated mask are refined at full resolution
+    unsigned long long      timestamp;          ///< capture time, in microseconds since the epoch
+    int                     numFrames;          ///< source frames the image stands for, more than one for a mask after the ones before it were kept back while idle
+    bool                    idle;               ///< whether nothing has been in view for a while, set by the segment stage
+    unsigned int            numAllocations;     ///< heap allocations of the stages the frame went through
+    unsigned int            numBytes;           ///< bytes allocated by the stages the frame went through
+};
+
+
+//========================== struct TrackingContours ==============================
+//============================================================================
+/** \struct TrackingContours TrackingStageThread.h
+ *	\brief The contours of a frame passed between the tracking stages
+ *	\details The tracker ages are taken along with the contours, so the later stages
+ *    don't touch the tracker while it is already working on the next frame.
+ */
+
+struct TrackingContours
+{
+    ContourSet              contours;           ///< contours of the frame, with the capture time
+    vector<int>             ages;               ///< tracker age of every contour
+    FourierDescriptors      descriptors;        ///< Fourier descriptors of the contours, when they are used
+    bool                    fourier;            ///< whether the descriptors are sent instead of the contours
+    int                     degradation;        ///< degradation level of the send budget, -1 when it is off
+    bool                    idle;               ///< whether nothing has been in view for a while, so there are no contours
+    bool                    larger;             ///< whether a buffer the frame went through held no contours as large before, so it grew
+    ContourMarks            marks;              ///< largest contours the slot has held, it only grows past them
+    unsigned int            numAllocations;     ///< heap allocations of the stages the frame went through, the contour finder left out
+    unsigned int            numBytes;           ///< bytes allocated by the stages the frame went through, the contour finder left out
+};
+
+
+//========================== class TrackingStageThread ==============================
+//============================================================================
+/** \class TrackingStageThread TrackingStageThread.h
+ *	\brief Runs one stage of the tracking pipeline on its own thread
+ *	\details The render thread captures the depth and preprocesses it on the GPU,
+ *    the stage threads take it from there: segmentation, contour finding and
+ *    tracking, post-processing and emission. Each stage pops its input from the
+ *    queue of the previous one and pushes its output to the next, so every stage
+ *    works on a different frame at the same time.
+ */
+
+class TrackingStageThread: public ofThread
+{
+
+public:
+
+    enum Stage {
+        SEGMENT,
+        CONTOURS,
+        POST_PROCESS,
+        EMIT
+    };
+
+    //! Constructor
+    TrackingStageThread(Stage stage);
+
+    //! Destructor
+    ~TrackingStageThread();
+
+    //! Starts running the stage of the given manager
+    void start(TrackingManager* trackingManager);
+
+    //! Stops the thread once the frame being processed is done
+    void stop();
+
+    //! Returns the signal waking the thread when it has work to do
+    ThreadSignal* getSignal() {return &m_signal;}
+
+private:
+
+    void threadedFunction();
+
+private:
+
+    Stage                   m_stage;            ///< stage run by the thread
+    TrackingManager*        m_trackingManager;  ///< processes the frames of the stage
+    ThreadSignal            m_signal;           ///< wakes the thread when it has nothing to do
+};
+
+//==========================================================================
+
+
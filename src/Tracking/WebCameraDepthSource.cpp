@@ -0,0 +1,77 @@
+/*
+ *  WebCameraDepthSource.cpp
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#include "WebCameraDepthSource.h"
+
+
+const float WebCameraDepthSource::RANGE = 5000;
+
+
+WebCameraDepthSource::WebCameraDepthSource(): m_width(0), m_height(0), m_frameNew(false), m_timestamp(0)
+{
+    //Intentionally left empty
+}
+
+
+WebCameraDepthSource::~WebCameraDepthSource()
+{
+    this->close();
+}
+
+
+bool WebCameraDepthSource::open(int width, int height)
+{
+    m_vidGrabber.setDeviceID(0);
+    //m_vidGrabber.setDesiredFrameRate(60);
+    if(!m_vidGrabber.initGrabber(width, height)){
+        ofLogError() <<"WebCameraDepthSource::open -> unable to open the camera";
+        return false;
+    }
+    
+    // the camera may not give the size asked for
+    m_width = m_vidGrabber.getWidth();
+    m_height = m_vidGrabber.getHeight();
+    m_depth.allocate(m_width, m_height, 1);
+    
+    ofLogNotice() <<"WebCameraDepthSource::open -> " << m_width << "x" << m_height;
+    return true;
+}
+
+void WebCameraDepthSource::close()
+{
+    if(!m_vidGrabber.isInitialized()){
+        return;
+    }
+    
+    m_vidGrabber.close();
+    m_frameNew = false;
+    
+    ofLogNotice() <<"WebCameraDepthSource::close";
+}
+
+void WebCameraDepthSource::update()
+{
+    m_vidGrabber.update();
+    m_frameNew = m_vidGrabber.isFrameNew();
+    if(!m_frameNew){
+        return;
+    }
+    
+    m_timestamp = ofGetSystemTimeMicros();
+    
+    const ofPixels& pixels = m_vidGrabber.getPixelsRef();
+    const unsigned char* color = pixels.getPixels();
+    int numChannels = pixels.getNumChannels();
+    float* depth = m_depth.getPixels();
+    
+    for(int i = 0; i < m_width*m_height; i++, color += numChannels) {
+        float brightness = (numChannels >= 3) ? (color[0] + color[1] + color[2])/(3*255.0f) : color[0]/255.0f;
+        depth[i] = RANGE*(1.0f - brightness);
+    }
+}
+
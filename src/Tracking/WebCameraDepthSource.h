@@ -0,0 +1,68 @@
+/*
+ *  WebCameraDepthSource.h
+ *  Murmur
+ *
+ *  Created by Imanol Gomez on 19/10/26.
+ *
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "DepthSource.h"
+
+
+//========================== class WebCameraDepthSource ==============================
+//============================================================================
+/** \class WebCameraDepthSource WebCameraDepthSource.h
+ *	\brief Stands the laptop camera in for a depth sensor
+ *	\details The brightness of every pixel is turned into a depth over RANGE
+ *    millimetres, bright being near, so with the clipping over that range the
+ *    tracking sees the image as it did before it took depth.
+ */
+
+class WebCameraDepthSource: public DepthSource
+{
+
+public:
+
+    static const float RANGE;   ///< depth of a black pixel, in millimetres
+
+    //! Constructor
+    WebCameraDepthSource();
+
+    //! Destructor
+    ~WebCameraDepthSource();
+
+    //! Opens the first camera at the given size
+    bool open(int width, int height);
+
+    void close();
+
+    void update();
+
+    bool isFrameNew() const {return m_frameNew;}
+
+    const ofFloatPixels& getPixels() const {return m_depth;}
+
+    unsigned long long getTimestamp() const {return m_timestamp;}
+
+    int getWidth() const {return m_width;}
+
+    int getHeight() const {return m_height;}
+
+    int getType() const {return WEB_CAMERA;}
+
+private:
+
+    ofVideoGrabber          m_vidGrabber;       ///< Video Grabber
+    ofFloatPixels           m_depth;            ///< brightness of the current frame as depth
+    int                     m_width;            ///< width of the frames in pixels
+    int                     m_height;           ///< height of the frames in pixels
+    bool                    m_frameNew;         ///< whether the last update got a new frame
+    unsigned long long      m_timestamp;        ///< time the current frame was taken, in microseconds since the epoch
+};
+
+//==========================================================================
+
+